@@ -0,0 +1,328 @@
+/**
+ * JS-level benchmarks for the N-API binding and the stream player
+ *
+ * Measures:
+ * - Per-call cost of crossing into native (isOpen() as an empty call)
+ * - read() cost vs chunk size, split into native decode time (from
+ *   getDecodeStats()) and binding overhead (the rest: call, Float32Array
+ *   and result object allocation, copy-out)
+ * - GC pressure of the per-call Float32Array allocation
+ * - FFmpegStreamPlayer feed cadence against a fake AudioWorklet that
+ *   consumes audio in real time
+ *
+ * Usage: node bench/binding-bench.js [file] [--seconds N] [--out FILE]
+ * Without a file, a synthetic 60 s FLAC is encoded to the temp directory.
+ * JSON goes to stdout (or --out); progress goes to stderr.
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { PerformanceObserver, performance } = require('perf_hooks');
+const { FFmpegDecoder, FFmpegEncoder, FFmpegStreamPlayer } = require('../lib');
+
+const CHUNK_FRAMES = [64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384];
+const SAMPLE_RATE = 44100;
+
+function parseArgs(argv) {
+    const options = { file: null, seconds: 5, out: null };
+    for (let i = 0; i < argv.length; i++) {
+        if (argv[i] === '--seconds') options.seconds = Number(argv[++i]);
+        else if (argv[i] === '--out') options.out = argv[++i];
+        else options.file = argv[i];
+    }
+    return options;
+}
+
+function log(message) {
+    process.stderr.write(message + '\n');
+}
+
+// 60 s stereo sweep + noise, so the decoder does real work
+function generateTestFile() {
+    const file = path.join(os.tmpdir(), `ffmpeg-napi-bench-${process.pid}.flac`);
+    const encoder = new FFmpegEncoder();
+    if (!encoder.open(file, { sampleRate: SAMPLE_RATE, channels: 2 })) {
+        throw new Error('Failed to create test file: ' + file);
+    }
+
+    const block = 4096;
+    const samples = new Float32Array(block * 2);
+    const total = 60 * SAMPLE_RATE;
+    let phase = 0;
+    for (let frame = 0; frame < total; frame += block) {
+        for (let i = 0; i < block; i++) {
+            const freq = 20 * Math.pow(1000, (frame + i) / total);
+            phase += 2 * Math.PI * freq / SAMPLE_RATE;
+            samples[i * 2] = 0.5 * Math.sin(phase);
+            samples[i * 2 + 1] = (Math.random() - 0.5) * 0.5;
+        }
+        encoder.write(samples);
+    }
+    encoder.close();
+    return file;
+}
+
+function openDecoder(file) {
+    const decoder = new FFmpegDecoder();
+    if (!decoder.open(file, SAMPLE_RATE)) {
+        const error = decoder.getLastError();
+        throw new Error('Failed to open ' + file + (error ? ': ' + error.message : ''));
+    }
+    return decoder;
+}
+
+function nativeSeconds(stats) {
+    return stats.demuxTime + stats.decodeTime + stats.resampleTime;
+}
+
+function benchEmptyCall(file) {
+    const decoder = openDecoder(file);
+    const calls = 1000000;
+    for (let i = 0; i < 10000; i++) decoder.isOpen();
+
+    const start = performance.now();
+    for (let i = 0; i < calls; i++) decoder.isOpen();
+    const elapsed = performance.now() - start;
+    decoder.close();
+
+    return { calls, nsPerCall: (elapsed * 1e6) / calls };
+}
+
+// Reads the whole file in one chunk size; GC events are collected while it runs
+function benchChunkSize(file, frames) {
+    const decoder = openDecoder(file);
+    const samples = frames * decoder.getChannels();
+
+    const gc = { count: 0, time: 0 };
+    const observer = new PerformanceObserver((list) => {
+        for (const entry of list.getEntries()) {
+            gc.count++;
+            gc.time += entry.duration;
+        }
+    });
+    observer.observe({ entryTypes: ['gc'] });
+
+    const memoryBefore = process.memoryUsage();
+    let calls = 0;
+    let totalFrames = 0;
+    const start = performance.now();
+    while (true) {
+        const result = decoder.read(samples);
+        if (result.samplesRead <= 0) break;
+        calls++;
+        totalFrames += result.samplesRead / decoder.getChannels();
+    }
+    const wall = (performance.now() - start) / 1000;
+    const memoryAfter = process.memoryUsage();
+    const native = nativeSeconds(decoder.getDecodeStats());
+    decoder.close();
+
+    // GC entries are delivered asynchronously; the caller awaits a tick first
+    return {
+        finish() {
+            observer.disconnect();
+            const overhead = Math.max(0, wall - native);
+            return {
+                frames,
+                calls,
+                usPerCall: (wall * 1e6) / calls,
+                nativeUsPerCall: (native * 1e6) / calls,
+                overheadUsPerCall: (overhead * 1e6) / calls,
+                overheadShare: wall > 0 ? overhead / wall : 0,
+                framesPerSecond: totalFrames / wall,
+                gcCount: gc.count,
+                gcTimeMs: gc.time,
+                heapDeltaBytes: memoryAfter.heapUsed - memoryBefore.heapUsed,
+                arrayBuffersDeltaBytes: memoryAfter.arrayBuffers - memoryBefore.arrayBuffers
+            };
+        }
+    };
+}
+
+/**
+ * Stands in for the AudioWorklet: consumes queued chunks in real time and
+ * reports position/queue depth back like ffmpeg-worklet-processor.js.
+ */
+class FakeWorkletNode {
+    constructor(context) {
+        this.context = context;
+        this.queue = [];
+        this.queuedFrames = 0;
+        this.framesPlayed = 0;
+        this.eof = false;
+        this.underruns = 0;
+        this.maxQueue = 0;
+        this.timer = null;
+        this.lastTick = 0;
+        this.lastReport = 0;
+
+        const node = this;
+        this.port = {
+            onmessage: null,
+            postMessage(data) {
+                node.receive(data);
+            }
+        };
+        context.nodes.push(this);
+    }
+
+    receive(data) {
+        if (data.type === 'chunk') {
+            this.queue.push(data.samples.length / 2);
+            this.queuedFrames += data.samples.length / 2;
+            this.maxQueue = Math.max(this.maxQueue, this.queue.length);
+        } else if (data.type === 'eof') {
+            this.eof = true;
+        } else if (data.type === 'clear') {
+            this.queue = [];
+            this.queuedFrames = 0;
+        }
+    }
+
+    connect() {
+        this.lastTick = this.lastReport = performance.now();
+        this.timer = setInterval(() => this.render(), 3);
+    }
+
+    disconnect() {
+        clearInterval(this.timer);
+        this.timer = null;
+    }
+
+    render() {
+        const now = performance.now();
+        let due = Math.round(((now - this.lastTick) / 1000) * this.context.sampleRate);
+        this.lastTick = now;
+
+        while (due > 0 && this.queue.length > 0) {
+            const take = Math.min(due, this.queue[0]);
+            this.queue[0] -= take;
+            this.queuedFrames -= take;
+            this.framesPlayed += take;
+            due -= take;
+            if (this.queue[0] === 0) this.queue.shift();
+        }
+        if (due > 0 && !this.eof) this.underruns++;
+
+        if (now - this.lastReport >= 50 && this.port.onmessage) {
+            this.lastReport = now;
+            this.port.onmessage({ data: { type: 'position', frames: this.framesPlayed, queuedChunks: this.queue.length } });
+        }
+    }
+}
+
+function createFakeContext() {
+    const context = {
+        sampleRate: SAMPLE_RATE,
+        state: 'running',
+        destination: {},
+        nodes: [],
+        audioWorklet: { addModule: async () => {} },
+        createGain: () => ({ gain: { value: 1 }, connect() {}, disconnect() {} }),
+        resume: async () => {}
+    };
+    return context;
+}
+
+async function benchFeedLoop(file, seconds) {
+    const previousNode = global.AudioWorkletNode;
+    global.AudioWorkletNode = FakeWorkletNode;
+
+    try {
+        const context = createFakeContext();
+        FFmpegStreamPlayer.setDecoder(FFmpegDecoder);
+        const player = new FFmpegStreamPlayer(context);
+        await player.open(file);
+
+        // Time each feed tick and the decode work inside it
+        const ticks = [];
+        const fills = [];
+        const fillQueue = player._fillQueue.bind(player);
+        player._fillQueue = (target) => {
+            const start = performance.now();
+            fillQueue(target);
+            fills.push(performance.now() - start);
+        };
+        const feed = player._startFeedLoop.bind(player);
+        player._startFeedLoop = () => {
+            ticks.push(performance.now());
+            feed();
+        };
+
+        await player.play();
+        await new Promise((resolve) => setTimeout(resolve, seconds * 1000));
+        player.stop();
+
+        const node = context.nodes[context.nodes.length - 1];
+        node.disconnect();
+
+        const intervals = ticks.slice(1).map((t, i) => t - ticks[i]);
+        return {
+            seconds,
+            chunkFrames: player.chunkFrames,
+            prebufferChunks: player.prebufferSize,
+            ticks: ticks.length,
+            tickIntervalMs: summarize(intervals),
+            fillMs: summarize(fills),
+            underruns: node.underruns,
+            maxQueuedChunks: node.maxQueue,
+            framesPlayed: node.framesPlayed
+        };
+    } finally {
+        global.AudioWorkletNode = previousNode;
+    }
+}
+
+function summarize(values) {
+    if (values.length === 0) return null;
+    const sorted = values.slice().sort((a, b) => a - b);
+    const at = (p) => sorted[Math.min(sorted.length - 1, Math.ceil(p * sorted.length) - 1)];
+    const mean = sorted.reduce((sum, v) => sum + v, 0) / sorted.length;
+    return { count: sorted.length, min: sorted[0], mean, p50: at(0.5), p95: at(0.95), p99: at(0.99), max: sorted[sorted.length - 1] };
+}
+
+async function main() {
+    const options = parseArgs(process.argv.slice(2));
+    const generated = !options.file;
+    const file = options.file || generateTestFile();
+
+    try {
+        log('Empty call baseline...');
+        const emptyCall = benchEmptyCall(file);
+
+        const chunks = [];
+        for (const frames of CHUNK_FRAMES) {
+            log(`read() with ${frames}-frame chunks...`);
+            const pending = benchChunkSize(file, frames);
+            await new Promise((resolve) => setImmediate(resolve));
+            chunks.push(pending.finish());
+        }
+
+        log(`Player feed loop (${options.seconds}s)...`);
+        const feedLoop = await benchFeedLoop(file, options.seconds);
+
+        // Smallest chunk where the binding costs less than native decoding
+        const crossover = chunks.find((c) => c.overheadShare < 0.5);
+
+        const result = {
+            node: process.version,
+            file: generated ? null : file,
+            emptyCall,
+            read: chunks,
+            overheadBelowHalfAtFrames: crossover ? crossover.frames : null,
+            feedLoop
+        };
+
+        const json = JSON.stringify(result, null, 2) + '\n';
+        if (options.out) fs.writeFileSync(options.out, json);
+        else process.stdout.write(json);
+    } finally {
+        if (generated) fs.rmSync(file, { force: true });
+    }
+}
+
+main().catch((err) => {
+    console.error(err);
+    process.exit(1);
+});
@@ -0,0 +1,288 @@
+/**
+ * ffmpeg_bench - Native decoder benchmarks
+ *
+ * Generates synthetic sweeps with FixtureGenerator, then measures per codec:
+ * - open() latency
+ * - decode throughput (frames/s and realtime factor)
+ * - seek latency (seek + first read), packet-level and sample-exact
+ * - read() jitter at several chunk sizes
+ *
+ * Results are written as JSON (stdout or --out) for regression tracking.
+ *
+ * Usage: ffmpeg_bench [--dir DIR] [--duration SECONDS] [--codecs wav,flac,...]
+ *                     [--iterations N] [--out FILE]
+ */
+
+#include "decoder.h"
+#include "fixtures.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchConfig {
+    std::string dir = ".";
+    double duration = 60.0;
+    int iterations = 20;
+    std::vector<std::string> codecs = {"wav", "flac", "mp3", "aac", "opus"};
+    std::string out;
+};
+
+// Summary of a set of latency samples, in milliseconds
+struct Distribution {
+    int count = 0;
+    double min = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+double nowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Distribution summarize(std::vector<double> samples) {
+    Distribution d;
+    if (samples.empty()) return d;
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        size_t index = static_cast<size_t>(std::ceil(p * samples.size())) - 1;
+        return samples[std::min(index, samples.size() - 1)];
+    };
+
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    d.count = static_cast<int>(samples.size());
+    d.mean = sum / samples.size();
+
+    double variance = 0.0;
+    for (double s : samples) variance += (s - d.mean) * (s - d.mean);
+    d.stddev = std::sqrt(variance / samples.size());
+
+    d.min = samples.front();
+    d.p50 = percentile(0.50);
+    d.p95 = percentile(0.95);
+    d.p99 = percentile(0.99);
+    d.max = samples.back();
+    return d;
+}
+
+std::string toJSON(const Distribution& d) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+             "{\"count\": %d, \"min\": %.4f, \"mean\": %.4f, \"stddev\": %.4f, \"p50\": %.4f, \"p95\": %.4f, "
+             "\"p99\": %.4f, \"max\": %.4f}",
+             d.count, d.min, d.mean, d.stddev, d.p50, d.p95, d.p99, d.max);
+    return buffer;
+}
+
+std::string quote(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+bool generateFile(const std::string& path, const std::string& codec, double duration) {
+    FixtureOptions options;
+    options.codec = codec;
+    options.sampleRate = codec == "opus" ? 48000 : 44100;
+    options.duration = duration;
+
+    FixtureGenerator generator;
+    if (!generator.run(path, options)) {
+        fprintf(stderr, "%s: %s\n", codec.c_str(), generator.getError().c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string benchOpen(const std::string& path, int iterations) {
+    std::vector<double> times;
+    for (int i = 0; i < iterations; i++) {
+        FFmpegDecoder decoder;
+        double start = nowMs();
+        bool ok = decoder.open(path.c_str());
+        double elapsed = nowMs() - start;
+        if (!ok) return "null";
+        times.push_back(elapsed);
+    }
+    return toJSON(summarize(times));
+}
+
+std::string benchThroughput(const std::string& path, bool analysis) {
+    DecoderOpenOptions options;
+    options.analysis = analysis;
+
+    FFmpegDecoder decoder;
+    if (!decoder.open(path.c_str(), 44100, 0, options)) return "null";
+
+    const int chunk = 4096 * decoder.getChannels();
+    std::vector<float> buffer(chunk);
+    int64_t samples = 0;
+
+    double start = nowMs();
+    int n;
+    while ((n = decoder.read(buffer.data(), chunk)) > 0) samples += n;
+    double seconds = (nowMs() - start) / 1000.0;
+
+    double frames = static_cast<double>(samples / decoder.getChannels());
+    double audioSeconds = frames / decoder.getSampleRate();
+    DecoderStats stats = decoder.getStats();
+
+    char json[512];
+    snprintf(json, sizeof(json),
+             "{\"frames\": %.0f, \"seconds\": %.4f, \"framesPerSecond\": %.0f, \"realtime\": %.1f, "
+             "\"demuxTime\": %.4f, \"decodeTime\": %.4f, \"resampleTime\": %.4f}",
+             frames, seconds, seconds > 0 ? frames / seconds : 0.0, seconds > 0 ? audioSeconds / seconds : 0.0,
+             stats.demuxTime, stats.decodeTime, stats.resampleTime);
+    return json;
+}
+
+std::string benchSeek(const std::string& path, int iterations, bool exact) {
+    FFmpegDecoder decoder;
+    if (!decoder.open(path.c_str())) return "null";
+
+    const double duration = decoder.getDuration();
+    std::vector<float> buffer(1024 * decoder.getChannels());
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> position(0.0, std::max(0.0, duration - 1.0));
+
+    // Seek plus the first read, which is what a scrub costs the caller
+    std::vector<double> times;
+    for (int i = 0; i < iterations * 5; i++) {
+        double target = position(rng);
+        double start = nowMs();
+        bool ok = exact ? decoder.seekExact(std::llround(target * decoder.getSampleRate())) : decoder.seek(target);
+        if (!ok) return "null";
+        decoder.read(buffer.data(), static_cast<int>(buffer.size()));
+        times.push_back(nowMs() - start);
+    }
+    return toJSON(summarize(times));
+}
+
+std::string benchJitter(const std::string& path) {
+    static const int CHUNK_FRAMES[] = {256, 1024, 4096, 16384};
+
+    std::ostringstream json;
+    json << "{";
+    bool first = true;
+    for (int frames : CHUNK_FRAMES) {
+        FFmpegDecoder decoder;
+        if (!decoder.open(path.c_str())) return "null";
+
+        std::vector<float> buffer(static_cast<size_t>(frames) * decoder.getChannels());
+        std::vector<double> times;
+        while (true) {
+            double start = nowMs();
+            int n = decoder.read(buffer.data(), static_cast<int>(buffer.size()));
+            double elapsed = nowMs() - start;
+            if (n <= 0) break;
+            times.push_back(elapsed);
+        }
+
+        json << (first ? "" : ", ") << quote(std::to_string(frames)) << ": " << toJSON(summarize(times));
+        first = false;
+    }
+    json << "}";
+    return json.str();
+}
+
+bool parseArgs(int argc, char** argv, BenchConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (arg == "--dir" && value) {
+            config.dir = value;
+        } else if (arg == "--duration" && value) {
+            config.duration = atof(value);
+        } else if (arg == "--iterations" && value) {
+            config.iterations = atoi(value);
+        } else if (arg == "--out" && value) {
+            config.out = value;
+        } else if (arg == "--codecs" && value) {
+            config.codecs.clear();
+            std::stringstream list(value);
+            std::string codec;
+            while (std::getline(list, codec, ',')) {
+                if (!codec.empty()) config.codecs.push_back(codec);
+            }
+        } else {
+            return false;
+        }
+        i++;
+    }
+    return config.duration > 0.0 && config.iterations > 0 && !config.codecs.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        fprintf(stderr, "Usage: %s [--dir DIR] [--duration SECONDS] [--codecs wav,flac,...] "
+                        "[--iterations N] [--out FILE]\n", argv[0]);
+        return 2;
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"duration\": " << config.duration << ",\n  \"iterations\": " << config.iterations
+         << ",\n  \"codecs\": {";
+
+    bool first = true;
+    for (const std::string& codec : config.codecs) {
+        std::string path = config.dir + "/bench-" + codec + "." + FixtureGenerator::extensionFor(codec);
+
+        fprintf(stderr, "%s: generating %.0fs test file\n", codec.c_str(), config.duration);
+        json << (first ? "\n" : ",\n") << "    " << quote(codec) << ": ";
+        first = false;
+
+        if (!generateFile(path, codec, config.duration)) {
+            fprintf(stderr, "%s: skipped\n", codec.c_str());
+            json << "null";
+            continue;
+        }
+
+        fprintf(stderr, "%s: benchmarking\n", codec.c_str());
+        json << "{\n      \"open\": " << benchOpen(path, config.iterations)
+             << ",\n      \"decode\": " << benchThroughput(path, false)
+             << ",\n      \"decodeAnalysis\": " << benchThroughput(path, true)
+             << ",\n      \"seek\": " << benchSeek(path, config.iterations, false)
+             << ",\n      \"seekExact\": " << benchSeek(path, config.iterations, true)
+             << ",\n      \"readJitter\": " << benchJitter(path)
+             << "\n    }";
+
+        std::remove(path.c_str());
+    }
+    json << "\n  }\n}\n";
+
+    if (config.out.empty()) {
+        fputs(json.str().c_str(), stdout);
+        return 0;
+    }
+
+    FILE* file = fopen(config.out.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "Cannot write %s\n", config.out.c_str());
+        return 1;
+    }
+    fputs(json.str().c_str(), file);
+    fclose(file);
+    return 0;
+}
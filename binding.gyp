@@ -1,10 +1,27 @@
 {
+  "variables": {
+    "enable_trace%": "false"
+  },
   "targets": [
     {
       "target_name": "ffmpeg_napi",
       "sources": [
         "src/binding.cpp",
         "src/decoder.cpp",
+        "src/waveform.cpp",
+        "src/loudness.cpp",
+        "src/spectrum.cpp",
+        "src/detector.cpp",
+        "src/encoder.cpp",
+        "src/transcode.cpp",
+        "src/remux.cpp",
+        "src/fixtures.cpp",
+        "src/thread_pool.cpp",
+        "src/batch.cpp",
+        "src/mixer.cpp",
+        "src/io.cpp",
+        "src/pool.cpp",
+        "src/trace.cpp",
         "src/utils.cpp"
       ],
       "include_dirs": [
@@ -23,6 +40,9 @@
       "cflags!": ["-fno-exceptions"],
       "cflags_cc!": ["-fno-exceptions"],
       "conditions": [
+        ["enable_trace=='true'", {
+          "defines": ["FFMPEG_NAPI_TRACE"]
+        }],
         ["OS=='win'", {
           "defines": [
             "WIN32_LEAN_AND_MEAN",
@@ -78,6 +98,75 @@
           }
         }]
       ]
+    },
+    {
+      "target_name": "ffmpeg_bench",
+      "type": "executable",
+      "sources": [
+        "bench/decoder_bench.cpp",
+        "src/decoder.cpp",
+        "src/encoder.cpp",
+        "src/fixtures.cpp",
+        "src/io.cpp",
+        "src/pool.cpp",
+        "src/trace.cpp",
+        "src/utils.cpp"
+      ],
+      "include_dirs": [
+        "src",
+        "<(module_root_dir)/deps/ffmpeg/include"
+      ],
+      "cflags!": ["-fno-exceptions"],
+      "cflags_cc!": ["-fno-exceptions"],
+      "conditions": [
+        ["enable_trace=='true'", {
+          "defines": ["FFMPEG_NAPI_TRACE"]
+        }],
+        ["OS=='win'", {
+          "defines": [
+            "WIN32_LEAN_AND_MEAN",
+            "NOMINMAX",
+            "__STDC_CONSTANT_MACROS"
+          ],
+          "msvs_settings": {
+            "VCCLCompilerTool": {
+              "ExceptionHandling": 1,
+              "AdditionalOptions": ["/std:c++17"]
+            },
+            "VCLinkerTool": {
+              "AdditionalLibraryDirectories": [
+                "<(module_root_dir)/deps/win/lib"
+              ]
+            }
+          },
+          "msvs_toolset": "v143",
+          "libraries": [
+            "-lavformat",
+            "-lavcodec",
+            "-lavutil",
+            "-lswresample"
+          ]
+        }],
+        ["OS=='linux'", {
+          "defines": [
+            "__STDC_CONSTANT_MACROS"
+          ],
+          "cflags": ["-std=c++17"],
+          "cflags_cc": ["-std=c++17"],
+          "ldflags": ["-pthread"],
+          "link_settings": {
+            "library_dirs": [
+              "<(module_root_dir)/deps/linux/lib"
+            ],
+            "libraries": [
+              "-lavformat",
+              "-lavcodec",
+              "-lavutil",
+              "-lswresample"
+            ]
+          }
+        }]
+      ]
     }
   ]
 }
@@ -18,6 +18,7 @@
  */
 
 const path = require('path');
+const { EventEmitter } = require('events');
 
 // Import player classes
 const { FFmpegStreamPlayer, FFmpegBufferedPlayer, getWorkletPath } = require('./player');
@@ -39,6 +40,22 @@ function loadAddon() {
     return nativeAddon;
 }
 
+// Adapts a Readable to the readFn(length) contract of openStream()
+function readableToReadFn(readable) {
+    const iterator = readable[Symbol.asyncIterator]();
+    let pending = null;
+    return async (length) => {
+        if (!pending || pending.length === 0) {
+            const { value, done } = await iterator.next();
+            if (done) return null;
+            pending = Buffer.isBuffer(value) ? value : Buffer.from(value);
+        }
+        const chunk = pending.subarray(0, length);
+        pending = pending.subarray(chunk.length);
+        return chunk;
+    };
+}
+
 /**
  * FFmpegDecoder class - High-level JavaScript interface
  * 
@@ -61,10 +78,111 @@ class FFmpegDecoder {
     /**
      * Open an audio file
      * @param {string} filePath - Path to audio file
+     * @param {number} [outputSampleRate] - Output sample rate (default 44100)
+     * @param {number} [threads] - Decoder threads (0 = auto)
+     * @param {Object} [options]
+     * @param {boolean} [options.mmap] - Memory-map local files instead of buffered read() (falls back silently)
+     * @param {boolean} [options.analysis] - Skip resampling; output native rate and channel count
+     * @param {boolean} [options.skipNonKey] - Analysis only: decode keyframes only where the codec supports it
+     * @param {number} [options.packetStride] - Analysis only: decode every Nth packet (approximate)
+     * @param {Object} [options.io] - Local file I/O tuning (ignored with mmap)
+     * @param {number} [options.io.bufferSize] - Bytes per read syscall, 4096..16777216 (default 32768)
+     * @param {number} [options.io.readAhead] - Bytes prefetched ahead of the read position (default 0 = kernel default)
+     * @param {number} [options.io.prefetch] - Bytes read ahead on a helper thread so reads never wait on disk (default 0 = off)
+     * @param {boolean} [options.io.direct] - Bypass the page cache (O_DIRECT / F_NOCACHE where supported)
+     * @param {string} [options.io.fadvise] - 'auto' | 'normal' | 'sequential' | 'random' | 'noreuse'
+     *                                        (default 'auto': sequential in analysis mode)
+     * @returns {boolean} true if successful
+     */
+    open(filePath, outputSampleRate, threads, options) {
+        return this._decoder.open(filePath, outputSampleRate, threads, options);
+    }
+    
+    /**
+     * Open an encoded file held in memory (downloaded blob, archive entry, ...).
+     * The data is copied once, so the Buffer may be reused right away.
+     * @param {Buffer} buffer - Complete encoded file
+     * @param {number} [outputSampleRate] - As for open()
+     * @param {number} [threads] - As for open()
+     * @param {Object} [options] - As for open()
+     * @returns {boolean} true if successful
+     */
+    openBuffer(buffer, outputSampleRate, threads, options) {
+        return this._decoder.openBuffer(buffer, outputSampleRate, threads, options);
+    }
+    
+    /**
+     * Zero-copy variant of openBuffer(): decodes straight from the Buffer's memory.
+     * The Buffer is kept alive while the decoder uses it and must not be modified
+     * until close().
+     * @param {Buffer} buffer - Complete encoded file
+     * @param {number} [outputSampleRate]
+     * @param {number} [threads]
+     * @param {Object} [options]
      * @returns {boolean} true if successful
      */
-    open(filePath) {
-        return this._decoder.open(filePath);
+    openExternalBuffer(buffer, outputSampleRate, threads, options) {
+        return this._decoder.openExternalBuffer(buffer, outputSampleRate, threads, options);
+    }
+    
+    /**
+     * Open a source whose bytes come from JS: an HTTP body, an encrypted store,
+     * a zip entry, ... Decoding runs on the libuv pool and pulls chunks ahead of
+     * the demuxer through a thread-safe bridge, so use readAsync()/seekAsync()
+     * (read()/seek() throw for stream decoders).
+     * 
+     * @example
+     * const fd = await fs.promises.open('song.flac');
+     * const { size } = await fd.stat();
+     * let pos = 0;
+     * await decoder.openStream(
+     *     async (length) => { const { buffer, bytesRead } = await fd.read(Buffer.alloc(length), 0, length, pos); pos += bytesRead; return buffer.subarray(0, bytesRead); },
+     *     async (offset) => { pos = offset; },
+     *     size);
+     * 
+     * @param {function(number): (Buffer|Uint8Array|null|Promise<Buffer|Uint8Array|null>)|Readable} source -
+     *   readFn(length) returning up to length bytes (null or empty at the end), or a Readable
+     * @param {function(number): (void|Promise<void>)} [seekFn] - Moves the read position to a byte
+     *   offset; omit for non-seekable sources
+     * @param {number} [size] - Total bytes, if known (enables seeking from the end)
+     * @param {Object} [options] - open() options plus:
+     * @param {number} [options.outputSampleRate]
+     * @param {number} [options.threads]
+     * @param {number} [options.readAhead=1048576] - Bytes requested ahead of the demuxer
+     * @param {number} [options.chunkSize=65536] - Bytes per readFn call
+     * @returns {Promise<boolean>} true if successful
+     */
+    openStream(source, seekFn, size, options = {}) {
+        const { outputSampleRate, threads, readAhead, chunkSize, ...openOptions } = options;
+        const readFn = typeof source === 'function' ? source : readableToReadFn(source);
+        
+        // Requests are served in order; the native side drops replies made stale by a seek
+        let position = 0;
+        let queue = Promise.resolve();
+        const handler = (offset, length, respond) => {
+            queue = queue.then(async () => {
+                if (offset !== position) {
+                    if (!seekFn) throw new Error('Stream is not seekable');
+                    await seekFn(offset);
+                    position = offset;
+                }
+                const chunk = await readFn(length);
+                if (chunk == null || chunk.length === 0) {
+                    respond(null);
+                    return;
+                }
+                const buffer = Buffer.isBuffer(chunk) ? chunk : Buffer.from(chunk);
+                position += buffer.length;
+                respond(buffer);
+            }).catch((err) => respond(err instanceof Error ? err : new Error(String(err))));
+        };
+        
+        return this._decoder.openStream(handler, outputSampleRate, threads, openOptions, {
+            size: size ?? -1,
+            seekable: typeof seekFn === 'function',
+            readAhead,
+            chunkSize
+        });
     }
     
     /**
@@ -83,6 +201,17 @@ class FFmpegDecoder {
         return this._decoder.seek(seconds);
     }
     
+    /**
+     * Seek to the exact output sample at `seconds`: decodes forward from the
+     * preceding packet and drops what comes before it. Decoders seeked to the
+     * same position stay sample-aligned; to move several together see seekGroup().
+     * @param {number} seconds - Position in seconds
+     * @returns {boolean} true if successful
+     */
+    seekExact(seconds) {
+        return this._decoder.seekExact(seconds);
+    }
+    
     /**
      * Read audio samples
      * @param {number} numSamples - Number of samples to read (interleaved stereo)
@@ -92,6 +221,24 @@ class FFmpegDecoder {
         return this._decoder.read(numSamples);
     }
     
+    /**
+     * Seek on the libuv thread pool (required for stream decoders)
+     * @param {number} seconds
+     * @returns {Promise<boolean>}
+     */
+    seekAsync(seconds) {
+        return this._decoder.seekAsync(seconds);
+    }
+    
+    /**
+     * Read on the libuv thread pool, off the JS thread (required for stream decoders)
+     * @param {number} numSamples - Number of samples to read (interleaved)
+     * @returns {Promise<{buffer: Float32Array, samplesRead: number}>}
+     */
+    readAsync(numSamples) {
+        return this._decoder.readAsync(numSamples);
+    }
+    
     /**
      * Get duration in seconds
      * @returns {number}
@@ -131,10 +278,775 @@ class FFmpegDecoder {
     isOpen() {
         return this._decoder.isOpen();
     }
+    
+    /**
+     * I/O counters of the open input. reads counts read syscalls for local
+     * files, callbacks for memory sources and producer requests for streams;
+     * URLs only report bytesRead.
+     * @returns {{bytesRead: number, reads: number, seeks: number, blockedTime: number}} blockedTime in seconds
+     */
+    getIOStats() {
+        return this._decoder.getIOStats();
+    }
+    
+    /**
+     * Decode counters since open(). Packets the decoder rejects as corrupt
+     * are dropped and counted instead of ending playback. Times in seconds.
+     * framePool* count decoded-frame plane buffers reused from / newly added
+     * to the decoder's frame pool, and frames the codec allocated itself.
+     * @returns {{packetsRead: number, bytesIn: number, framesDecoded: number, skippedPackets: number,
+     *   corruptPackets: number, demuxTime: number, decodeTime: number, resampleTime: number, maxReadLatency: number,
+     *   framePoolHits: number, framePoolMisses: number, framePoolFallbacks: number}}
+     */
+    getDecodeStats() {
+        return this._decoder.getDecodeStats();
+    }
+    
+    /**
+     * Most recent failure since open(), e.g. why open() returned false
+     * @returns {{code: number, phase: string, message: string}|null} code is the (negative) AVERROR;
+     *   phase is 'open' | 'streamInfo' | 'codec' | 'resampler' | 'demux' | 'decode' | 'resample' | 'convert' | 'seek'
+     */
+    getLastError() {
+        return this._decoder.getLastError();
+    }
+
+    /**
+     * Native memory held by this decoder, in bytes. The total is also
+     * reported to V8 (AdjustExternalMemory) so GC heuristics account for it.
+     * format, codec and resampler are estimates (FFmpeg has no size API).
+     * Never blocks: during an async read the last snapshot is returned.
+     * @returns {{sampleBuffer: number, io: number, source: number, format: number, coverArt: number,
+     *   codec: number, resampler: number, trace: number, total: number, reported: number}}
+     *   reported is the amount currently registered with V8
+     */
+    getMemoryUsage() {
+        return this._decoder.getMemoryUsage();
+    }
+
+    /**
+     * Timeline of recent demux ('demux', with ioBlockedUs), decode ('send',
+     * 'receive'), resample ('swr' / 'convert'), 'read' and 'seek' spans, plus
+     * traceMark() events, from a fixed-size ring (oldest events are dropped).
+     * Only recorded when the addon is built with tracing
+     * (node-gyp rebuild --enable_trace=true); see isTraceEnabled().
+     * JSON.stringify() the result and load it in chrome://tracing or Perfetto.
+     * @param {Object} [options]
+     * @param {boolean} [options.clear=false] - Empty the ring after reading
+     * @returns {{traceEvents: Object[], displayTimeUnit: string}|null} Chrome trace JSON, or null without tracing
+     */
+    getTrace(options) {
+        return this._decoder.getTrace(options);
+    }
+
+    /**
+     * Record an instant event on this decoder's trace timeline (e.g. a feed
+     * loop tick). No-op unless tracing is compiled in. Names are interned per
+     * decoder, up to 64 distinct ones; put changing values in `value`.
+     * @param {string} name
+     * @param {number} [value] - Shown as args.value
+     */
+    traceMark(name, value) {
+        this._decoder.traceMark(name, value);
+    }
+    
+    /**
+     * Generate a multi-resolution waveform overview (min/max/RMS per bucket)
+     * Decodes the file on a worker thread; the decoder position is not affected.
+     * @param {number[]} [levels] - Frames per bucket for each level, ascending, each a multiple of the previous
+     *                              (default [256, 1024, 4096, 16384, 65536])
+     * @param {Object} [options] - Decode options for the overview (see open()); defaults to this decoder's mode.
+     *                             { analysis: true, packetStride: 4 } gives a fast approximate overview.
+     * @returns {Promise<{sampleRate: number, channels: number, totalFrames: number,
+     *   levels: Array<{samplesPerBucket: number, bucketCount: number, min: Float32Array, max: Float32Array, rms: Float32Array}>}>}
+     */
+    generatePeaks(levels, options) {
+        return this._decoder.generatePeaks(levels, options);
+    }
+    
+    /**
+     * Measure EBU R128 loudness of this file on a worker thread
+     * @param {Object} [options] - Decode options (see open()); defaults to { analysis: true } (source rate)
+     * @returns {Promise<LoudnessResult>}
+     */
+    analyzeLoudness(options) {
+        return this._decoder.analyzeLoudness(options);
+    }
+    
+    /**
+     * Detect silence and onsets on a worker thread (10 ms resolution; trim points are sample-accurate)
+     * @param {Object} [options] - Detector options plus decode options (see open()); defaults to { analysis: true }
+     * @param {number} [options.silenceThreshold=-60] - dBFS below which audio counts as silence
+     * @param {number} [options.minSilenceDuration=0.5] - Shortest gap reported in silences (seconds)
+     * @param {boolean} [options.onsets=true] - Set false to skip onset detection
+     * @param {number} [options.onsetThreshold=1.0] - Onset sensitivity (lower finds more onsets)
+     * @param {number} [options.minOnsetInterval=0.05] - Seconds between reported onsets
+     * @returns {Promise<{duration: number, audioStart: number, audioEnd: number,
+     *   silences: Array<{start: number, end: number}>, onsets: Float64Array}>} Positions in seconds
+     */
+    detectSegments(options) {
+        return this._decoder.detectSegments(options);
+    }
+    
+    /**
+     * Compute a full-file spectrogram (STFT magnitude frames) on a worker thread
+     * @param {Object} [options] - Spectrum options plus decode options (see open())
+     * @param {number} [options.fftSize=2048] - Power of two
+     * @param {number} [options.hopSize=512] - Samples between frames (overlap = fftSize - hopSize)
+     * @param {string} [options.window='hann'] - 'hann' | 'hamming' | 'blackman' | 'rectangular'
+     * @param {number} [options.bands=0] - > 0: log-frequency bands instead of linear bins
+     * @param {number} [options.minFrequency=20] - Lowest band edge (bands only)
+     * @param {number} [options.maxFrequency] - Highest band edge (default Nyquist)
+     * @param {boolean} [options.decibels=true] - dB (floored at floorDb) instead of linear magnitude
+     * @returns {Promise<{frames: Float32Array, frameCount: number, frameSize: number, fftSize: number,
+     *   hopSize: number, sampleRate: number, frequencies: Float32Array}>}
+     */
+    generateSpectrogram(options) {
+        return this._decoder.generateSpectrogram(options);
+    }
+    
+    /**
+     * Serialize peaks (as returned by generatePeaks) to a compact peaks file
+     * @param {Object} peaks
+     * @returns {Buffer}
+     */
+    static serializePeaks(peaks) {
+        return loadAddon().FFmpegDecoder.serializePeaks(peaks);
+    }
+    
+    /**
+     * Parse a peaks file created by serializePeaks()
+     * @param {Buffer} buffer
+     * @returns {Object} Same shape as generatePeaks() result
+     */
+    static parsePeaks(buffer) {
+        return loadAddon().FFmpegDecoder.parsePeaks(buffer);
+    }
+}
+
+/**
+ * FFmpegEncoder class - In-process encoding (FLAC, Opus, AAC, MP3, WAV)
+ * 
+ * @example
+ * const encoder = new FFmpegEncoder();
+ * encoder.open('./output.flac', { sampleRate: 44100, channels: 2, metadata: { title: 'Track Name' } });
+ * 
+ * let chunk;
+ * while ((chunk = decoder.read(8192)).samplesRead > 0) {
+ *     encoder.write(chunk.buffer, chunk.samplesRead);
+ * }
+ * encoder.close();
+ */
+class FFmpegEncoder {
+    constructor() {
+        const addon = loadAddon();
+        this._encoder = new addon.FFmpegEncoder();
+    }
+    
+    /**
+     * Open an output file
+     * @param {string} filePath - Output path; the extension selects codec and container unless given
+     * @param {Object} [options]
+     * @param {string} [options.codec] - 'flac' | 'opus' | 'aac' | 'mp3' | 'wav' (or any FFmpeg encoder name)
+     * @param {string} [options.format] - Muxer name (e.g. 'ipod' for .m4a), default from the extension
+     * @param {number} [options.sampleRate=44100] - Output rate (snapped to a rate the codec supports)
+     * @param {number} [options.channels=2] - Output channels
+     * @param {number} [options.inputSampleRate] - Rate of the samples passed to write() (default sampleRate)
+     * @param {number} [options.inputChannels] - Channels of the samples passed to write() (default channels)
+     * @param {number} [options.bitrate] - Bits per second for lossy codecs
+     * @param {number} [options.quality] - FLAC compression 0-12, Opus complexity 0-10, MP3 VBR V0-V9
+     * @param {number} [options.bitDepth=16] - FLAC/WAV: 16 or 24
+     * @param {Object<string, string>} [options.metadata] - Container tags (title, artist, ...)
+     * @returns {boolean} Success
+     */
+    open(filePath, options) {
+        return this._encoder.open(filePath, options);
+    }
+    
+    /**
+     * Encode interleaved float32 samples
+     * @param {Float32Array} samples
+     * @param {number} [samplesCount] - Number of valid samples (default samples.length)
+     * @returns {boolean} Success
+     */
+    write(samples, samplesCount) {
+        return this._encoder.write(samples, samplesCount);
+    }
+    
+    /**
+     * Encode on a worker thread. Samples are copied on call, so the buffer can be reused
+     * immediately; chunks are encoded in call order.
+     * @param {Float32Array} samples
+     * @param {number} [samplesCount]
+     * @returns {Promise<void>}
+     */
+    writeAsync(samples, samplesCount) {
+        return this._encoder.writeAsync(samples, samplesCount);
+    }
+    
+    /**
+     * Flush pending samples and finalize the file
+     * @returns {boolean} Success
+     */
+    close() {
+        return this._encoder.close();
+    }
+    
+    /**
+     * Check if encoder is open
+     * @returns {boolean}
+     */
+    isOpen() {
+        return this._encoder.isOpen();
+    }
+    
+    /**
+     * Get the output sample rate actually used by the codec
+     * @returns {number}
+     */
+    getSampleRate() {
+        return this._encoder.getSampleRate();
+    }
+    
+    /**
+     * Get output channel count
+     * @returns {number}
+     */
+    getChannels() {
+        return this._encoder.getChannels();
+    }
+    
+    /**
+     * Get samples per encoded frame (the batching unit)
+     * @returns {number}
+     */
+    getFrameSize() {
+        return this._encoder.getFrameSize();
+    }
+    
+    /**
+     * Get the FFmpeg encoder name (e.g. 'libmp3lame')
+     * @returns {string}
+     */
+    getCodecName() {
+        return this._encoder.getCodecName();
+    }
+}
+
+/**
+ * Streaming spectrum analyzer for visualizers (feed it read() chunks)
+ * 
+ * @example
+ * const analyzer = new SpectrumAnalyzer({ sampleRate: 44100, channels: 2, fftSize: 2048, bands: 64 });
+ * const { buffer, samplesRead } = decoder.read(4096);
+ * const { frames, frameCount } = analyzer.process(buffer, samplesRead);
+ */
+class SpectrumAnalyzer {
+    /**
+     * @param {Object} options - sampleRate (required), channels (default 2) and the
+     *                           spectrum options of FFmpegDecoder#generateSpectrogram
+     */
+    constructor(options) {
+        const addon = loadAddon();
+        this._analyzer = new addon.SpectrumAnalyzer(options);
+    }
+    
+    /**
+     * Feed interleaved samples; returns every frame completed by this chunk
+     * @param {Float32Array} samples
+     * @param {number} [samplesCount] - Number of valid samples (default samples.length)
+     * @returns {{frames: Float32Array, frameCount: number}} frameCount * getFrameSize() values
+     */
+    process(samples, samplesCount) {
+        return this._analyzer.process(samples, samplesCount);
+    }
+    
+    /**
+     * Drop buffered samples (call after seeking)
+     */
+    reset() {
+        this._analyzer.reset();
+    }
+    
+    /**
+     * Center frequency in Hz of each value in a frame
+     * @returns {Float32Array}
+     */
+    getFrequencies() {
+        return this._analyzer.getFrequencies();
+    }
+    
+    /**
+     * Values per frame (bins or bands)
+     * @returns {number}
+     */
+    getFrameSize() {
+        return this._analyzer.getFrameSize();
+    }
+}
+
+/**
+ * Decodes several files in lockstep and mixes them natively (stems, multitrack
+ * previews). Tracks decode in parallel on the mixer's own threads; one
+ * readMixed() call replaces a feed loop per track.
+ *
+ * Has the read/seek/getDuration/getSampleRate/getChannels/close surface of
+ * FFmpegDecoder, so an open mixer can be passed to FFmpegStreamPlayer#open.
+ *
+ * @example
+ * const mixer = new MultiTrackDecoder({ sampleRate: 48000 });
+ * mixer.addTrack('./drums.flac');
+ * mixer.addTrack('./vocals.flac');
+ * mixer.setTrackPan(1, -0.3);
+ * const { buffer, samplesRead } = mixer.readMixed(4096);
+ */
+class MultiTrackDecoder {
+    /**
+     * @param {Object} [options]
+     * @param {number} [options.sampleRate=44100] - Output rate of every track
+     * @param {number} [options.threads=0] - Decode threads including the caller (0 = hardware threads)
+     */
+    constructor(options) {
+        const addon = loadAddon();
+        this._mixer = new addon.MultiTrackDecoder(options);
+    }
+    
+    /**
+     * Open a file as a new track, starting at the mixer's current position
+     * @param {string} filePath
+     * @param {Object} [options] - I/O options of FFmpegDecoder#open (mmap, io);
+     *                             analysis, skipNonKey and packetStride throw
+     * @returns {number} Track index, or -1 (see getLastError())
+     */
+    addTrack(filePath, options) {
+        return this._mixer.addTrack(filePath, options);
+    }
+    
+    /**
+     * Remove a track; later tracks move down one index
+     * @param {number} index
+     * @returns {boolean}
+     */
+    removeTrack(index) {
+        return this._mixer.removeTrack(index);
+    }
+    
+    /**
+     * @returns {number}
+     */
+    getTrackCount() {
+        return this._mixer.getTrackCount();
+    }
+    
+    /**
+     * @param {number} index
+     * @returns {{path: string, gain: number, pan: number, muted: boolean, solo: boolean, ended: boolean, duration: number}|null}
+     */
+    getTrackInfo(index) {
+        return this._mixer.getTrackInfo(index);
+    }
+    
+    /**
+     * Linear gain (>= 0). Changes ramp over the next read.
+     * @param {number} index
+     * @param {number} gain
+     * @returns {boolean}
+     */
+    setTrackGain(index, gain) {
+        return this._mixer.setTrackGain(index, gain);
+    }
+    
+    /**
+     * Balance from -1 (left only) to 1 (right only); 0 leaves both channels at unity
+     * @param {number} index
+     * @param {number} pan
+     * @returns {boolean}
+     */
+    setTrackPan(index, pan) {
+        return this._mixer.setTrackPan(index, pan);
+    }
+    
+    /**
+     * Muted tracks keep decoding so they stay in sync
+     * @param {number} index
+     * @param {boolean} muted
+     * @returns {boolean}
+     */
+    setTrackMute(index, muted) {
+        return this._mixer.setTrackMute(index, muted);
+    }
+    
+    /**
+     * While any track is soloed, only soloed (and unmuted) tracks are heard
+     * @param {number} index
+     * @param {boolean} solo
+     * @returns {boolean}
+     */
+    setTrackSolo(index, solo) {
+        return this._mixer.setTrackSolo(index, solo);
+    }
+    
+    /**
+     * Decode every track and mix them
+     * @param {number} numSamples - Number of samples to read (interleaved stereo)
+     * @returns {{buffer: Float32Array, samplesRead: number}} samplesRead follows the longest
+     *   track still playing; 0 once all have ended
+     */
+    readMixed(numSamples) {
+        return this._mixer.readMixed(numSamples);
+    }
+    
+    /**
+     * Same as readMixed(), for code written against FFmpegDecoder
+     * @param {number} numSamples
+     * @returns {{buffer: Float32Array, samplesRead: number}}
+     */
+    read(numSamples) {
+        return this._mixer.readMixed(numSamples);
+    }
+    
+    /**
+     * Decode every track without mixing (gain, pan, mute and solo are not applied)
+     * @param {number} numSamples - Samples per track (interleaved stereo)
+     * @returns {{buffers: Float32Array[], samplesRead: number[]}} One entry per track
+     */
+    readSeparate(numSamples) {
+        return this._mixer.readSeparate(numSamples);
+    }
+    
+    /**
+     * Seek every track to the same output sample (in parallel)
+     * @param {number} seconds
+     * @returns {boolean} False if any track failed (that track is silenced)
+     */
+    seek(seconds) {
+        return this._mixer.seek(seconds);
+    }
+    
+    /**
+     * Remove every track and release their decoders
+     */
+    close() {
+        this._mixer.close();
+    }
+    
+    /**
+     * Duration of the longest track in seconds
+     * @returns {number}
+     */
+    getDuration() {
+        return this._mixer.getDuration();
+    }
+    
+    /**
+     * Seconds read since the last seek
+     * @returns {number}
+     */
+    getPosition() {
+        return this._mixer.getPosition();
+    }
+    
+    /**
+     * @returns {number}
+     */
+    getSampleRate() {
+        return this._mixer.getSampleRate();
+    }
+    
+    /**
+     * Always 2 (interleaved stereo)
+     * @returns {number}
+     */
+    getChannels() {
+        return this._mixer.getChannels();
+    }
+    
+    /**
+     * Tracks decoded at once (pool threads plus the caller)
+     * @returns {number}
+     */
+    getThreadCount() {
+        return this._mixer.getThreadCount();
+    }
+    
+    /**
+     * Why the last addTrack() or seek() failed
+     * @returns {{code: number, phase: string, message: string}|null}
+     */
+    getLastError() {
+        return this._mixer.getLastError();
+    }
+}
+
+/**
+ * Seek several decoders to the same output sample, in parallel on worker threads
+ * (stems, A/B comparisons). No read on any of them runs until all have landed.
+ * @param {FFmpegDecoder[]} decoders - Not openStream() decoders
+ * @param {number} seconds
+ * @returns {Promise<boolean>} False if any decoder failed (see its getLastError())
+ */
+function seekGroup(decoders, seconds) {
+    return loadAddon().seekGroup(decoders.map((decoder) => decoder._decoder), seconds);
+}
+
+/**
+ * @typedef {Object} LoudnessResult
+ * @property {number} integrated - Integrated loudness in LUFS (-Infinity for silence)
+ * @property {number} range - Loudness range in LU
+ * @property {number} samplePeak - Sample peak (linear)
+ * @property {number} truePeak - True peak, 4x oversampled (linear)
+ * @property {number} replayGain - Gain in dB to reach the ReplayGain 2.0 reference (-18 LUFS)
+ * @property {number} duration - Seconds analyzed
+ */
+
+/**
+ * Measure EBU R128 loudness for a set of tracks (and the album as a whole) on a worker thread
+ * @param {string[]} filePaths
+ * @param {Object} [options] - Decode options (see FFmpegDecoder#open) plus sampleRate/threads
+ * @returns {Promise<{tracks: Array<LoudnessResult & {path: string}>, album: LoudnessResult}>}
+ */
+function analyzeLoudness(filePaths, options) {
+    return loadAddon().analyzeLoudness(filePaths, options);
+}
+
+/**
+ * @typedef {Object} JobProgress
+ * @property {number} progress - 0..1 (0 while the duration is unknown)
+ * @property {number} processed - Seconds of audio processed
+ * @property {number} duration - Seconds of audio in total
+ * @property {number} speed - Processed seconds per wall-clock second
+ */
+
+/**
+ * Transcode a file entirely on a native worker thread
+ * (demux -> decode -> gain -> resample -> encode -> mux; no samples cross into JS)
+ * 
+ * @example
+ * const job = transcode('in.flac', 'out.mp3', { bitrate: 256000, onProgress: p => console.log(p.progress) });
+ * setTimeout(() => job.cancel(), 5000);
+ * const { duration, speed } = await job;
+ * 
+ * @param {string} inputPath
+ * @param {string} outputPath - The extension selects codec and container unless given
+ * @param {Object} [options] - FFmpegEncoder#open options, where sampleRate/channels default to the source
+ * @param {number} [options.gain=0] - dB applied before encoding
+ * @param {boolean} [options.copyMetadata=true] - Copy source tags (options.metadata wins)
+ * @param {function(JobProgress): void} [options.onProgress] - Called at most every 100 ms
+ * @param {AbortSignal} [options.signal] - Cancels the job when aborted
+ * @returns {Promise<{output: string, codec: string, sampleRate: number, channels: number,
+ *   duration: number, elapsed: number, speed: number}> & {cancel: function(): void}}
+ *   Rejects with code 'ECANCELED' when cancelled; the partial output is removed
+ */
+function transcode(inputPath, outputPath, options = {}) {
+    const { onProgress, signal, ...nativeOptions } = options;
+    return jobPromise(loadAddon().transcode(inputPath, outputPath, nativeOptions, onProgress), signal);
+}
+
+/**
+ * Copy the audio stream into a new container without decoding (lossless, far
+ * faster than transcode). Trimming snaps to packet boundaries.
+ * 
+ * @example
+ * await remux('in.m4a', 'out.mka', { start: 30, end: 60, metadata: { title: 'Clip', comment: null } });
+ * 
+ * @param {string} inputPath
+ * @param {string} outputPath - The extension selects the container unless options.format is given; must not be inputPath
+ * @param {Object} [options]
+ * @param {string} [options.format] - Muxer name
+ * @param {number} [options.start=0] - Seconds
+ * @param {number} [options.end] - Seconds (default: end of file)
+ * @param {boolean} [options.copyMetadata=true] - Copy source tags
+ * @param {Object<string, string|null>} [options.metadata] - Tags to set; null removes a tag
+ * @param {Buffer|null} [options.coverArt] - Replacement picture, or null to drop it (default: keep)
+ * @param {string} [options.coverArtMimeType='image/jpeg'] - 'image/jpeg' or 'image/png'
+ * @param {function(JobProgress): void} [options.onProgress] - Called at most every 100 ms
+ * @param {AbortSignal} [options.signal] - Cancels the job when aborted
+ * @returns {Promise<{output: string, duration: number, elapsed: number, packets: number,
+ *   bytes: number}> & {cancel: function(): void}}
+ *   Rejects with code 'ECANCELED' when cancelled; the partial output is removed
+ */
+function remux(inputPath, outputPath, options = {}) {
+    const { onProgress, signal, ...nativeOptions } = options;
+    return jobPromise(loadAddon().remux(inputPath, outputPath, nativeOptions, onProgress), signal);
+}
+
+/**
+ * Encode a deterministic synthetic test file (sweep, impulses or silence) on
+ * a native worker thread. See scripts/generate-fixtures.js for the full matrix.
+ * 
+ * @param {string} outputPath - The extension selects the container
+ * @param {Object} [options]
+ * @param {string} [options.codec='flac'] - 'wav' | 'flac' | 'mp3' | 'aac' | 'opus' | 'vorbis'
+ * @param {number} [options.sampleRate=44100] - Snapped to the nearest rate the codec supports
+ * @param {number} [options.channels=2] - 1-8
+ * @param {string} [options.signal='sweep'] - 'sweep' | 'impulse' | 'silence'
+ * @param {number} [options.duration=10] - Seconds
+ * @param {number} [options.bitDepth=16] - FLAC/WAV: 16 or 24
+ * @returns {Promise<{output: string, signal: string, codec: string, sampleRate: number, channels: number,
+ *   frames: number, duration: number}>} Rejects if the codec/rate/layout combination can't be encoded
+ */
+function generateFixture(outputPath, options = {}) {
+    return loadAddon().generateFixture(outputPath, options);
+}
+
+/**
+ * Native memory of all open FFmpegDecoder objects, as reported to V8.
+ * Worker-private decoders (peaks, loudness, transcode jobs) are not included.
+ * pool describes the process-wide slab cache that recycles decoder buffers
+ * (staging buffers, prefetch rings) across open/close cycles.
+ * @returns {{total: number, decoders: number,
+ *   pool: {hits: number, misses: number, inUse: number, cached: number}}}
+ *   total, inUse and cached in bytes; decoders holding memory (each mixer track counts as one)
+ */
+function getMemoryUsage() {
+    return loadAddon().getMemoryUsage();
+}
+
+/**
+ * Free the buffers the slab pool keeps for reuse (up to 64 MB), e.g. after
+ * a library scan finishes.
+ */
+function trimMemoryPool() {
+    loadAddon().trimMemoryPool();
+}
+
+/**
+ * Whether the addon was built with decoder trace points
+ * (node-gyp rebuild --enable_trace=true). See FFmpegDecoder#getTrace().
+ * @returns {boolean}
+ */
+function isTraceEnabled() {
+    return loadAddon().traceEnabled === true;
+}
+
+// Native { promise, cancel } job -> promise with .cancel, wired to an optional AbortSignal
+function jobPromise(job, signal) {
+    if (signal) {
+        if (signal.aborted) {
+            job.cancel();
+        } else {
+            signal.addEventListener('abort', () => job.cancel(), { once: true });
+        }
+    }
+    
+    const promise = job.promise;
+    promise.cancel = job.cancel;
+    return promise;
+}
+
+/**
+ * BatchTranscoder - Runs many transcodes concurrently on a bounded native thread pool
+ * 
+ * Events: 'start', 'progress', 'done', 'failed', 'cancelled' (each with { id, ... }) and
+ * 'drain' (stats) when the queue empties.
+ * 
+ * @example
+ * const batch = new BatchTranscoder({ threadsPerJob: 1 });
+ * batch.on('progress', ({ id, progress }) => console.log(id, progress.progress));
+ * const jobs = files.map((f, i) => batch.add(f, `out/${i}.mp3`, { bitrate: 192000, priority: i === 0 ? 1 : 0 }));
+ * await Promise.allSettled(jobs);
+ * console.log(batch.getStats().throughput); // x realtime across all workers
+ */
+class BatchTranscoder extends EventEmitter {
+    /**
+     * @param {Object} [options]
+     * @param {number} [options.threadsPerJob=1] - Codec threads per job
+     * @param {number} [options.concurrency] - Worker threads (default: hardware threads / threadsPerJob)
+     */
+    constructor(options = {}) {
+        super();
+        const addon = loadAddon();
+        this._pending = new Map();
+        this._batch = new addon.BatchTranscoder(options, (event) => this._onEvent(event));
+    }
+    
+    /**
+     * Queue a transcode
+     * @param {string} inputPath
+     * @param {string} outputPath
+     * @param {Object} [options] - transcode() options plus priority (higher starts first, default 0)
+     * @returns {Promise<Object> & {id: number, cancel: function(): boolean}} Resolves with the transcode result
+     */
+    add(inputPath, outputPath, options = {}) {
+        const { priority = 0, ...nativeOptions } = options;
+        const id = this._batch.add(inputPath, outputPath, nativeOptions, priority);
+        
+        const promise = new Promise((resolve, reject) => {
+            this._pending.set(id, { resolve, reject, outputPath });
+        });
+        // Failures are also reported as events; don't require a handler on every job
+        promise.catch(() => {});
+        promise.id = id;
+        promise.cancel = () => this.cancel(id);
+        return promise;
+    }
+    
+    /**
+     * Cancel a queued or running job
+     * @param {number} id
+     * @returns {boolean} False if the job already finished
+     */
+    cancel(id) {
+        return this._batch.cancel(id);
+    }
+    
+    /**
+     * Cancel every queued and running job
+     */
+    cancelAll() {
+        this._batch.cancelAll();
+    }
+    
+    /**
+     * @returns {{queued: number, running: number, completed: number, failed: number, cancelled: number,
+     *   audioSeconds: number, elapsed: number, throughput: number}}
+     */
+    getStats() {
+        return this._batch.getStats();
+    }
+    
+    /**
+     * @returns {{workers: number, threadsPerJob: number}}
+     */
+    getConcurrency() {
+        return this._batch.getConcurrency();
+    }
+    
+    _onEvent(event) {
+        this.emit(event.type, event);
+        
+        const job = this._pending.get(event.id);
+        if (job && event.type === 'done') {
+            this._pending.delete(event.id);
+            job.resolve({ output: job.outputPath, ...event.result });
+        } else if (job && (event.type === 'failed' || event.type === 'cancelled')) {
+            this._pending.delete(event.id);
+            const err = new Error(event.error);
+            err.id = event.id;
+            if (event.type === 'cancelled') err.code = 'ECANCELED';
+            job.reject(err);
+        }
+        
+        if (this._pending.size === 0 && event.type !== 'start' && event.type !== 'progress') {
+            this.emit('drain', this.getStats());
+        }
+    }
 }
 
 module.exports = {
     FFmpegDecoder,
+    FFmpegEncoder,
+    SpectrumAnalyzer,
+    MultiTrackDecoder,
+    seekGroup,
+    analyzeLoudness,
+    transcode,
+    remux,
+    generateFixture,
+    getMemoryUsage,
+    trimMemoryPool,
+    isTraceEnabled,
+    BatchTranscoder,
     FFmpegStreamPlayer,
     FFmpegBufferedPlayer,
     getWorkletPath
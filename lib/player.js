@@ -157,7 +157,8 @@ class FFmpegStreamPlayer {
 
   /**
    * Open a file for playback (does not start playing)
-   * @param {string} filePath - Path to audio file
+   * @param {string|Object} filePath - Path to audio file, or an already open source with the
+   *   FFmpegDecoder read/seek/close surface (e.g. a MultiTrackDecoder); the player closes it on stop()
    * @param {string} [workletUrl] - URL/path to worklet (if not set in constructor)
    * @returns {Promise<{duration: number, sampleRate: number, channels: number}>}
    */
@@ -168,15 +169,20 @@ class FFmpegStreamPlayer {
 
     this.stop();
 
-    if (!FFmpegDecoder) {
-      throw new Error('FFmpegDecoder not set. Call FFmpegStreamPlayer.setDecoder(FFmpegDecoder) first.');
-    }
-
-    this.decoder = new FFmpegDecoder();
     const ctxRate = (this.audioContext && this.audioContext.sampleRate) ? (this.audioContext.sampleRate | 0) : 44100;
-    const threads = (this.threadCount | 0);
-    if (!this.decoder.open(filePath, ctxRate, threads)) {
-      throw new Error('Failed to open file with FFmpeg decoder');
+    if (filePath && typeof filePath === 'object') {
+      this.decoder = filePath;
+      filePath = null;
+    } else {
+      if (!FFmpegDecoder) {
+        throw new Error('FFmpegDecoder not set. Call FFmpegStreamPlayer.setDecoder(FFmpegDecoder) first.');
+      }
+
+      this.decoder = new FFmpegDecoder();
+      const threads = (this.threadCount | 0);
+      if (!this.decoder.open(filePath, ctxRate, threads)) {
+        throw new Error('Failed to open file with FFmpeg decoder');
+      }
     }
 
     const decRate = this.decoder.getSampleRate() | 0;
@@ -347,6 +353,11 @@ class FFmpegStreamPlayer {
   _startFeedLoop() {
     if (!this.isPlaying) return;
 
+    // Feed ticks on the decoder's trace timeline (no-op unless built with tracing)
+    if (this.decoder && this.decoder.traceMark) {
+      this.decoder.traceMark('feed', this._queueEstimate | 0);
+    }
+
     if (!this.decoderEOF) {
       // Keep queue around the configured target depth
       if ((this._queueEstimate | 0) < (this._prebufferSize | 0)) {
@@ -0,0 +1,133 @@
+/**
+ * Generate regression fixtures
+ *
+ * Encodes deterministic sweeps, impulses and silence across codecs, sample
+ * rates and channel layouts with the bundled FFmpeg, so benchmarks and
+ * accuracy checks run offline without checked-in media. Output goes to
+ * fixtures/ (gitignored) together with a manifest.json describing each file.
+ *
+ * By default every codec/rate/layout combination gets a sweep, and
+ * impulse/silence files are made at 44.1 kHz stereo. --full crosses all
+ * signals with the whole matrix.
+ *
+ * Usage: node scripts/generate-fixtures.js [--out DIR] [--duration SECONDS]
+ *          [--codecs wav,flac,...] [--rates 8000,44100,...] [--channels 1,2,...]
+ *          [--signals sweep,impulse,silence] [--full]
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { generateFixture } = require('../lib');
+
+const DEFAULTS = {
+    out: path.join(__dirname, '..', 'fixtures'),
+    duration: 10,
+    codecs: ['wav', 'flac', 'mp3', 'aac', 'opus', 'vorbis'],
+    rates: [8000, 16000, 22050, 44100, 48000, 96000, 192000],
+    channels: [1, 2, 6, 8],             // Mono, stereo, 5.1, 7.1
+    signals: ['sweep', 'impulse', 'silence'],
+    full: false
+};
+
+const EXTENSIONS = { aac: 'm4a', vorbis: 'ogg' };
+
+function parseArgs(argv) {
+    const options = { ...DEFAULTS };
+    const list = (value) => value.split(',').filter(Boolean);
+    const numbers = (value) => list(value).map(Number);
+
+    for (let i = 0; i < argv.length; i++) {
+        const arg = argv[i];
+        const value = argv[i + 1];
+        switch (arg) {
+            case '--out': options.out = path.resolve(value); i++; break;
+            case '--duration': options.duration = Number(value); i++; break;
+            case '--codecs': options.codecs = list(value); i++; break;
+            case '--rates': options.rates = numbers(value); i++; break;
+            case '--channels': options.channels = numbers(value); i++; break;
+            case '--signals': options.signals = list(value); i++; break;
+            case '--full': options.full = true; break;
+            default:
+                console.error(`Unknown argument: ${arg}`);
+                process.exit(2);
+        }
+    }
+    return options;
+}
+
+function buildMatrix(options) {
+    const specs = [];
+    for (const codec of options.codecs) {
+        for (const signal of options.signals) {
+            const fullSweep = options.full || signal === 'sweep';
+            const rates = fullSweep ? options.rates : options.rates.filter((r) => r === 44100);
+            const layouts = fullSweep ? options.channels : options.channels.filter((c) => c === 2);
+            for (const sampleRate of rates) {
+                for (const channels of layouts) {
+                    const ext = EXTENSIONS[codec] || codec;
+                    specs.push({
+                        file: `${signal}-${codec}-${sampleRate}-${channels}ch.${ext}`,
+                        codec, signal, sampleRate, channels, duration: options.duration
+                    });
+                }
+            }
+        }
+    }
+    return specs;
+}
+
+async function generate(spec, outDir) {
+    const output = path.join(outDir, spec.file);
+    const pending = generateFixture(output, spec);     // Throws right away if the addon is missing
+    try {
+        const result = await pending;
+
+        // The encoder snaps unsupported rates; such files would be mislabeled duplicates
+        if (result.sampleRate !== spec.sampleRate || result.channels !== spec.channels) {
+            fs.rmSync(output, { force: true });
+            return { ...spec, skipped: `encoder produced ${result.sampleRate} Hz / ${result.channels} ch` };
+        }
+        return { ...spec, encoder: result.codec, frames: result.frames, bytes: fs.statSync(output).size };
+    } catch (err) {
+        return { ...spec, skipped: err.message };
+    }
+}
+
+async function main() {
+    const options = parseArgs(process.argv.slice(2));
+    fs.mkdirSync(options.out, { recursive: true });
+
+    const specs = buildMatrix(options);
+    const results = new Array(specs.length);
+    let next = 0;
+    let done = 0;
+
+    // Encoders are single-threaded here; run one per core
+    const workers = Array.from({ length: Math.max(1, os.cpus().length) }, async () => {
+        while (next < specs.length) {
+            const index = next++;
+            results[index] = await generate(specs[index], options.out);
+            done++;
+            const r = results[index];
+            console.log(`[${done}/${specs.length}] ${r.skipped ? 'skip' : 'ok  '} ${r.file}${r.skipped ? ' (' + r.skipped + ')' : ''}`);
+        }
+    });
+    await Promise.all(workers);
+
+    const fixtures = results.filter((r) => !r.skipped);
+    const manifest = {
+        generator: 'scripts/generate-fixtures.js',
+        duration: options.duration,
+        fixtures,
+        skipped: results.filter((r) => r.skipped).map(({ file, skipped }) => ({ file, reason: skipped }))
+    };
+    fs.writeFileSync(path.join(options.out, 'manifest.json'), JSON.stringify(manifest, null, 2) + '\n');
+
+    console.log(`\n✅ ${fixtures.length} fixtures in ${options.out} (${manifest.skipped.length} combinations skipped)`);
+}
+
+main().catch((err) => {
+    console.error('❌', err.message);
+    process.exit(1);
+});
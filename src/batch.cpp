@@ -0,0 +1,135 @@
+#include "batch.h"
+#include <algorithm>
+
+BatchTranscoder::BatchTranscoder(int concurrency, int threads, EventCallback callback)
+    : threadsPerJob(std::max(1, threads))
+    , onEvent(callback)
+    , nextId(1)
+    , busySeconds(0.0)
+    , pool(concurrency > 0 ? concurrency : ThreadPool::defaultSize(std::max(1, threads)))
+{
+}
+
+BatchTranscoder::~BatchTranscoder() {
+    // Running jobs stop at their next chunk; the pool then joins
+    cancelAll();
+    pool.clear();
+}
+
+int BatchTranscoder::add(const std::string& inputPath, const std::string& outputPath,
+                         const TranscodeOptions& options, int priority) {
+    std::shared_ptr<JobControl> control = std::make_shared<JobControl>();
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = nextId++;
+        if (jobs.empty()) busySince = std::chrono::steady_clock::now();
+        jobs[id] = control;
+    }
+
+    pool.submit([this, id, inputPath, outputPath, options, control]() {
+        runJob(id, inputPath, outputPath, options, control);
+    }, priority);
+    return id;
+}
+
+bool BatchTranscoder::cancel(int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it == jobs.end()) return false;
+    it->second->cancel();
+    return true;
+}
+
+void BatchTranscoder::cancelAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& job : jobs) {
+        job.second->cancel();
+    }
+}
+
+BatchTranscoder::Stats BatchTranscoder::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats s = totals;
+    s.queued = static_cast<int>(jobs.size()) - totals.running;
+    s.elapsed = busySeconds;
+    if (!jobs.empty()) {
+        s.elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - busySince).count();
+    }
+    s.throughput = s.elapsed > 0.0 ? s.audioSeconds / s.elapsed : 0.0;
+    return s;
+}
+
+void BatchTranscoder::finishJob(int id) {
+    // Caller holds mutex
+    jobs.erase(id);
+    if (jobs.empty()) {
+        busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - busySince).count();
+    }
+}
+
+void BatchTranscoder::runJob(int id, const std::string& inputPath, const std::string& outputPath,
+                             TranscodeOptions options, std::shared_ptr<JobControl> control) {
+    BatchEvent event;
+    event.id = id;
+
+    if (control->isCancelled()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            totals.cancelled++;
+            finishJob(id);
+        }
+        event.type = BatchEvent::CANCELLED;
+        event.error = "Transcode cancelled";
+        if (onEvent) onEvent(event);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        totals.running++;
+    }
+    event.type = BatchEvent::STARTED;
+    if (onEvent) onEvent(event);
+
+    if (onEvent) {
+        control->setProgressCallback([this, id](const JobProgress& p) {
+            BatchEvent progress;
+            progress.type = BatchEvent::PROGRESS;
+            progress.id = id;
+            progress.progress = p;
+            onEvent(progress);
+        }, 0.25);
+    }
+
+    // Codec threads are budgeted per job; the pool size accounts for them
+    options.encoder.threads = threadsPerJob;
+    options.decoderThreads = threadsPerJob;
+
+    Transcoder transcoder;
+    bool ok = transcoder.run(inputPath, outputPath, options, control.get());
+    control->setProgressCallback(nullptr);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        totals.running--;
+        if (ok) {
+            totals.completed++;
+            totals.audioSeconds += transcoder.result().duration;
+        } else if (transcoder.wasCancelled()) {
+            totals.cancelled++;
+        } else {
+            totals.failed++;
+        }
+        finishJob(id);
+    }
+
+    if (ok) {
+        event.type = BatchEvent::COMPLETED;
+        event.result = transcoder.result();
+    } else {
+        event.type = transcoder.wasCancelled() ? BatchEvent::CANCELLED : BatchEvent::FAILED;
+        event.error = transcoder.getError();
+    }
+    if (onEvent) onEvent(event);
+}
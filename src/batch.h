@@ -0,0 +1,88 @@
+#ifndef FFMPEG_BATCH_H
+#define FFMPEG_BATCH_H
+
+#include "job.h"
+#include "thread_pool.h"
+#include "transcode.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * Lifecycle notification for one batch job
+ */
+struct BatchEvent {
+    enum Type {
+        STARTED,
+        PROGRESS,
+        COMPLETED,
+        FAILED,
+        CANCELLED
+    };
+
+    Type type = STARTED;
+    int id = 0;
+    JobProgress progress;           // PROGRESS
+    Transcoder::Result result;      // COMPLETED
+    std::string error;              // FAILED / CANCELLED
+};
+
+/**
+ * BatchTranscoder - Runs independent transcodes concurrently on a bounded pool
+ *
+ * Each job's codecs get threadsPerJob threads, and the pool defaults to
+ * hardware threads / threadsPerJob workers so intra-codec threading does not
+ * oversubscribe the machine. Events are delivered on pool threads.
+ */
+class BatchTranscoder {
+public:
+    typedef std::function<void(const BatchEvent&)> EventCallback;
+
+    struct Stats {
+        int queued = 0;
+        int running = 0;
+        int completed = 0;
+        int failed = 0;
+        int cancelled = 0;
+        double audioSeconds = 0.0;  // Encoded by completed jobs
+        double elapsed = 0.0;       // Wall-clock seconds since the batch became busy
+        double throughput = 0.0;    // audioSeconds / elapsed
+    };
+
+    // concurrency 0 = ThreadPool::defaultSize(threadsPerJob)
+    BatchTranscoder(int concurrency, int threadsPerJob, EventCallback onEvent);
+    ~BatchTranscoder();
+
+    // Returns the job id; higher priority starts first
+    int add(const std::string& inputPath, const std::string& outputPath,
+            const TranscodeOptions& options, int priority = 0);
+
+    bool cancel(int id);
+    void cancelAll();
+
+    Stats stats() const;
+    int getConcurrency() const { return pool.size(); }
+    int getThreadsPerJob() const { return threadsPerJob; }
+
+private:
+    void runJob(int id, const std::string& inputPath, const std::string& outputPath,
+                TranscodeOptions options, std::shared_ptr<JobControl> control);
+    void finishJob(int id);
+
+    int threadsPerJob;
+    EventCallback onEvent;
+
+    mutable std::mutex mutex;
+    std::map<int, std::shared_ptr<JobControl>> jobs;    // Queued or running
+    int nextId;
+    Stats totals;
+    std::chrono::steady_clock::time_point busySince;
+    double busySeconds;                                 // Accumulated from earlier busy periods
+
+    // Declared last: destroyed (joined) before the state the jobs use
+    ThreadPool pool;
+};
+
+#endif // FFMPEG_BATCH_H
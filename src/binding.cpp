@@ -1,6 +1,25 @@
 #include <napi.h>
 #include "decoder.h"
+#include "waveform.h"
+#include "loudness.h"
+#include "spectrum.h"
+#include "detector.h"
+#include "encoder.h"
+#include "transcode.h"
+#include "batch.h"
+#include "remux.h"
+#include "fixtures.h"
+#include "mixer.h"
+#include "pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <set>
 
 static Napi::Object MetadataToJS(Napi::Env env, const FFmpegDecoder::AudioMetadata& meta) {
     Napi::Object obj = Napi::Object::New(env);
@@ -39,217 +58,2992 @@ static Napi::Object MetadataToJS(Napi::Env env, const FFmpegDecoder::AudioMetada
     return obj;
 }
 
+static Napi::Object PeakDataToJS(Napi::Env env, const PeakData& peaks) {
+    Napi::Object obj = Napi::Object::New(env);
+
+    obj.Set("sampleRate", Napi::Number::New(env, peaks.sampleRate));
+    obj.Set("channels", Napi::Number::New(env, peaks.channels));
+    obj.Set("totalFrames", Napi::Number::New(env, static_cast<double>(peaks.totalFrames)));
+
+    Napi::Array levels = Napi::Array::New(env, peaks.levels.size());
+    for (size_t i = 0; i < peaks.levels.size(); i++) {
+        const PeakData::Level& level = peaks.levels[i];
+        Napi::Object levelObj = Napi::Object::New(env);
+        levelObj.Set("samplesPerBucket", Napi::Number::New(env, level.samplesPerBucket));
+        levelObj.Set("bucketCount", Napi::Number::New(env, level.bucketCount));
+
+        Napi::Float32Array minArr = Napi::Float32Array::New(env, level.min.size());
+        Napi::Float32Array maxArr = Napi::Float32Array::New(env, level.max.size());
+        Napi::Float32Array rmsArr = Napi::Float32Array::New(env, level.rms.size());
+        if (!level.min.empty()) {
+            memcpy(minArr.Data(), level.min.data(), level.min.size() * sizeof(float));
+            memcpy(maxArr.Data(), level.max.data(), level.max.size() * sizeof(float));
+            memcpy(rmsArr.Data(), level.rms.data(), level.rms.size() * sizeof(float));
+        }
+        levelObj.Set("min", minArr);
+        levelObj.Set("max", maxArr);
+        levelObj.Set("rms", rmsArr);
+
+        levels.Set(static_cast<uint32_t>(i), levelObj);
+    }
+    obj.Set("levels", levels);
+
+    return obj;
+}
+
+static bool CopyFloat32Array(Napi::Value value, size_t expected, std::vector<float>& out) {
+    if (!value.IsTypedArray()) return false;
+    Napi::TypedArray typed = value.As<Napi::TypedArray>();
+    if (typed.TypedArrayType() != napi_float32_array || typed.ElementLength() != expected) return false;
+
+    Napi::Float32Array arr = value.As<Napi::Float32Array>();
+    out.assign(arr.Data(), arr.Data() + expected);
+    return true;
+}
+
+static bool PeakDataFromJS(Napi::Env env, Napi::Value value, PeakData& peaks) {
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Expected peaks object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object obj = value.As<Napi::Object>();
+    if (!obj.Get("levels").IsArray() || !obj.Get("channels").IsNumber() || !obj.Get("sampleRate").IsNumber()) {
+        Napi::TypeError::New(env, "Peaks object must have channels, sampleRate and levels").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    peaks.channels = obj.Get("channels").As<Napi::Number>().Int32Value();
+    peaks.sampleRate = obj.Get("sampleRate").As<Napi::Number>().Int32Value();
+    peaks.totalFrames = obj.Get("totalFrames").IsNumber() ? obj.Get("totalFrames").As<Napi::Number>().Int64Value() : 0;
+    if (peaks.channels <= 0 || peaks.channels > PeakData::MAX_CHANNELS) {
+        Napi::RangeError::New(env, "channels must be between 1 and " + std::to_string(PeakData::MAX_CHANNELS)).ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Array levels = obj.Get("levels").As<Napi::Array>();
+    peaks.levels.resize(levels.Length());
+    for (uint32_t i = 0; i < levels.Length(); i++) {
+        Napi::Value levelVal = levels.Get(i);
+        if (!levelVal.IsObject()) {
+            Napi::TypeError::New(env, "Expected peak level object").ThrowAsJavaScriptException();
+            return false;
+        }
+
+        Napi::Object levelObj = levelVal.As<Napi::Object>();
+        PeakData::Level& level = peaks.levels[i];
+        level.samplesPerBucket = levelObj.Get("samplesPerBucket").As<Napi::Number>().Int32Value();
+        level.bucketCount = levelObj.Get("bucketCount").As<Napi::Number>().Int32Value();
+
+        size_t expected = static_cast<size_t>(std::max(level.bucketCount, 0)) * peaks.channels;
+        if (!CopyFloat32Array(levelObj.Get("min"), expected, level.min) ||
+            !CopyFloat32Array(levelObj.Get("max"), expected, level.max) ||
+            !CopyFloat32Array(levelObj.Get("rms"), expected, level.rms)) {
+            Napi::TypeError::New(env, "Peak level min/max/rms must be Float32Array(bucketCount * channels)").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Parses { mmap, analysis, skipNonKey, packetStride }; throws and returns false on bad input
+static bool ParseOpenOptions(Napi::Env env, Napi::Value value, DecoderOpenOptions& options) {
+    if (value.IsUndefined() || value.IsNull()) return true;
+
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Has("mmap")) options.mmap = obj.Get("mmap").ToBoolean();
+    if (obj.Has("analysis")) options.analysis = obj.Get("analysis").ToBoolean();
+    if (obj.Has("skipNonKey")) options.skipNonKey = obj.Get("skipNonKey").ToBoolean();
+    if (obj.Has("packetStride")) {
+        Napi::Value stride = obj.Get("packetStride");
+        if (!stride.IsNumber() || stride.As<Napi::Number>().Int32Value() < 1) {
+            Napi::RangeError::New(env, "packetStride must be a number >= 1").ThrowAsJavaScriptException();
+            return false;
+        }
+        options.packetStride = stride.As<Napi::Number>().Int32Value();
+    }
+
+    if (obj.Has("io")) {
+        Napi::Value ioValue = obj.Get("io");
+        if (!ioValue.IsObject()) {
+            Napi::TypeError::New(env, "io must be an object").ThrowAsJavaScriptException();
+            return false;
+        }
+        Napi::Object io = ioValue.As<Napi::Object>();
+
+        if (io.Has("bufferSize")) {
+            Napi::Value size = io.Get("bufferSize");
+            if (!size.IsNumber() || size.As<Napi::Number>().Int32Value() < 4096 ||
+                size.As<Napi::Number>().Int32Value() > (16 << 20)) {
+                Napi::RangeError::New(env, "io.bufferSize must be between 4096 and 16777216").ThrowAsJavaScriptException();
+                return false;
+            }
+            options.io.bufferSize = size.As<Napi::Number>().Int32Value();
+        }
+        if (io.Has("readAhead")) {
+            Napi::Value ahead = io.Get("readAhead");
+            if (!ahead.IsNumber() || ahead.As<Napi::Number>().Int32Value() < 0) {
+                Napi::RangeError::New(env, "io.readAhead must be a number >= 0").ThrowAsJavaScriptException();
+                return false;
+            }
+            options.io.readAhead = ahead.As<Napi::Number>().Int32Value();
+        }
+        if (io.Has("prefetch")) {
+            Napi::Value prefetch = io.Get("prefetch");
+            if (!prefetch.IsNumber() || prefetch.As<Napi::Number>().Int32Value() < 0) {
+                Napi::RangeError::New(env, "io.prefetch must be a number >= 0").ThrowAsJavaScriptException();
+                return false;
+            }
+            options.io.prefetch = prefetch.As<Napi::Number>().Int32Value();
+        }
+        if (io.Has("direct")) options.io.direct = io.Get("direct").ToBoolean();
+        if (io.Has("fadvise")) {
+            std::string advice = io.Get("fadvise").ToString().Utf8Value();
+            if (advice == "auto") options.io.advice = IOOptions::ADVICE_AUTO;
+            else if (advice == "normal") options.io.advice = IOOptions::ADVICE_NORMAL;
+            else if (advice == "sequential") options.io.advice = IOOptions::ADVICE_SEQUENTIAL;
+            else if (advice == "random") options.io.advice = IOOptions::ADVICE_RANDOM;
+            else if (advice == "noreuse") options.io.advice = IOOptions::ADVICE_NOREUSE;
+            else {
+                Napi::RangeError::New(env, "io.fadvise must be 'auto', 'normal', 'sequential', 'random' or 'noreuse'")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Keeps the JS Buffer behind a borrowed memory source alive until the worker
+// is destroyed (always on the JS thread)
+static void PinSource(Napi::ObjectReference& pin, Napi::Value buffer) {
+    if (buffer.IsObject()) pin = Napi::Persistent(buffer.As<Napi::Object>());
+}
+
+/**
+ * Builds a PeakPyramid on the libuv thread pool using a private decoder,
+ * so the caller's decoder position is left untouched.
+ */
+class PeaksWorker : public Napi::AsyncWorker {
+public:
+    PeaksWorker(Napi::Env env, const DecoderSource& source, int sampleRate, int threads,
+                const std::vector<int>& levels, const DecoderOpenOptions& options, Napi::Value sourcePin)
+        : Napi::AsyncWorker(env)
+        , deferred(Napi::Promise::Deferred::New(env))
+        , source(source)
+        , sampleRate(sampleRate)
+        , threads(threads)
+        , levels(levels)
+        , options(options) {
+        PinSource(this->sourcePin, sourcePin);
+    }
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute() override {
+        FFmpegDecoder decoder;
+        if (!decoder.open(source, sampleRate, threads, options)) {
+            SetError("Failed to open file for peak generation: " + decoder.getLastError().message);
+            return;
+        }
+
+        if (!pyramid.init(levels, decoder.getChannels(), decoder.getSampleRate()) || !pyramid.build(decoder)) {
+            DecoderError error = decoder.getLastError();
+            SetError("Peak generation failed" + (error.isSet() ? ": " + error.message : ""));
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(PeakDataToJS(Env(), pyramid.data()));
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    DecoderSource source;
+    Napi::ObjectReference sourcePin;
+    int sampleRate;
+    int threads;
+    std::vector<int> levels;
+    DecoderOpenOptions options;
+    PeakPyramid pyramid;
+};
+
+static Napi::Object LoudnessResultToJS(Napi::Env env, const LoudnessAnalyzer::Result& r) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("integrated", Napi::Number::New(env, r.integrated));
+    obj.Set("range", Napi::Number::New(env, r.range));
+    obj.Set("samplePeak", Napi::Number::New(env, r.samplePeak));
+    obj.Set("truePeak", Napi::Number::New(env, r.truePeak));
+    obj.Set("replayGain", Napi::Number::New(env, r.replayGain));
+    obj.Set("duration", Napi::Number::New(env, r.duration));
+    return obj;
+}
+
+/**
+ * Measures EBU R128 loudness for one or more files on the libuv thread pool.
+ * With several files the album value pools all gating blocks.
+ */
+class LoudnessWorker : public Napi::AsyncWorker {
+public:
+    LoudnessWorker(Napi::Env env, const std::vector<DecoderSource>& sources, int sampleRate, int threads,
+                   const DecoderOpenOptions& options, bool singleTrack, Napi::Value sourcePin = Napi::Value())
+        : Napi::AsyncWorker(env)
+        , deferred(Napi::Promise::Deferred::New(env))
+        , sources(sources)
+        , sampleRate(sampleRate)
+        , threads(threads)
+        , options(options)
+        , singleTrack(singleTrack) {
+        PinSource(this->sourcePin, sourcePin);
+    }
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute() override {
+        analyzers.resize(sources.size());
+        for (size_t i = 0; i < sources.size(); i++) {
+            // Memory sources have no path; the index identifies the track either way
+            std::string track = "track " + std::to_string(i) + (sources[i].path.empty() ? "" : " (" + sources[i].path + ")");
+
+            FFmpegDecoder decoder;
+            if (!decoder.open(sources[i], sampleRate, threads, options)) {
+                SetError("Failed to open " + track + " for loudness analysis: " + decoder.getLastError().message);
+                return;
+            }
+
+            if (!analyzers[i].init(decoder.getChannels(), decoder.getSampleRate()) || !analyzers[i].analyze(decoder)) {
+                DecoderError error = decoder.getLastError();
+                SetError("Loudness analysis failed for " + track + (error.isSet() ? ": " + error.message : ""));
+                return;
+            }
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+
+        if (singleTrack) {
+            deferred.Resolve(LoudnessResultToJS(env, analyzers[0].result()));
+            return;
+        }
+
+        std::vector<const LoudnessAnalyzer*> album;
+        Napi::Array tracks = Napi::Array::New(env, analyzers.size());
+        for (size_t i = 0; i < analyzers.size(); i++) {
+            Napi::Object track = LoudnessResultToJS(env, analyzers[i].result());
+            track.Set("path", Napi::String::New(env, sources[i].path));
+            tracks.Set(static_cast<uint32_t>(i), track);
+            album.push_back(&analyzers[i]);
+        }
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("tracks", tracks);
+        result.Set("album", LoudnessResultToJS(env, LoudnessAnalyzer::combine(album)));
+        deferred.Resolve(result);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    std::vector<DecoderSource> sources;
+    Napi::ObjectReference sourcePin;
+    int sampleRate;
+    int threads;
+    DecoderOpenOptions options;
+    bool singleTrack;
+    std::vector<LoudnessAnalyzer> analyzers;
+};
+
+// Parses { fftSize, hopSize, window, bands, minFrequency, maxFrequency, decibels, floorDb }
+static bool ParseSpectrumOptions(Napi::Env env, Napi::Value value, SpectrumAnalyzer::Options& options) {
+    if (value.IsUndefined() || value.IsNull()) return true;
+
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Get("fftSize").IsNumber()) options.fftSize = obj.Get("fftSize").As<Napi::Number>().Int32Value();
+    if (obj.Get("hopSize").IsNumber()) options.hopSize = obj.Get("hopSize").As<Napi::Number>().Int32Value();
+    if (obj.Get("bands").IsNumber()) options.bands = obj.Get("bands").As<Napi::Number>().Int32Value();
+    if (obj.Get("minFrequency").IsNumber()) options.minFrequency = obj.Get("minFrequency").As<Napi::Number>().DoubleValue();
+    if (obj.Get("maxFrequency").IsNumber()) options.maxFrequency = obj.Get("maxFrequency").As<Napi::Number>().DoubleValue();
+    if (obj.Get("floorDb").IsNumber()) options.floorDb = obj.Get("floorDb").As<Napi::Number>().FloatValue();
+    if (obj.Has("decibels")) options.decibels = obj.Get("decibels").ToBoolean();
+
+    if (obj.Get("window").IsString()) {
+        if (!SpectrumAnalyzer::parseWindow(obj.Get("window").As<Napi::String>().Utf8Value(), &options.window)) {
+            Napi::RangeError::New(env, "window must be 'hann', 'hamming', 'blackman' or 'rectangular'").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static Napi::Float32Array VectorToFloat32Array(Napi::Env env, const std::vector<float>& values) {
+    Napi::Float32Array arr = Napi::Float32Array::New(env, values.size());
+    if (!values.empty()) {
+        memcpy(arr.Data(), values.data(), values.size() * sizeof(float));
+    }
+    return arr;
+}
+
+/**
+ * Computes a full-file spectrogram on the libuv thread pool using a private decoder
+ */
+class SpectrogramWorker : public Napi::AsyncWorker {
+public:
+    SpectrogramWorker(Napi::Env env, const DecoderSource& source, int sampleRate, int threads,
+                      const DecoderOpenOptions& decodeOptions, const SpectrumAnalyzer::Options& spectrumOptions,
+                      Napi::Value sourcePin)
+        : Napi::AsyncWorker(env)
+        , deferred(Napi::Promise::Deferred::New(env))
+        , source(source)
+        , sampleRate(sampleRate)
+        , threads(threads)
+        , decodeOptions(decodeOptions)
+        , spectrumOptions(spectrumOptions)
+        , frameCount(0) {
+        PinSource(this->sourcePin, sourcePin);
+    }
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute() override {
+        FFmpegDecoder decoder;
+        if (!decoder.open(source, sampleRate, threads, decodeOptions)) {
+            SetError("Failed to open file for spectrum analysis: " + decoder.getLastError().message);
+            return;
+        }
+
+        if (!analyzer.init(spectrumOptions, decoder.getChannels(), decoder.getSampleRate())) {
+            SetError("Invalid spectrum options");
+            return;
+        }
+
+        if (!analyzer.analyze(decoder, frames, &frameCount)) {
+            DecoderError error = decoder.getLastError();
+            SetError("Spectrum analysis failed" + (error.isSet() ? ": " + error.message : ""));
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("frames", VectorToFloat32Array(env, frames));
+        result.Set("frameCount", Napi::Number::New(env, frameCount));
+        result.Set("frameSize", Napi::Number::New(env, analyzer.frameSize()));
+        result.Set("fftSize", Napi::Number::New(env, spectrumOptions.fftSize));
+        result.Set("hopSize", Napi::Number::New(env, spectrumOptions.hopSize));
+        result.Set("sampleRate", Napi::Number::New(env, analyzer.getSampleRate()));
+        result.Set("frequencies", VectorToFloat32Array(env, analyzer.frequencies()));
+        deferred.Resolve(result);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    DecoderSource source;
+    Napi::ObjectReference sourcePin;
+    int sampleRate;
+    int threads;
+    DecoderOpenOptions decodeOptions;
+    SpectrumAnalyzer::Options spectrumOptions;
+    SpectrumAnalyzer analyzer;
+    std::vector<float> frames;
+    int frameCount;
+};
+
+// Parses { silenceThreshold, minSilenceDuration, onsets, onsetThreshold, minOnsetInterval }
+static bool ParseDetectorOptions(Napi::Env env, Napi::Value value, SegmentDetector::Options& options) {
+    if (value.IsUndefined() || value.IsNull()) return true;
+
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Get("silenceThreshold").IsNumber()) options.silenceThreshold = obj.Get("silenceThreshold").As<Napi::Number>().DoubleValue();
+    if (obj.Get("minSilenceDuration").IsNumber()) options.minSilenceDuration = obj.Get("minSilenceDuration").As<Napi::Number>().DoubleValue();
+    if (obj.Get("onsetThreshold").IsNumber()) options.onsetThreshold = obj.Get("onsetThreshold").As<Napi::Number>().DoubleValue();
+    if (obj.Get("minOnsetInterval").IsNumber()) options.minOnsetInterval = obj.Get("minOnsetInterval").As<Napi::Number>().DoubleValue();
+    if (obj.Has("onsets")) options.onsets = obj.Get("onsets").ToBoolean();
+
+    if (options.minSilenceDuration < 0.0 || options.minOnsetInterval < 0.0) {
+        Napi::RangeError::New(env, "Durations must be >= 0").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Runs silence/onset detection on the libuv thread pool using a private decoder
+ */
+class DetectorWorker : public Napi::AsyncWorker {
+public:
+    DetectorWorker(Napi::Env env, const DecoderSource& source, int sampleRate, int threads,
+                   const DecoderOpenOptions& decodeOptions, const SegmentDetector::Options& detectorOptions,
+                   Napi::Value sourcePin)
+        : Napi::AsyncWorker(env)
+        , deferred(Napi::Promise::Deferred::New(env))
+        , source(source)
+        , sampleRate(sampleRate)
+        , threads(threads)
+        , decodeOptions(decodeOptions)
+        , detectorOptions(detectorOptions) {
+        PinSource(this->sourcePin, sourcePin);
+    }
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute() override {
+        FFmpegDecoder decoder;
+        if (!decoder.open(source, sampleRate, threads, decodeOptions)) {
+            SetError("Failed to open file for segment detection: " + decoder.getLastError().message);
+            return;
+        }
+
+        if (!detector.init(detectorOptions, decoder.getChannels(), decoder.getSampleRate())) {
+            SetError("Invalid detector options");
+            return;
+        }
+
+        if (!detector.analyze(decoder)) {
+            DecoderError error = decoder.getLastError();
+            SetError("Segment detection failed" + (error.isSet() ? ": " + error.message : ""));
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        SegmentDetector::Result r = detector.result();
+
+        Napi::Array silences = Napi::Array::New(env, r.silences.size());
+        for (size_t i = 0; i < r.silences.size(); i++) {
+            Napi::Object gap = Napi::Object::New(env);
+            gap.Set("start", Napi::Number::New(env, r.silences[i].start));
+            gap.Set("end", Napi::Number::New(env, r.silences[i].end));
+            silences.Set(static_cast<uint32_t>(i), gap);
+        }
+
+        Napi::Float64Array onsets = Napi::Float64Array::New(env, r.onsets.size());
+        if (!r.onsets.empty()) {
+            memcpy(onsets.Data(), r.onsets.data(), r.onsets.size() * sizeof(double));
+        }
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("duration", Napi::Number::New(env, r.duration));
+        result.Set("audioStart", Napi::Number::New(env, r.audioStart));
+        result.Set("audioEnd", Napi::Number::New(env, r.audioEnd));
+        result.Set("silences", silences);
+        result.Set("onsets", onsets);
+        deferred.Resolve(result);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    DecoderSource source;
+    Napi::ObjectReference sourcePin;
+    int sampleRate;
+    int threads;
+    DecoderOpenOptions decodeOptions;
+    SegmentDetector::Options detectorOptions;
+    SegmentDetector detector;
+};
+
+/**
+ * NAPI Wrapper for SpectrumAnalyzer (online use, e.g. per read() chunk)
+ */
+class SpectrumAnalyzerWrapper : public Napi::ObjectWrap<SpectrumAnalyzerWrapper> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    SpectrumAnalyzerWrapper(const Napi::CallbackInfo& info);
+
+private:
+    SpectrumAnalyzer analyzer;
+    std::vector<float> output;
+    bool initialized;
+
+    Napi::Value Process(const Napi::CallbackInfo& info);
+    void Reset(const Napi::CallbackInfo& info);
+    Napi::Value GetFrequencies(const Napi::CallbackInfo& info);
+    Napi::Value GetFrameSize(const Napi::CallbackInfo& info);
+};
+
+SpectrumAnalyzerWrapper::SpectrumAnalyzerWrapper(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<SpectrumAnalyzerWrapper>(info)
+    , initialized(false) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return;
+    }
+
+    Napi::Object obj = info[0].As<Napi::Object>();
+    if (!obj.Get("sampleRate").IsNumber()) {
+        Napi::TypeError::New(env, "Expected number sampleRate").ThrowAsJavaScriptException();
+        return;
+    }
+    int sampleRate = obj.Get("sampleRate").As<Napi::Number>().Int32Value();
+    int channels = obj.Get("channels").IsNumber() ? obj.Get("channels").As<Napi::Number>().Int32Value() : 2;
+
+    SpectrumAnalyzer::Options options;
+    if (!ParseSpectrumOptions(env, obj, options)) {
+        return;
+    }
+
+    if (!analyzer.init(options, channels, sampleRate)) {
+        Napi::RangeError::New(env, "Invalid spectrum options (fftSize must be a power of two, 0 < hopSize <= fftSize)").ThrowAsJavaScriptException();
+        return;
+    }
+    initialized = true;
+}
+
+Napi::Object SpectrumAnalyzerWrapper::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "SpectrumAnalyzer", {
+        InstanceMethod("process", &SpectrumAnalyzerWrapper::Process),
+        InstanceMethod("reset", &SpectrumAnalyzerWrapper::Reset),
+        InstanceMethod("getFrequencies", &SpectrumAnalyzerWrapper::GetFrequencies),
+        InstanceMethod("getFrameSize", &SpectrumAnalyzerWrapper::GetFrameSize)
+    });
+
+    exports.Set("SpectrumAnalyzer", func);
+    return exports;
+}
+
+Napi::Value SpectrumAnalyzerWrapper::Process(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsTypedArray() ||
+        info[0].As<Napi::TypedArray>().TypedArrayType() != napi_float32_array) {
+        Napi::TypeError::New(env, "Expected Float32Array samples").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Float32Array samples = info[0].As<Napi::Float32Array>();
+    size_t count = samples.ElementLength();
+    if (info.Length() >= 2 && info[1].IsNumber()) {
+        count = std::min(count, static_cast<size_t>(std::max(0, info[1].As<Napi::Number>().Int32Value())));
+    }
+
+    output.clear();
+    int frameCount = 0;
+    if (initialized) {
+        frameCount = analyzer.process(samples.Data(), static_cast<int>(count) / analyzer.getChannels(), output);
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("frames", VectorToFloat32Array(env, output));
+    result.Set("frameCount", Napi::Number::New(env, frameCount));
+    return result;
+}
+
+void SpectrumAnalyzerWrapper::Reset(const Napi::CallbackInfo& info) {
+    analyzer.reset();
+}
+
+Napi::Value SpectrumAnalyzerWrapper::GetFrequencies(const Napi::CallbackInfo& info) {
+    return VectorToFloat32Array(info.Env(), initialized ? analyzer.frequencies() : std::vector<float>());
+}
+
+Napi::Value SpectrumAnalyzerWrapper::GetFrameSize(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), initialized ? analyzer.frameSize() : 0);
+}
+
+// Parses { codec, format, sampleRate, channels, inputSampleRate, inputChannels, bitrate, quality, bitDepth, threads, metadata }.
+// validateFormat = false leaves sampleRate/channels to the caller (transcode fills them from the source).
+static bool ParseEncoderOptions(Napi::Env env, Napi::Value value, EncoderOptions& options, bool validateFormat = true) {
+    if (value.IsUndefined() || value.IsNull()) return true;
+
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Get("codec").IsString()) options.codec = obj.Get("codec").As<Napi::String>().Utf8Value();
+    if (obj.Get("format").IsString()) options.format = obj.Get("format").As<Napi::String>().Utf8Value();
+    if (obj.Get("sampleRate").IsNumber()) options.sampleRate = obj.Get("sampleRate").As<Napi::Number>().Int32Value();
+    if (obj.Get("channels").IsNumber()) options.channels = obj.Get("channels").As<Napi::Number>().Int32Value();
+    if (obj.Get("inputSampleRate").IsNumber()) options.inputSampleRate = obj.Get("inputSampleRate").As<Napi::Number>().Int32Value();
+    if (obj.Get("inputChannels").IsNumber()) options.inputChannels = obj.Get("inputChannels").As<Napi::Number>().Int32Value();
+    if (obj.Get("bitrate").IsNumber()) options.bitrate = obj.Get("bitrate").As<Napi::Number>().Int32Value();
+    if (obj.Get("quality").IsNumber()) options.quality = obj.Get("quality").As<Napi::Number>().Int32Value();
+    if (obj.Get("bitDepth").IsNumber()) options.bitDepth = obj.Get("bitDepth").As<Napi::Number>().Int32Value();
+    if (obj.Get("threads").IsNumber()) options.threads = obj.Get("threads").As<Napi::Number>().Int32Value();
+
+    if ((validateFormat && (options.sampleRate <= 0 || options.channels <= 0)) ||
+        options.inputSampleRate < 0 || options.inputChannels < 0) {
+        Napi::RangeError::New(env, "sampleRate and channels must be positive").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Value metadata = obj.Get("metadata");
+    if (metadata.IsObject()) {
+        Napi::Object tags = metadata.As<Napi::Object>();
+        Napi::Array keys = tags.GetPropertyNames();
+        for (uint32_t i = 0; i < keys.Length(); i++) {
+            std::string key = keys.Get(i).ToString().Utf8Value();
+            Napi::Value tag = tags.Get(key.c_str());
+            if (tag.IsUndefined() || tag.IsNull()) continue;
+            options.metadata[key] = tag.ToString().Utf8Value();
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Encoder shared between the wrapper and its async writes.
+ *
+ * writeAsync() copies each chunk into a queue; whichever write runs next
+ * (async worker, write(), open() or close()) takes chunks from the front
+ * under the mutex, so data reaches the encoder in call order even though
+ * libuv may run the workers in any order. Each chunk keeps its own outcome
+ * for its promise, since a later open() resets the failure state.
+ */
+struct EncoderState {
+    struct Chunk {
+        std::vector<float> samples;
+        bool written = false;
+        bool ok = false;
+    };
+
+    FFmpegEncoder encoder;
+    std::mutex mutex;
+    std::deque<std::shared_ptr<Chunk>> pending;
+    bool failed = false;
+
+    // Caller holds mutex. Stops after `until` when given.
+    bool drainPending(const Chunk* until = nullptr) {
+        while (!pending.empty()) {
+            std::shared_ptr<Chunk> chunk = pending.front();
+            pending.pop_front();
+            if (!failed && !encoder.write(chunk->samples.data(), static_cast<int>(chunk->samples.size()))) {
+                failed = true;
+            }
+            chunk->ok = !failed;
+            chunk->written = true;
+            std::vector<float>().swap(chunk->samples);
+            if (chunk.get() == until) break;
+        }
+        return !failed;
+    }
+};
+
+class EncoderWriteWorker : public Napi::AsyncWorker {
+public:
+    EncoderWriteWorker(Napi::Env env, std::shared_ptr<EncoderState> state,
+                       std::shared_ptr<EncoderState::Chunk> chunk)
+        : Napi::AsyncWorker(env)
+        , deferred(Napi::Promise::Deferred::New(env))
+        , state(state)
+        , chunk(chunk) {}
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute() override {
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        // Another write may already have flushed this chunk
+        if (!chunk->written) {
+            state->drainPending(chunk.get());
+        }
+
+        if (!chunk->ok) {
+            SetError("Encoder write failed");
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(Env().Undefined());
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    std::shared_ptr<EncoderState> state;
+    std::shared_ptr<EncoderState::Chunk> chunk;
+};
+
+/**
+ * NAPI Wrapper for FFmpegEncoder
+ */
+class EncoderWrapper : public Napi::ObjectWrap<EncoderWrapper> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    EncoderWrapper(const Napi::CallbackInfo& info);
+
+private:
+    std::shared_ptr<EncoderState> state;
+
+    // Methods
+    Napi::Value Open(const Napi::CallbackInfo& info);
+    Napi::Value Write(const Napi::CallbackInfo& info);
+    Napi::Value WriteAsync(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+    // Properties
+    Napi::Value IsOpen(const Napi::CallbackInfo& info);
+    Napi::Value GetSampleRate(const Napi::CallbackInfo& info);
+    Napi::Value GetChannels(const Napi::CallbackInfo& info);
+    Napi::Value GetFrameSize(const Napi::CallbackInfo& info);
+    Napi::Value GetCodecName(const Napi::CallbackInfo& info);
+
+    bool GetSamples(const Napi::CallbackInfo& info, Napi::Float32Array* samples, size_t* count);
+};
+
+EncoderWrapper::EncoderWrapper(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<EncoderWrapper>(info)
+    , state(std::make_shared<EncoderState>()) {}
+
+Napi::Object EncoderWrapper::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "FFmpegEncoder", {
+        InstanceMethod("open", &EncoderWrapper::Open),
+        InstanceMethod("write", &EncoderWrapper::Write),
+        InstanceMethod("writeAsync", &EncoderWrapper::WriteAsync),
+        InstanceMethod("close", &EncoderWrapper::Close),
+        InstanceMethod("isOpen", &EncoderWrapper::IsOpen),
+        InstanceMethod("getSampleRate", &EncoderWrapper::GetSampleRate),
+        InstanceMethod("getChannels", &EncoderWrapper::GetChannels),
+        InstanceMethod("getFrameSize", &EncoderWrapper::GetFrameSize),
+        InstanceMethod("getCodecName", &EncoderWrapper::GetCodecName)
+    });
+
+    exports.Set("FFmpegEncoder", func);
+    return exports;
+}
+
+Napi::Value EncoderWrapper::Open(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string file path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string filePath = info[0].As<Napi::String>().Utf8Value();
+    EncoderOptions options;
+    if (info.Length() >= 2 && !ParseEncoderOptions(env, info[1], options)) {
+        return env.Null();
+    }
+
+    // Queued writeAsync() chunks belong to the previous file
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->drainPending();
+    state->failed = false;
+    bool success = state->encoder.open(filePath.c_str(), options);
+    return Napi::Boolean::New(env, success);
+}
+
+bool EncoderWrapper::GetSamples(const Napi::CallbackInfo& info, Napi::Float32Array* samples, size_t* count) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsTypedArray() ||
+        info[0].As<Napi::TypedArray>().TypedArrayType() != napi_float32_array) {
+        Napi::TypeError::New(env, "Expected Float32Array samples").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    *samples = info[0].As<Napi::Float32Array>();
+    *count = samples->ElementLength();
+    if (info.Length() >= 2 && info[1].IsNumber()) {
+        *count = std::min(*count, static_cast<size_t>(std::max(0, info[1].As<Napi::Number>().Int32Value())));
+    }
+    return true;
+}
+
+Napi::Value EncoderWrapper::Write(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    Napi::Float32Array samples;
+    size_t count = 0;
+    if (!GetSamples(info, &samples, &count)) {
+        return env.Null();
+    }
+
+    // Waits for an in-flight writeAsync() and flushes queued chunks first
+    std::lock_guard<std::mutex> lock(state->mutex);
+    bool success = state->drainPending() && state->encoder.write(samples.Data(), static_cast<int>(count));
+    if (!success) state->failed = true;
+    return Napi::Boolean::New(env, success);
+}
+
+Napi::Value EncoderWrapper::WriteAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    Napi::Float32Array samples;
+    size_t count = 0;
+    if (!GetSamples(info, &samples, &count)) {
+        return env.Null();
+    }
+
+    // Copy now so the caller may reuse its buffer immediately
+    std::shared_ptr<EncoderState::Chunk> chunk = std::make_shared<EncoderState::Chunk>();
+    chunk->samples.assign(samples.Data(), samples.Data() + count);
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->pending.push_back(chunk);
+    }
+
+    EncoderWriteWorker* worker = new EncoderWriteWorker(env, state, chunk);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+Napi::Value EncoderWrapper::Close(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    bool drained = state->drainPending();
+    bool success = state->encoder.isOpen() && state->encoder.close() && drained;
+    return Napi::Boolean::New(info.Env(), success);
+}
+
+Napi::Value EncoderWrapper::IsOpen(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return Napi::Boolean::New(info.Env(), state->encoder.isOpen());
+}
+
+Napi::Value EncoderWrapper::GetSampleRate(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return Napi::Number::New(info.Env(), state->encoder.getSampleRate());
+}
+
+Napi::Value EncoderWrapper::GetChannels(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return Napi::Number::New(info.Env(), state->encoder.getChannels());
+}
+
+Napi::Value EncoderWrapper::GetFrameSize(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return Napi::Number::New(info.Env(), state->encoder.getFrameSize());
+}
+
+Napi::Value EncoderWrapper::GetCodecName(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return Napi::String::New(info.Env(), state->encoder.getCodecName());
+}
+
+// Parses encoder options plus { sampleRate, channels (0 = source), gain, copyMetadata }
+static bool ParseTranscodeOptions(Napi::Env env, Napi::Value value, TranscodeOptions& options) {
+    if (value.IsUndefined() || value.IsNull()) return true;
+    // sampleRate/channels of 0 keep the source values, so the encoder's positivity check doesn't apply
+    if (!ParseEncoderOptions(env, value, options.encoder, false)) return false;
+
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Get("sampleRate").IsNumber()) options.sampleRate = obj.Get("sampleRate").As<Napi::Number>().Int32Value();
+    if (obj.Get("channels").IsNumber()) options.channels = obj.Get("channels").As<Napi::Number>().Int32Value();
+    if (options.sampleRate < 0 || options.channels < 0) {
+        Napi::RangeError::New(env, "sampleRate and channels must be >= 0 (0 keeps the source value)").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (obj.Get("gain").IsNumber()) options.gain = obj.Get("gain").As<Napi::Number>().DoubleValue();
+    if (obj.Has("copyMetadata")) options.copyMetadata = obj.Get("copyMetadata").ToBoolean();
+    options.decoderThreads = options.encoder.threads;
+    return true;
+}
+
+static Napi::Object JobProgressToJS(Napi::Env env, const JobProgress& p) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("progress", Napi::Number::New(env, p.progress));
+    obj.Set("processed", Napi::Number::New(env, p.processed));
+    obj.Set("duration", Napi::Number::New(env, p.duration));
+    obj.Set("speed", Napi::Number::New(env, p.speed));
+    return obj;
+}
+
+static Napi::Object TranscodeResultToJS(Napi::Env env, const Transcoder::Result& r) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("codec", Napi::String::New(env, r.codec));
+    obj.Set("sampleRate", Napi::Number::New(env, r.sampleRate));
+    obj.Set("channels", Napi::Number::New(env, r.channels));
+    obj.Set("duration", Napi::Number::New(env, r.duration));
+    obj.Set("elapsed", Napi::Number::New(env, r.elapsed));
+    obj.Set("speed", Napi::Number::New(env, r.elapsed > 0.0 ? r.duration / r.elapsed : 0.0));
+    return obj;
+}
+
+/**
+ * Runs a Transcoder on the libuv thread pool; progress is queued back to JS
+ * and the shared JobControl lets JS cancel between chunks.
+ */
+class TranscodeWorker : public Napi::AsyncProgressQueueWorker<JobProgress> {
+public:
+    TranscodeWorker(Napi::Env env, const std::string& inputPath, const std::string& outputPath,
+                    const TranscodeOptions& options, std::shared_ptr<JobControl> control, Napi::Value onProgress)
+        : Napi::AsyncProgressQueueWorker<JobProgress>(env)
+        , deferred(Napi::Promise::Deferred::New(env))
+        , inputPath(inputPath)
+        , outputPath(outputPath)
+        , options(options)
+        , control(control) {
+        if (onProgress.IsFunction()) {
+            progressCallback = Napi::Persistent(onProgress.As<Napi::Function>());
+        }
+    }
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute(const ExecutionProgress& progress) override {
+        if (!progressCallback.IsEmpty()) {
+            control->setProgressCallback([&progress](const JobProgress& p) { progress.Send(&p, 1); });
+        }
+
+        bool ok = transcoder.run(inputPath, outputPath, options, control.get());
+        control->setProgressCallback(nullptr);
+
+        if (!ok) {
+            SetError(transcoder.getError());
+        }
+    }
+
+    void OnProgress(const JobProgress* data, size_t count) override {
+        if (progressCallback.IsEmpty() || count == 0) return;
+        progressCallback.Call({ JobProgressToJS(Env(), data[count - 1]) });
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Object result = TranscodeResultToJS(env, transcoder.result());
+        result.Set("output", Napi::String::New(env, outputPath));
+        deferred.Resolve(result);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        Napi::Object err = error.Value();
+        if (transcoder.wasCancelled()) {
+            err.Set("code", Napi::String::New(Env(), "ECANCELED"));
+        }
+        deferred.Reject(err);
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    std::string inputPath;
+    std::string outputPath;
+    TranscodeOptions options;
+    std::shared_ptr<JobControl> control;
+    Napi::FunctionReference progressCallback;
+    Transcoder transcoder;
+};
+
+// Parses { format, start, end, copyMetadata, metadata, coverArt, coverArtMimeType }
+// metadata values of null remove the tag; coverArt null removes the picture
+static bool ParseRemuxOptions(Napi::Env env, Napi::Value value, RemuxOptions& options) {
+    if (value.IsUndefined() || value.IsNull()) return true;
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Options must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Get("format").IsString()) options.format = obj.Get("format").As<Napi::String>().Utf8Value();
+    if (obj.Get("start").IsNumber()) options.start = obj.Get("start").As<Napi::Number>().DoubleValue();
+    if (obj.Get("end").IsNumber()) options.end = obj.Get("end").As<Napi::Number>().DoubleValue();
+    if (obj.Has("copyMetadata")) options.copyMetadata = obj.Get("copyMetadata").ToBoolean();
+
+    if (options.start < 0.0 || options.end < 0.0 || (options.end > 0.0 && options.end <= options.start)) {
+        Napi::RangeError::New(env, "Invalid start/end range").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    if (obj.Get("metadata").IsObject()) {
+        Napi::Object tags = obj.Get("metadata").As<Napi::Object>();
+        Napi::Array keys = tags.GetPropertyNames();
+        for (uint32_t i = 0; i < keys.Length(); i++) {
+            std::string key = keys.Get(i).ToString().Utf8Value();
+            Napi::Value tag = tags.Get(key.c_str());
+            if (tag.IsUndefined()) continue;
+            if (tag.IsNull()) {
+                options.removeTags.push_back(key);
+            } else {
+                options.metadata[key] = tag.ToString().Utf8Value();
+            }
+        }
+    }
+
+    if (obj.Has("coverArt")) {
+        Napi::Value cover = obj.Get("coverArt");
+        if (cover.IsNull()) {
+            options.coverArt = RemuxOptions::COVER_REMOVE;
+        } else if (cover.IsBuffer()) {
+            Napi::Buffer<uint8_t> data = cover.As<Napi::Buffer<uint8_t>>();
+            options.coverArt = RemuxOptions::COVER_REPLACE;
+            options.coverArtData.assign(data.Data(), data.Data() + data.Length());
+            options.coverArtMimeType = obj.Get("coverArtMimeType").IsString()
+                ? obj.Get("coverArtMimeType").As<Napi::String>().Utf8Value() : "image/jpeg";
+        } else if (!cover.IsUndefined()) {
+            Napi::TypeError::New(env, "coverArt must be a Buffer or null").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Runs a Remuxer on the libuv thread pool, same progress/cancel model as TranscodeWorker
+ */
+class RemuxWorker : public Napi::AsyncProgressQueueWorker<JobProgress> {
+public:
+    RemuxWorker(Napi::Env env, const std::string& inputPath, const std::string& outputPath,
+                const RemuxOptions& options, std::shared_ptr<JobControl> control, Napi::Value onProgress)
+        : Napi::AsyncProgressQueueWorker<JobProgress>(env)
+        , deferred(Napi::Promise::Deferred::New(env))
+        , inputPath(inputPath)
+        , outputPath(outputPath)
+        , options(options)
+        , control(control) {
+        if (onProgress.IsFunction()) {
+            progressCallback = Napi::Persistent(onProgress.As<Napi::Function>());
+        }
+    }
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute(const ExecutionProgress& progress) override {
+        if (!progressCallback.IsEmpty()) {
+            control->setProgressCallback([&progress](const JobProgress& p) { progress.Send(&p, 1); });
+        }
+
+        bool ok = remuxer.run(inputPath, outputPath, options, control.get());
+        control->setProgressCallback(nullptr);
+
+        if (!ok) {
+            SetError(remuxer.getError());
+        }
+    }
+
+    void OnProgress(const JobProgress* data, size_t count) override {
+        if (progressCallback.IsEmpty() || count == 0) return;
+        progressCallback.Call({ JobProgressToJS(Env(), data[count - 1]) });
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        const Remuxer::Result& r = remuxer.result();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("output", Napi::String::New(env, outputPath));
+        result.Set("duration", Napi::Number::New(env, r.duration));
+        result.Set("elapsed", Napi::Number::New(env, r.elapsed));
+        result.Set("packets", Napi::Number::New(env, static_cast<double>(r.packets)));
+        result.Set("bytes", Napi::Number::New(env, static_cast<double>(r.bytes)));
+        deferred.Resolve(result);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        Napi::Object err = error.Value();
+        if (remuxer.wasCancelled()) {
+            err.Set("code", Napi::String::New(Env(), "ECANCELED"));
+        }
+        deferred.Reject(err);
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    std::string inputPath;
+    std::string outputPath;
+    RemuxOptions options;
+    std::shared_ptr<JobControl> control;
+    Napi::FunctionReference progressCallback;
+    Remuxer remuxer;
+};
+
+static bool ParseFixtureOptions(Napi::Env env, Napi::Value value, FixtureOptions& options) {
+    if (value.IsUndefined() || value.IsNull()) return true;
+
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Get("codec").IsString()) options.codec = obj.Get("codec").As<Napi::String>().Utf8Value();
+    if (obj.Get("sampleRate").IsNumber()) options.sampleRate = obj.Get("sampleRate").As<Napi::Number>().Int32Value();
+    if (obj.Get("channels").IsNumber()) options.channels = obj.Get("channels").As<Napi::Number>().Int32Value();
+    if (obj.Get("duration").IsNumber()) options.duration = obj.Get("duration").As<Napi::Number>().DoubleValue();
+    if (obj.Get("bitDepth").IsNumber()) options.bitDepth = obj.Get("bitDepth").As<Napi::Number>().Int32Value();
+
+    if (obj.Has("signal")) {
+        std::string signal = obj.Get("signal").ToString().Utf8Value();
+        if (signal == "sweep") options.signal = FixtureOptions::SIGNAL_SWEEP;
+        else if (signal == "impulse") options.signal = FixtureOptions::SIGNAL_IMPULSE;
+        else if (signal == "silence") options.signal = FixtureOptions::SIGNAL_SILENCE;
+        else {
+            Napi::RangeError::New(env, "signal must be 'sweep', 'impulse' or 'silence'").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    if (options.sampleRate <= 0 || options.channels < 1 || options.channels > 8 || options.duration <= 0.0) {
+        Napi::RangeError::New(env, "Expected sampleRate > 0, channels 1-8 and duration > 0").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Encodes one synthetic fixture on the libuv thread pool
+ */
+class FixtureWorker : public Napi::AsyncWorker {
+public:
+    FixtureWorker(Napi::Env env, const std::string& outputPath, const FixtureOptions& options)
+        : Napi::AsyncWorker(env)
+        , deferred(Napi::Promise::Deferred::New(env))
+        , outputPath(outputPath)
+        , options(options) {}
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute() override {
+        if (!generator.run(outputPath, options)) {
+            SetError(generator.getError());
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        const FixtureGenerator::Result& result = generator.result();
+
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("output", Napi::String::New(env, outputPath));
+        obj.Set("signal", Napi::String::New(env, FixtureGenerator::signalName(options.signal)));
+        obj.Set("codec", Napi::String::New(env, result.codec));
+        obj.Set("sampleRate", Napi::Number::New(env, result.sampleRate));
+        obj.Set("channels", Napi::Number::New(env, result.channels));
+        obj.Set("frames", Napi::Number::New(env, static_cast<double>(result.frames)));
+        obj.Set("duration", Napi::Number::New(env, options.duration));
+        deferred.Resolve(obj);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    std::string outputPath;
+    FixtureOptions options;
+    FixtureGenerator generator;
+};
+
+static Napi::Object BatchEventToJS(Napi::Env env, const BatchEvent& event) {
+    static const char* TYPE_NAMES[] = { "start", "progress", "done", "failed", "cancelled" };
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("type", Napi::String::New(env, TYPE_NAMES[event.type]));
+    obj.Set("id", Napi::Number::New(env, event.id));
+
+    switch (event.type) {
+        case BatchEvent::PROGRESS:
+            obj.Set("progress", JobProgressToJS(env, event.progress));
+            break;
+        case BatchEvent::COMPLETED:
+            obj.Set("result", TranscodeResultToJS(env, event.result));
+            break;
+        case BatchEvent::FAILED:
+        case BatchEvent::CANCELLED:
+            obj.Set("error", Napi::String::New(env, event.error));
+            break;
+        default:
+            break;
+    }
+    return obj;
+}
+
+/**
+ * NAPI Wrapper for BatchTranscoder
+ *
+ * Pool threads post events through a ThreadSafeFunction. While jobs are
+ * outstanding the wrapper holds a reference on itself and on the TSFN, so
+ * neither the object nor the event loop goes away mid-batch.
+ */
+class BatchTranscoderWrapper : public Napi::ObjectWrap<BatchTranscoderWrapper> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    BatchTranscoderWrapper(const Napi::CallbackInfo& info);
+    ~BatchTranscoderWrapper();
+
+private:
+    std::unique_ptr<BatchTranscoder> batch;
+    Napi::ThreadSafeFunction tsfn;
+    int outstanding;                // Jobs whose final event has not reached JS yet
+
+    // Methods
+    Napi::Value Add(const Napi::CallbackInfo& info);
+    Napi::Value Cancel(const Napi::CallbackInfo& info);
+    void CancelAll(const Napi::CallbackInfo& info);
+    Napi::Value GetStats(const Napi::CallbackInfo& info);
+    Napi::Value GetConcurrency(const Napi::CallbackInfo& info);
+
+    void Deliver(Napi::Env env, Napi::Function callback, BatchEvent* event);
+};
+
+BatchTranscoderWrapper::BatchTranscoderWrapper(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<BatchTranscoderWrapper>(info)
+    , outstanding(0) {
+    Napi::Env env = info.Env();
+
+    int concurrency = 0;
+    int threadsPerJob = 1;
+    if (info.Length() >= 1 && info[0].IsObject()) {
+        Napi::Object obj = info[0].As<Napi::Object>();
+        if (obj.Get("concurrency").IsNumber()) concurrency = obj.Get("concurrency").As<Napi::Number>().Int32Value();
+        if (obj.Get("threadsPerJob").IsNumber()) threadsPerJob = obj.Get("threadsPerJob").As<Napi::Number>().Int32Value();
+    }
+
+    if (info.Length() < 2 || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected event callback").ThrowAsJavaScriptException();
+        return;
+    }
+
+    tsfn = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "BatchTranscoder", 0, 1);
+    tsfn.Unref(env);
+
+    batch = std::make_unique<BatchTranscoder>(concurrency, threadsPerJob, [this](const BatchEvent& event) {
+        tsfn.NonBlockingCall(new BatchEvent(event), [this](Napi::Env env, Napi::Function callback, BatchEvent* data) {
+            Deliver(env, callback, data);
+        });
+    });
+}
+
+BatchTranscoderWrapper::~BatchTranscoderWrapper() {
+    // Only reachable with no outstanding jobs; joins the pool before releasing the TSFN
+    batch.reset();
+    tsfn.Release();
+}
+
+Napi::Object BatchTranscoderWrapper::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "BatchTranscoder", {
+        InstanceMethod("add", &BatchTranscoderWrapper::Add),
+        InstanceMethod("cancel", &BatchTranscoderWrapper::Cancel),
+        InstanceMethod("cancelAll", &BatchTranscoderWrapper::CancelAll),
+        InstanceMethod("getStats", &BatchTranscoderWrapper::GetStats),
+        InstanceMethod("getConcurrency", &BatchTranscoderWrapper::GetConcurrency)
+    });
+
+    exports.Set("BatchTranscoder", func);
+    return exports;
+}
+
+void BatchTranscoderWrapper::Deliver(Napi::Env env, Napi::Function callback, BatchEvent* event) {
+    Napi::Object obj = BatchEventToJS(env, *event);
+    bool final = event->type == BatchEvent::COMPLETED || event->type == BatchEvent::FAILED ||
+                 event->type == BatchEvent::CANCELLED;
+    delete event;
+
+    if (final && --outstanding == 0) {
+        tsfn.Unref(env);
+        Unref();
+    }
+
+    callback.Call({ obj });
+}
+
+Napi::Value BatchTranscoderWrapper::Add(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected input and output file paths").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    TranscodeOptions options;
+    if (info.Length() >= 3 && !ParseTranscodeOptions(env, info[2], options)) {
+        return env.Null();
+    }
+    int priority = (info.Length() >= 4 && info[3].IsNumber()) ? info[3].As<Napi::Number>().Int32Value() : 0;
+
+    if (outstanding++ == 0) {
+        tsfn.Ref(env);
+        Ref();
+    }
+
+    int id = batch->add(info[0].As<Napi::String>().Utf8Value(), info[1].As<Napi::String>().Utf8Value(),
+                        options, priority);
+    return Napi::Number::New(env, id);
+}
+
+Napi::Value BatchTranscoderWrapper::Cancel(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected job id").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return Napi::Boolean::New(env, batch->cancel(info[0].As<Napi::Number>().Int32Value()));
+}
+
+void BatchTranscoderWrapper::CancelAll(const Napi::CallbackInfo& info) {
+    batch->cancelAll();
+}
+
+Napi::Value BatchTranscoderWrapper::GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    BatchTranscoder::Stats s = batch->stats();
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("queued", Napi::Number::New(env, s.queued));
+    obj.Set("running", Napi::Number::New(env, s.running));
+    obj.Set("completed", Napi::Number::New(env, s.completed));
+    obj.Set("failed", Napi::Number::New(env, s.failed));
+    obj.Set("cancelled", Napi::Number::New(env, s.cancelled));
+    obj.Set("audioSeconds", Napi::Number::New(env, s.audioSeconds));
+    obj.Set("elapsed", Napi::Number::New(env, s.elapsed));
+    obj.Set("throughput", Napi::Number::New(env, s.throughput));
+    return obj;
+}
+
+Napi::Value BatchTranscoderWrapper::GetConcurrency(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("workers", Napi::Number::New(env, batch->getConcurrency()));
+    obj.Set("threadsPerJob", Napi::Number::New(env, batch->getThreadsPerJob()));
+    return obj;
+}
+
+/**
+ * NAPI Wrapper for FFmpegDecoder
+ * Provides JavaScript interface to the native FFmpeg decoder
+ */
+// Native memory of all FFmpegDecoder objects, as reported to V8
+static const int64_t MEMORY_ACCOUNT_STEP = 64 * 1024;
+static std::atomic<int64_t> decoderMemoryTotal{0};
+static std::atomic<int> decoderMemoryCount{0};     // Decoders holding memory
+
+// Reports one decoder's native memory to V8; *accounted is what it last reported.
+// total = 0 releases it.
+static void ReportDecoderMemory(Napi::Env env, int64_t total, int64_t* accounted) {
+    int64_t delta = total - *accounted;
+
+    // The swr delay and packet sizes drift on every read; only report real changes
+    if (delta == 0) return;
+    if (total != 0 && *accounted != 0 && std::llabs(delta) < MEMORY_ACCOUNT_STEP) return;
+
+    Napi::MemoryManagement::AdjustExternalMemory(env, delta);
+    decoderMemoryTotal.fetch_add(delta, std::memory_order_relaxed);
+    if (*accounted == 0) decoderMemoryCount.fetch_add(1, std::memory_order_relaxed);
+    else if (total == 0) decoderMemoryCount.fetch_sub(1, std::memory_order_relaxed);
+    *accounted = total;
+}
+
+class DecoderWrapper : public Napi::ObjectWrap<DecoderWrapper> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    DecoderWrapper(const Napi::CallbackInfo& info);
+    ~DecoderWrapper();
+
+    // Shared with the async open/read/seek workers
+    FFmpegDecoder* getDecoder() { return decoder.get(); }
+    std::mutex& getDecodeMutex() { return decodeMutex; }
+    void releaseStream(const StreamReader* only = nullptr);
+    void accountMemory(Napi::Env env);      // Caller holds decodeMutex
+
+private:
+    void closeSource();
+
+    std::unique_ptr<FFmpegDecoder> decoder;
+    std::mutex decodeMutex;                 // Serializes decoder access with async workers
+    Napi::ObjectReference sourceBuffer;     // Pins the Buffer behind openExternalBuffer()
+
+    // openStream(): JS producer bridge
+    std::shared_ptr<StreamReader> streamReader;
+    Napi::ThreadSafeFunction streamRequests;
+
+    // traceMark() names, kept alive for the trace ring; capped so dynamic names can't grow it forever
+    static const size_t MAX_TRACE_NAMES = 64;
+    std::set<std::string> traceNames;
+
+    // Native memory last reported to V8 (AdjustExternalMemory)
+    DecoderMemory memory;
+    int64_t accountedMemory = 0;
+
+    Napi::Value SourcePin(Napi::Env env) const { return sourceBuffer.IsEmpty() ? env.Undefined() : sourceBuffer.Value(); }
+    bool CheckReopenable(Napi::Env env) const;
+    bool CheckSync(Napi::Env env) const;
+    
+    // Methods
+    Napi::Value Open(const Napi::CallbackInfo& info);
+    Napi::Value OpenBuffer(const Napi::CallbackInfo& info);
+    Napi::Value OpenExternalBuffer(const Napi::CallbackInfo& info);
+    Napi::Value OpenStream(const Napi::CallbackInfo& info);
+    void Close(const Napi::CallbackInfo& info);
+    Napi::Value Seek(const Napi::CallbackInfo& info);
+    Napi::Value SeekExact(const Napi::CallbackInfo& info);
+    Napi::Value Read(const Napi::CallbackInfo& info);
+    Napi::Value SeekAsync(const Napi::CallbackInfo& info);
+    Napi::Value ReadAsync(const Napi::CallbackInfo& info);
+    Napi::Value GetMetadata(const Napi::CallbackInfo& info);
+    Napi::Value GeneratePeaks(const Napi::CallbackInfo& info);
+    Napi::Value AnalyzeLoudness(const Napi::CallbackInfo& info);
+    Napi::Value GenerateSpectrogram(const Napi::CallbackInfo& info);
+    Napi::Value DetectSegments(const Napi::CallbackInfo& info);
+    
+    // Properties
+    Napi::Value GetDuration(const Napi::CallbackInfo& info);
+    Napi::Value GetSampleRate(const Napi::CallbackInfo& info);
+    Napi::Value GetChannels(const Napi::CallbackInfo& info);
+    Napi::Value GetTotalSamples(const Napi::CallbackInfo& info);
+    Napi::Value IsOpen(const Napi::CallbackInfo& info);
+    Napi::Value GetIOStats(const Napi::CallbackInfo& info);
+    Napi::Value GetDecodeStats(const Napi::CallbackInfo& info);
+    Napi::Value GetLastError(const Napi::CallbackInfo& info);
+    Napi::Value GetTrace(const Napi::CallbackInfo& info);
+    Napi::Value GetMemoryUsage(const Napi::CallbackInfo& info);
+    Napi::Value TraceMark(const Napi::CallbackInfo& info);
+    static Napi::Value GetFileMetadata(const Napi::CallbackInfo& info);
+    static Napi::Value SerializePeaks(const Napi::CallbackInfo& info);
+    static Napi::Value ParsePeaks(const Napi::CallbackInfo& info);
+};
+
+DecoderWrapper::DecoderWrapper(const Napi::CallbackInfo& info) 
+    : Napi::ObjectWrap<DecoderWrapper>(info) {
+    decoder = std::make_unique<FFmpegDecoder>();
+#if FFMPEG_TRACE_ENABLED
+    decoder->enableTrace();
+#endif
+}
+
+DecoderWrapper::~DecoderWrapper() {
+    // Decoder will auto-close in destructor; workers pin this object, so none are running
+    releaseStream();
+    ReportDecoderMemory(Env(), 0, &accountedMemory);
+}
+
+void DecoderWrapper::accountMemory(Napi::Env env) {
+    memory = decoder->getMemoryUsage();
+    ReportDecoderMemory(env, memory.total(), &accountedMemory);
+}
+
+// only: release just if that stream is still the current one
+void DecoderWrapper::releaseStream(const StreamReader* only) {
+    if (!streamReader || (only && only != streamReader.get())) return;
+    streamReader->abort();
+    streamRequests.Release();
+    streamReader.reset();
+}
+
+bool DecoderWrapper::CheckReopenable(Napi::Env env) const {
+    if (!decoder->isOpen()) {
+        Napi::Error::New(env, "Decoder is not open").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (decoder->getSource().isStream()) {
+        Napi::Error::New(env, "Not supported for stream sources").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+// Stream sources block on JS for data, so decoding them on the JS thread would deadlock
+bool DecoderWrapper::CheckSync(Napi::Env env) const {
+    if (streamReader) {
+        Napi::Error::New(env, "Stream decoders only support readAsync()/seekAsync()").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+Napi::Object DecoderWrapper::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "FFmpegDecoder", {
+        InstanceMethod("open", &DecoderWrapper::Open),
+        InstanceMethod("openBuffer", &DecoderWrapper::OpenBuffer),
+        InstanceMethod("openExternalBuffer", &DecoderWrapper::OpenExternalBuffer),
+        InstanceMethod("openStream", &DecoderWrapper::OpenStream),
+        InstanceMethod("close", &DecoderWrapper::Close),
+        InstanceMethod("seek", &DecoderWrapper::Seek),
+        InstanceMethod("seekExact", &DecoderWrapper::SeekExact),
+        InstanceMethod("read", &DecoderWrapper::Read),
+        InstanceMethod("seekAsync", &DecoderWrapper::SeekAsync),
+        InstanceMethod("readAsync", &DecoderWrapper::ReadAsync),
+        InstanceMethod("getMetadata", &DecoderWrapper::GetMetadata),
+        InstanceMethod("getDuration", &DecoderWrapper::GetDuration),
+        InstanceMethod("getSampleRate", &DecoderWrapper::GetSampleRate),
+        InstanceMethod("getChannels", &DecoderWrapper::GetChannels),
+        InstanceMethod("getTotalSamples", &DecoderWrapper::GetTotalSamples),
+        InstanceMethod("isOpen", &DecoderWrapper::IsOpen),
+        InstanceMethod("getIOStats", &DecoderWrapper::GetIOStats),
+        InstanceMethod("getDecodeStats", &DecoderWrapper::GetDecodeStats),
+        InstanceMethod("getLastError", &DecoderWrapper::GetLastError),
+        InstanceMethod("getTrace", &DecoderWrapper::GetTrace),
+        InstanceMethod("getMemoryUsage", &DecoderWrapper::GetMemoryUsage),
+        InstanceMethod("traceMark", &DecoderWrapper::TraceMark),
+        InstanceMethod("generatePeaks", &DecoderWrapper::GeneratePeaks),
+        InstanceMethod("analyzeLoudness", &DecoderWrapper::AnalyzeLoudness),
+        InstanceMethod("generateSpectrogram", &DecoderWrapper::GenerateSpectrogram),
+        InstanceMethod("detectSegments", &DecoderWrapper::DetectSegments),
+        StaticMethod("getFileMetadata", &DecoderWrapper::GetFileMetadata),
+        StaticMethod("serializePeaks", &DecoderWrapper::SerializePeaks),
+        StaticMethod("parsePeaks", &DecoderWrapper::ParsePeaks)
+    });
+    
+    Napi::FunctionReference* constructor = new Napi::FunctionReference();
+    *constructor = Napi::Persistent(func);
+    env.SetInstanceData(constructor);
+    
+    exports.Set("FFmpegDecoder", func);
+    return exports;
+}
+
+/**
+ * Runs one decoder operation (open/read/seek) on the libuv thread pool under
+ * the wrapper's decode mutex, so stream sources can block on JS for data.
+ * The wrapper object is pinned until the worker completes.
+ */
+class DecoderTaskWorker : public Napi::AsyncWorker {
+public:
+    enum Task {
+        OPEN,
+        READ,
+        SEEK
+    };
+
+    DecoderTaskWorker(Napi::Env env, Napi::Object owner, DecoderWrapper* wrapper, Task task)
+        : Napi::AsyncWorker(env)
+        , deferred(Napi::Promise::Deferred::New(env))
+        , owner(Napi::Persistent(owner))
+        , wrapper(wrapper)
+        , task(task)
+        , sampleRate(0)
+        , threads(0)
+        , numSamples(0)
+        , samplesRead(0)
+        , seconds(0.0)
+        , success(false) {}
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+    void SetOpen(const DecoderSource& input, int rate, int threadCount, const DecoderOpenOptions& openOptions) {
+        source = input;
+        sampleRate = rate;
+        threads = threadCount;
+        options = openOptions;
+    }
+    void SetRead(int count) { numSamples = count; }
+    void SetSeek(double position) { seconds = position; }
+
+protected:
+    void Execute() override {
+        std::lock_guard<std::mutex> lock(wrapper->getDecodeMutex());
+        FFmpegDecoder* decoder = wrapper->getDecoder();
+
+        switch (task) {
+            case OPEN:
+                success = decoder->open(source, sampleRate, threads, options);
+                break;
+            case READ:
+                samples.resize(numSamples);
+                samplesRead = decoder->read(samples.data(), numSamples);
+                success = samplesRead > 0;
+                source = decoder->getSource();
+                break;
+            case SEEK:
+                success = decoder->seek(seconds);
+                source = decoder->getSource();
+                break;
+        }
+
+        // Surface errors thrown by the JS producer instead of a bare EOF
+        if (!success && source.isStream() && !source.stream->getError().empty()) {
+            SetError("Stream read failed: " + source.stream->getError());
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+
+        // Skipped if another operation is already queued; the next one accounts
+        {
+            std::unique_lock<std::mutex> lock(wrapper->getDecodeMutex(), std::try_to_lock);
+            if (lock.owns_lock()) wrapper->accountMemory(env);
+        }
+
+        if (task == READ) {
+            Napi::Float32Array buffer = Napi::Float32Array::New(env, numSamples);
+            if (samplesRead > 0) {
+                memcpy(buffer.Data(), samples.data(), samplesRead * sizeof(float));
+            }
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("buffer", buffer);
+            result.Set("samplesRead", Napi::Number::New(env, samplesRead));
+            deferred.Resolve(result);
+            return;
+        }
+
+        if (task == OPEN && !success) {
+            wrapper->releaseStream(source.stream.get());
+        }
+        deferred.Resolve(Napi::Boolean::New(env, success));
+    }
+
+    void OnError(const Napi::Error& error) override {
+        if (task == OPEN) {
+            wrapper->releaseStream(source.stream.get());
+        }
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    Napi::ObjectReference owner;
+    DecoderWrapper* wrapper;
+    Task task;
+
+    DecoderSource source;
+    int sampleRate;
+    int threads;
+    DecoderOpenOptions options;
+
+    int numSamples;
+    int samplesRead;
+    std::vector<float> samples;
+    double seconds;
+    bool success;
+};
+
+// One producer request, delivered to the JS handler through a ThreadSafeFunction
+struct StreamRequest {
+    std::weak_ptr<StreamReader> reader;
+    uint64_t generation;
+    int64_t offset;
+    int length;
+};
+
+// Calls handler(offset, length, respond); respond(Buffer | null | Error) feeds the reader
+static void DeliverStreamRequest(Napi::Env env, Napi::Function handler, StreamRequest* request) {
+    std::weak_ptr<StreamReader> reader = request->reader;
+    uint64_t generation = request->generation;
+    double offset = static_cast<double>(request->offset);
+    int length = request->length;
+    delete request;
+
+    Napi::Function respond = Napi::Function::New(env, [reader, generation](const Napi::CallbackInfo& info) {
+        std::shared_ptr<StreamReader> stream = reader.lock();
+        if (!stream) return;        // Decoder closed or reopened meanwhile
+
+        Napi::Value chunk = info.Length() >= 1 ? info[0] : info.Env().Undefined();
+        if (chunk.IsBuffer()) {
+            Napi::Buffer<uint8_t> data = chunk.As<Napi::Buffer<uint8_t>>();
+            stream->supply(generation, data.Data(), data.Length());
+        } else if (chunk.IsUndefined() || chunk.IsNull()) {
+            stream->supply(generation, nullptr, 0);
+        } else {
+            std::string message = "Stream read failed";
+            if (chunk.IsObject() && chunk.As<Napi::Object>().Get("message").IsString()) {
+                message = chunk.As<Napi::Object>().Get("message").As<Napi::String>().Utf8Value();
+            }
+            stream->fail(generation, message);
+        }
+    }, "respond");
+
+    handler.Call({ Napi::Number::New(env, offset), Napi::Number::New(env, length), respond });
+}
+
+// Parses { size, seekable, readAhead, chunkSize }
+static bool ParseStreamOptions(Napi::Env env, Napi::Value value, StreamReader::Options& options) {
+    if (value.IsUndefined() || value.IsNull()) return true;
+
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Expected stream options object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Get("size").IsNumber()) options.size = obj.Get("size").As<Napi::Number>().Int64Value();
+    if (obj.Get("readAhead").IsNumber()) options.readAhead = obj.Get("readAhead").As<Napi::Number>().Int32Value();
+    if (obj.Get("chunkSize").IsNumber()) options.chunkSize = obj.Get("chunkSize").As<Napi::Number>().Int32Value();
+    if (obj.Has("seekable")) options.seekable = obj.Get("seekable").ToBoolean();
+
+    if (options.readAhead <= 0 || options.chunkSize <= 0) {
+        Napi::RangeError::New(env, "readAhead and chunkSize must be > 0").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+// Parses the (outputSampleRate?, threads?, options?) arguments shared by the open* methods
+static bool ParseOpenArgs(const Napi::CallbackInfo& info, int* outSampleRate, int* threads, DecoderOpenOptions& options) {
+    Napi::Env env = info.Env();
+
+    *outSampleRate = 0;
+    if (info.Length() >= 2 && !info[1].IsUndefined() && !info[1].IsNull()) {
+        if (!info[1].IsNumber()) {
+            Napi::TypeError::New(env, "Expected number outputSampleRate").ThrowAsJavaScriptException();
+            return false;
+        }
+        *outSampleRate = info[1].As<Napi::Number>().Int32Value();
+        if (*outSampleRate <= 0) {
+            Napi::RangeError::New(env, "outputSampleRate must be > 0").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    *threads = 0;
+    if (info.Length() >= 3 && !info[2].IsUndefined() && !info[2].IsNull()) {
+        if (!info[2].IsNumber()) {
+            Napi::TypeError::New(env, "Expected number threads").ThrowAsJavaScriptException();
+            return false;
+        }
+        *threads = info[2].As<Napi::Number>().Int32Value();
+        if (*threads < 0) {
+            Napi::RangeError::New(env, "threads must be >= 0").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    return info.Length() < 4 || ParseOpenOptions(env, info[3], options);
+}
+
+Napi::Value DecoderWrapper::Open(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string filePath").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string filePath = info[0].As<Napi::String>().Utf8Value();
+
+    int outSampleRate = 0;
+    int threads = 0;
+    DecoderOpenOptions options;
+    if (!ParseOpenArgs(info, &outSampleRate, &threads, options)) {
+        return env.Null();
+    }
+
+    closeSource();
+    std::lock_guard<std::mutex> lock(decodeMutex);
+    bool success = decoder->open(filePath.c_str(), outSampleRate, threads, options);
+    accountMemory(env);
+    
+    return Napi::Boolean::New(env, success);
+}
+
+Napi::Value DecoderWrapper::OpenBuffer(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBuffer()) {
+        Napi::TypeError::New(env, "Expected Buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int outSampleRate = 0;
+    int threads = 0;
+    DecoderOpenOptions options;
+    if (!ParseOpenArgs(info, &outSampleRate, &threads, options)) {
+        return env.Null();
+    }
+
+    // Copied once; the caller may reuse the Buffer immediately
+    Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+    DecoderSource source;
+    source.memory = MemoryBlock::copy(buffer.Data(), buffer.Length());
+
+    closeSource();
+    std::lock_guard<std::mutex> lock(decodeMutex);
+    bool success = decoder->open(source, outSampleRate, threads, options);
+    accountMemory(env);
+
+    return Napi::Boolean::New(env, success);
+}
+
+Napi::Value DecoderWrapper::OpenExternalBuffer(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBuffer()) {
+        Napi::TypeError::New(env, "Expected Buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int outSampleRate = 0;
+    int threads = 0;
+    DecoderOpenOptions options;
+    if (!ParseOpenArgs(info, &outSampleRate, &threads, options)) {
+        return env.Null();
+    }
+
+    // Zero-copy: reads the Buffer's memory in place, pinned for as long as the
+    // decoder (or a worker started from it) uses it
+    Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+    DecoderSource source;
+    source.memory = MemoryBlock::borrow(buffer.Data(), buffer.Length());
+
+    closeSource();
+    std::lock_guard<std::mutex> lock(decodeMutex);
+    bool success = decoder->open(source, outSampleRate, threads, options);
+    accountMemory(env);
+    if (success) {
+        sourceBuffer = Napi::Persistent(buffer.As<Napi::Object>());
+    }
+
+    return Napi::Boolean::New(env, success);
+}
+
+// openStream(handler, outputSampleRate?, threads?, options?, streamOptions?) -> Promise<boolean>
+Napi::Value DecoderWrapper::OpenStream(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Expected request handler function").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int outSampleRate = 0;
+    int threads = 0;
+    DecoderOpenOptions options;
+    if (!ParseOpenArgs(info, &outSampleRate, &threads, options)) {
+        return env.Null();
+    }
+
+    StreamReader::Options streamOptions;
+    if (info.Length() >= 5 && !ParseStreamOptions(env, info[4], streamOptions)) {
+        return env.Null();
+    }
+
+    closeSource();
+
+    // Idle streams must not keep the process alive; pending workers do
+    Napi::ThreadSafeFunction tsfn = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(),
+                                                                  "FFmpegDecoder.openStream", 0, 1);
+    tsfn.Unref(env);
+
+    std::shared_ptr<std::weak_ptr<StreamReader>> self = std::make_shared<std::weak_ptr<StreamReader>>();
+    streamReader = std::make_shared<StreamReader>([tsfn, self](uint64_t generation, int64_t offset, int length) {
+        StreamRequest* request = new StreamRequest{ *self, generation, offset, length };
+        if (tsfn.NonBlockingCall(request, DeliverStreamRequest) != napi_ok) {
+            delete request;
+        }
+    }, streamOptions);
+    *self = streamReader;
+    streamRequests = tsfn;
+
+    DecoderSource source;
+    source.stream = streamReader;
+
+    DecoderTaskWorker* worker = new DecoderTaskWorker(env, info.This().As<Napi::Object>(), this, DecoderTaskWorker::OPEN);
+    worker->SetOpen(source, outSampleRate, threads, options);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+void DecoderWrapper::closeSource() {
+    // Unblock a worker waiting on stream data before taking the lock
+    if (streamReader) streamReader->abort();
+    {
+        std::lock_guard<std::mutex> lock(decodeMutex);
+        decoder->close();
+        accountMemory(Env());
+    }
+    releaseStream();
+    sourceBuffer.Reset();
+}
+
+void DecoderWrapper::Close(const Napi::CallbackInfo& info) {
+    closeSource();
+}
+
+Napi::Value DecoderWrapper::Seek(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected number seconds").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (!CheckSync(env)) {
+        return env.Null();
+    }
+
+    double seconds = info[0].As<Napi::Number>().DoubleValue();
+    std::lock_guard<std::mutex> lock(decodeMutex);
+    bool success = decoder->seek(seconds);
+    accountMemory(env);
+    
+    return Napi::Boolean::New(env, success);
+}
+
+Napi::Value DecoderWrapper::SeekExact(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected number seconds").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (!CheckSync(env)) {
+        return env.Null();
+    }
+
+    double seconds = info[0].As<Napi::Number>().DoubleValue();
+    std::lock_guard<std::mutex> lock(decodeMutex);
+    bool success = decoder->seekExact(llround(seconds * decoder->getSampleRate()));
+    accountMemory(env);
+
+    return Napi::Boolean::New(env, success);
+}
+
+Napi::Value DecoderWrapper::Read(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected number numSamples").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (!CheckSync(env)) {
+        return env.Null();
+    }
+
+    int numSamples = info[0].As<Napi::Number>().Int32Value();
+    
+    // Create Float32Array for output
+    Napi::Float32Array buffer = Napi::Float32Array::New(env, numSamples);
+    
+    // Read samples
+    std::lock_guard<std::mutex> lock(decodeMutex);
+    int samplesRead = decoder->read(buffer.Data(), numSamples);
+    accountMemory(env);
+    
+    // Return object with buffer and actual count
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("buffer", buffer);
+    result.Set("samplesRead", Napi::Number::New(env, samplesRead));
+    
+    return result;
+}
+
+Napi::Value DecoderWrapper::SeekAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected number seconds").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    DecoderTaskWorker* worker = new DecoderTaskWorker(env, info.This().As<Napi::Object>(), this, DecoderTaskWorker::SEEK);
+    worker->SetSeek(info[0].As<Napi::Number>().DoubleValue());
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+Napi::Value DecoderWrapper::ReadAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected number numSamples").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int numSamples = info[0].As<Napi::Number>().Int32Value();
+    if (numSamples <= 0) {
+        Napi::RangeError::New(env, "numSamples must be > 0").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    DecoderTaskWorker* worker = new DecoderTaskWorker(env, info.This().As<Napi::Object>(), this, DecoderTaskWorker::READ);
+    worker->SetRead(numSamples);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+Napi::Value DecoderWrapper::GetDuration(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    return Napi::Number::New(env, decoder->getDuration());
+}
+
+Napi::Value DecoderWrapper::GetSampleRate(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    return Napi::Number::New(env, decoder->getSampleRate());
+}
+
+Napi::Value DecoderWrapper::GetChannels(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    return Napi::Number::New(env, decoder->getChannels());
+}
+
+Napi::Value DecoderWrapper::GetTotalSamples(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    return Napi::Number::New(env, static_cast<double>(decoder->getTotalSamples()));
+}
+
+Napi::Value DecoderWrapper::IsOpen(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    return Napi::Boolean::New(env, decoder->isOpen());
+}
+
+Napi::Value DecoderWrapper::GetIOStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    // A stream read may be parked waiting on this thread, so never take
+    // decodeMutex for one; its counters are lock-free
+    IOStats stats;
+    if (streamReader) {
+        stats = streamReader->getStats();
+    } else {
+        std::lock_guard<std::mutex> lock(decodeMutex);
+        stats = decoder->getIOStats();
+    }
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("bytesRead", Napi::Number::New(env, static_cast<double>(stats.bytesRead)));
+    obj.Set("reads", Napi::Number::New(env, static_cast<double>(stats.reads)));
+    obj.Set("seeks", Napi::Number::New(env, static_cast<double>(stats.seeks)));
+    obj.Set("blockedTime", Napi::Number::New(env, stats.blockedTime));
+    return obj;
+}
+
+// Lock-free like getIOStats(), so it can be polled during async reads
+Napi::Value DecoderWrapper::GetDecodeStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    DecoderStats stats = decoder->getStats();
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("packetsRead", Napi::Number::New(env, static_cast<double>(stats.packetsRead)));
+    obj.Set("bytesIn", Napi::Number::New(env, static_cast<double>(stats.bytesIn)));
+    obj.Set("framesDecoded", Napi::Number::New(env, static_cast<double>(stats.framesDecoded)));
+    obj.Set("skippedPackets", Napi::Number::New(env, static_cast<double>(stats.skippedPackets)));
+    obj.Set("corruptPackets", Napi::Number::New(env, static_cast<double>(stats.corruptPackets)));
+    obj.Set("demuxTime", Napi::Number::New(env, stats.demuxTime));
+    obj.Set("decodeTime", Napi::Number::New(env, stats.decodeTime));
+    obj.Set("resampleTime", Napi::Number::New(env, stats.resampleTime));
+    obj.Set("maxReadLatency", Napi::Number::New(env, stats.maxReadLatency));
+    obj.Set("framePoolHits", Napi::Number::New(env, static_cast<double>(stats.framePoolHits)));
+    obj.Set("framePoolMisses", Napi::Number::New(env, static_cast<double>(stats.framePoolMisses)));
+    obj.Set("framePoolFallbacks", Napi::Number::New(env, static_cast<double>(stats.framePoolFallbacks)));
+    return obj;
+}
+
+Napi::Value DecoderWrapper::GetLastError(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    DecoderError error = decoder->getLastError();
+    if (!error.isSet()) return env.Null();
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("code", Napi::Number::New(env, error.code));
+    obj.Set("phase", Napi::String::New(env, errorPhaseName(error.phase)));
+    obj.Set("message", Napi::String::New(env, error.message));
+    return obj;
+}
+
+static Napi::Object DecoderMemoryToJS(Napi::Env env, const DecoderMemory& memory) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("sampleBuffer", Napi::Number::New(env, static_cast<double>(memory.sampleBuffer)));
+    obj.Set("io", Napi::Number::New(env, static_cast<double>(memory.io)));
+    obj.Set("source", Napi::Number::New(env, static_cast<double>(memory.source)));
+    obj.Set("format", Napi::Number::New(env, static_cast<double>(memory.format)));
+    obj.Set("coverArt", Napi::Number::New(env, static_cast<double>(memory.coverArt)));
+    obj.Set("codec", Napi::Number::New(env, static_cast<double>(memory.codec)));
+    obj.Set("resampler", Napi::Number::New(env, static_cast<double>(memory.resampler)));
+    obj.Set("trace", Napi::Number::New(env, static_cast<double>(memory.trace)));
+    obj.Set("total", Napi::Number::New(env, static_cast<double>(memory.total())));
+    return obj;
+}
+
+// Never blocks: while an async operation holds the decoder, the last snapshot is returned
+Napi::Value DecoderWrapper::GetMemoryUsage(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::unique_lock<std::mutex> lock(decodeMutex, std::try_to_lock);
+    if (lock.owns_lock()) accountMemory(env);
+
+    Napi::Object obj = DecoderMemoryToJS(env, memory);
+    obj.Set("reported", Napi::Number::New(env, static_cast<double>(accountedMemory)));
+    return obj;
+}
+
+// Chrome trace event format (chrome://tracing, Perfetto): times in microseconds
+Napi::Value DecoderWrapper::GetTrace(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    TraceRing* trace = decoder->getTrace();
+    if (!trace) return env.Null();
+
+    bool clear = false;
+    if (info.Length() > 0 && info[0].IsObject()) {
+        Napi::Value value = info[0].As<Napi::Object>().Get("clear");
+        clear = value.IsBoolean() && value.As<Napi::Boolean>().Value();
+    }
+
+    std::vector<TraceEvent> events = trace->snapshot();
+    if (clear) trace->clear();
+
+    Napi::Array list = Napi::Array::New(env, events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        const TraceEvent& event = events[i];
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("name", Napi::String::New(env, event.name ? event.name : ""));
+        obj.Set("cat", Napi::String::New(env, "ffmpeg"));
+        obj.Set("pid", Napi::Number::New(env, 1));
+        obj.Set("tid", Napi::Number::New(env, event.thread));
+        obj.Set("ts", Napi::Number::New(env, static_cast<double>(event.start) / 1000.0));
+        if (event.duration >= 0) {
+            obj.Set("ph", Napi::String::New(env, "X"));
+            obj.Set("dur", Napi::Number::New(env, static_cast<double>(event.duration) / 1000.0));
+        } else {
+            obj.Set("ph", Napi::String::New(env, "i"));
+            obj.Set("s", Napi::String::New(env, "t"));
+        }
+        if (event.argName) {
+            Napi::Object args = Napi::Object::New(env);
+            args.Set(event.argName, Napi::Number::New(env, static_cast<double>(event.arg)));
+            obj.Set("args", args);
+        }
+        list.Set(static_cast<uint32_t>(i), obj);
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("traceEvents", list);
+    result.Set("displayTimeUnit", Napi::String::New(env, "ms"));
+    return result;
+}
+
+// Instant event from JS (e.g. the player's feed loop), on the decoder's timeline
+Napi::Value DecoderWrapper::TraceMark(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string name").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    TraceRing* trace = decoder->getTrace();
+    if (!trace) return env.Undefined();
+
+    std::string key = info[0].As<Napi::String>().Utf8Value();
+    std::set<std::string>::iterator interned = traceNames.find(key);
+    if (interned == traceNames.end()) {
+        if (traceNames.size() >= MAX_TRACE_NAMES) {
+            Napi::RangeError::New(env, "Too many distinct traceMark() names (max " +
+                                  std::to_string(MAX_TRACE_NAMES) + ")").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        interned = traceNames.insert(key).first;
+    }
+
+    const std::string& name = *interned;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        trace->instant(name.c_str(), "value", info[1].As<Napi::Number>().Int64Value());
+    } else {
+        trace->instant(name.c_str());
+    }
+    return env.Undefined();
+}
+
+Napi::Value DecoderWrapper::GetMetadata(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!decoder->isOpen()) {
+        Napi::Error::New(env, "Decoder is not open").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    FFmpegDecoder::AudioMetadata meta = decoder->getMetadata();
+    return MetadataToJS(env, meta);
+}
+
+Napi::Value DecoderWrapper::GetFileMetadata(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string filePath").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string filePath = info[0].As<Napi::String>().Utf8Value();
+    FFmpegDecoder::AudioMetadata meta = FFmpegDecoder::getFileMetadata(filePath.c_str());
+    return MetadataToJS(env, meta);
+}
+
+Napi::Value DecoderWrapper::GeneratePeaks(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!CheckReopenable(env)) {
+        return env.Null();
+    }
+
+    std::vector<int> levels(PeakPyramid::DEFAULT_LEVELS, PeakPyramid::DEFAULT_LEVELS + PeakPyramid::DEFAULT_LEVEL_COUNT);
+    if (info.Length() >= 1 && !info[0].IsUndefined() && !info[0].IsNull()) {
+        if (!info[0].IsArray()) {
+            Napi::TypeError::New(env, "Expected array of samplesPerBucket levels").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        Napi::Array arr = info[0].As<Napi::Array>();
+        levels.clear();
+        for (uint32_t i = 0; i < arr.Length(); i++) {
+            Napi::Value v = arr.Get(i);
+            if (!v.IsNumber()) {
+                Napi::TypeError::New(env, "Expected number samplesPerBucket").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            levels.push_back(v.As<Napi::Number>().Int32Value());
+        }
+    }
+
+    if (!PeakPyramid::validLevels(levels)) {
+        Napi::RangeError::New(env, "levels must be ascending and each a multiple of the previous").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // Defaults to the decoder's own mode; pass { analysis: true, ... } for a fast overview
+    DecoderOpenOptions options = decoder->getOpenOptions();
+    if (info.Length() >= 2 && !info[1].IsUndefined() && !info[1].IsNull()) {
+        options = DecoderOpenOptions();
+        if (!ParseOpenOptions(env, info[1], options)) {
+            return env.Null();
+        }
+    }
+
+    PeaksWorker* worker = new PeaksWorker(env, decoder->getSource(), decoder->getSampleRate(),
+                                          decoder->getThreadCount(), levels, options, SourcePin(env));
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+Napi::Value DecoderWrapper::AnalyzeLoudness(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!CheckReopenable(env)) {
+        return env.Null();
+    }
+
+    // Measure at the source rate unless the caller asks otherwise
+    DecoderOpenOptions options;
+    options.analysis = true;
+    if (info.Length() >= 1 && !ParseOpenOptions(env, info[0], options)) {
+        return env.Null();
+    }
+
+    // Gating blocks must cover every sample; packet skipping would skew the result
+    options.skipNonKey = false;
+    options.packetStride = 1;
+
+    std::vector<DecoderSource> sources(1, decoder->getSource());
+    LoudnessWorker* worker = new LoudnessWorker(env, sources, decoder->getSampleRate(),
+                                                decoder->getThreadCount(), options, true, SourcePin(env));
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+Napi::Value DecoderWrapper::GenerateSpectrogram(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!CheckReopenable(env)) {
+        return env.Null();
+    }
+
+    // One options object carries both decode ({ analysis, ... }) and spectrum settings
+    DecoderOpenOptions decodeOptions = decoder->getOpenOptions();
+    SpectrumAnalyzer::Options spectrumOptions;
+    if (info.Length() >= 1 && !info[0].IsUndefined() && !info[0].IsNull()) {
+        decodeOptions = DecoderOpenOptions();
+        if (!ParseOpenOptions(env, info[0], decodeOptions) || !ParseSpectrumOptions(env, info[0], spectrumOptions)) {
+            return env.Null();
+        }
+    }
+
+    SpectrogramWorker* worker = new SpectrogramWorker(env, decoder->getSource(), decoder->getSampleRate(),
+                                                      decoder->getThreadCount(), decodeOptions, spectrumOptions,
+                                                      SourcePin(env));
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+Napi::Value DecoderWrapper::DetectSegments(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!CheckReopenable(env)) {
+        return env.Null();
+    }
+
+    // Native rate by default: positions are resolution-independent and no resampling is needed
+    DecoderOpenOptions decodeOptions;
+    decodeOptions.analysis = true;
+    SegmentDetector::Options detectorOptions;
+    if (info.Length() >= 1 &&
+        (!ParseOpenOptions(env, info[0], decodeOptions) || !ParseDetectorOptions(env, info[0], detectorOptions))) {
+        return env.Null();
+    }
+
+    // Positions must cover every sample; packet skipping would shift them
+    decodeOptions.skipNonKey = false;
+    decodeOptions.packetStride = 1;
+
+    DetectorWorker* worker = new DetectorWorker(env, decoder->getSource(), decoder->getSampleRate(),
+                                                decoder->getThreadCount(), decodeOptions, detectorOptions,
+                                                SourcePin(env));
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+Napi::Value DecoderWrapper::SerializePeaks(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    PeakData peaks;
+    if (info.Length() < 1 || !PeakDataFromJS(env, info[0], peaks)) {
+        if (info.Length() < 1) {
+            Napi::TypeError::New(env, "Expected peaks object").ThrowAsJavaScriptException();
+        }
+        return env.Null();
+    }
+
+    std::vector<uint8_t> bytes = peaks.serialize();
+    return Napi::Buffer<uint8_t>::Copy(env, bytes.data(), bytes.size());
+}
+
+Napi::Value DecoderWrapper::ParsePeaks(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBuffer()) {
+        Napi::TypeError::New(env, "Expected Buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Buffer<uint8_t> buf = info[0].As<Napi::Buffer<uint8_t>>();
+    PeakData peaks;
+    if (!peaks.deserialize(buf.Data(), buf.Length())) {
+        Napi::Error::New(env, "Invalid peaks data").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return PeakDataToJS(env, peaks);
+}
+
 /**
- * NAPI Wrapper for FFmpegDecoder
- * Provides JavaScript interface to the native FFmpeg decoder
+ * NAPI Wrapper for MultiTrackDecoder
+ * All methods are synchronous; readMixed() blocks until every track has decoded
  */
-class DecoderWrapper : public Napi::ObjectWrap<DecoderWrapper> {
+class MultiTrackDecoderWrapper : public Napi::ObjectWrap<MultiTrackDecoderWrapper> {
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
-    DecoderWrapper(const Napi::CallbackInfo& info);
-    ~DecoderWrapper();
+    MultiTrackDecoderWrapper(const Napi::CallbackInfo& info);
+    ~MultiTrackDecoderWrapper();
 
 private:
-    std::unique_ptr<FFmpegDecoder> decoder;
-    
-    // Methods
-    Napi::Value Open(const Napi::CallbackInfo& info);
-    void Close(const Napi::CallbackInfo& info);
+    std::unique_ptr<MultiTrackDecoder> mixer;
+
+    // Native memory last reported to V8 per track, in track order; each track
+    // counts as one decoder in getMemoryUsage()
+    std::vector<int64_t> accountedMemory;
+    void accountMemory(Napi::Env env);
+
+    // Tracks
+    Napi::Value AddTrack(const Napi::CallbackInfo& info);
+    Napi::Value RemoveTrack(const Napi::CallbackInfo& info);
+    Napi::Value GetTrackCount(const Napi::CallbackInfo& info);
+    Napi::Value GetTrackInfo(const Napi::CallbackInfo& info);
+    Napi::Value SetTrackGain(const Napi::CallbackInfo& info);
+    Napi::Value SetTrackPan(const Napi::CallbackInfo& info);
+    Napi::Value SetTrackMute(const Napi::CallbackInfo& info);
+    Napi::Value SetTrackSolo(const Napi::CallbackInfo& info);
+
+    // Playback
+    Napi::Value ReadMixed(const Napi::CallbackInfo& info);
+    Napi::Value ReadSeparate(const Napi::CallbackInfo& info);
     Napi::Value Seek(const Napi::CallbackInfo& info);
-    Napi::Value Read(const Napi::CallbackInfo& info);
-    Napi::Value GetMetadata(const Napi::CallbackInfo& info);
-    
+    void Close(const Napi::CallbackInfo& info);
+
     // Properties
     Napi::Value GetDuration(const Napi::CallbackInfo& info);
+    Napi::Value GetPosition(const Napi::CallbackInfo& info);
     Napi::Value GetSampleRate(const Napi::CallbackInfo& info);
     Napi::Value GetChannels(const Napi::CallbackInfo& info);
-    Napi::Value GetTotalSamples(const Napi::CallbackInfo& info);
-    Napi::Value IsOpen(const Napi::CallbackInfo& info);
-    static Napi::Value GetFileMetadata(const Napi::CallbackInfo& info);
+    Napi::Value GetThreadCount(const Napi::CallbackInfo& info);
+    Napi::Value GetLastError(const Napi::CallbackInfo& info);
+
+    // Validates (index, value) arguments; throws and returns false on bad input
+    bool GetTrackArgs(const Napi::CallbackInfo& info, const char* valueType, int* index);
 };
 
-DecoderWrapper::DecoderWrapper(const Napi::CallbackInfo& info) 
-    : Napi::ObjectWrap<DecoderWrapper>(info) {
-    decoder = std::make_unique<FFmpegDecoder>();
+MultiTrackDecoderWrapper::MultiTrackDecoderWrapper(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<MultiTrackDecoderWrapper>(info) {
+    Napi::Env env = info.Env();
+
+    int sampleRate = 44100;
+    int threads = 0;
+    if (info.Length() >= 1 && !info[0].IsUndefined() && !info[0].IsNull()) {
+        if (!info[0].IsObject()) {
+            Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object obj = info[0].As<Napi::Object>();
+        if (obj.Get("sampleRate").IsNumber()) sampleRate = obj.Get("sampleRate").As<Napi::Number>().Int32Value();
+        if (obj.Get("threads").IsNumber()) threads = obj.Get("threads").As<Napi::Number>().Int32Value();
+        if (sampleRate <= 0 || threads < 0) {
+            Napi::RangeError::New(env, "sampleRate must be > 0 and threads >= 0").ThrowAsJavaScriptException();
+            return;
+        }
+    }
+
+    mixer.reset(new MultiTrackDecoder(sampleRate, threads));
 }
 
-DecoderWrapper::~DecoderWrapper() {
-    // Decoder will auto-close in destructor
+MultiTrackDecoderWrapper::~MultiTrackDecoderWrapper() {
+    for (int64_t& accounted : accountedMemory) ReportDecoderMemory(Env(), 0, &accounted);
 }
 
-Napi::Object DecoderWrapper::Init(Napi::Env env, Napi::Object exports) {
-    Napi::Function func = DefineClass(env, "FFmpegDecoder", {
-        InstanceMethod("open", &DecoderWrapper::Open),
-        InstanceMethod("close", &DecoderWrapper::Close),
-        InstanceMethod("seek", &DecoderWrapper::Seek),
-        InstanceMethod("read", &DecoderWrapper::Read),
-        InstanceMethod("getMetadata", &DecoderWrapper::GetMetadata),
-        InstanceMethod("getDuration", &DecoderWrapper::GetDuration),
-        InstanceMethod("getSampleRate", &DecoderWrapper::GetSampleRate),
-        InstanceMethod("getChannels", &DecoderWrapper::GetChannels),
-        InstanceMethod("getTotalSamples", &DecoderWrapper::GetTotalSamples),
-        InstanceMethod("isOpen", &DecoderWrapper::IsOpen),
-        StaticMethod("getFileMetadata", &DecoderWrapper::GetFileMetadata)
+void MultiTrackDecoderWrapper::accountMemory(Napi::Env env) {
+    accountedMemory.resize(mixer->getTrackCount(), 0);
+    for (size_t i = 0; i < accountedMemory.size(); i++) {
+        ReportDecoderMemory(env, mixer->getTrackMemory(static_cast<int>(i)).total(), &accountedMemory[i]);
+    }
+}
+
+Napi::Object MultiTrackDecoderWrapper::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "MultiTrackDecoder", {
+        InstanceMethod("addTrack", &MultiTrackDecoderWrapper::AddTrack),
+        InstanceMethod("removeTrack", &MultiTrackDecoderWrapper::RemoveTrack),
+        InstanceMethod("getTrackCount", &MultiTrackDecoderWrapper::GetTrackCount),
+        InstanceMethod("getTrackInfo", &MultiTrackDecoderWrapper::GetTrackInfo),
+        InstanceMethod("setTrackGain", &MultiTrackDecoderWrapper::SetTrackGain),
+        InstanceMethod("setTrackPan", &MultiTrackDecoderWrapper::SetTrackPan),
+        InstanceMethod("setTrackMute", &MultiTrackDecoderWrapper::SetTrackMute),
+        InstanceMethod("setTrackSolo", &MultiTrackDecoderWrapper::SetTrackSolo),
+        InstanceMethod("readMixed", &MultiTrackDecoderWrapper::ReadMixed),
+        InstanceMethod("readSeparate", &MultiTrackDecoderWrapper::ReadSeparate),
+        InstanceMethod("seek", &MultiTrackDecoderWrapper::Seek),
+        InstanceMethod("close", &MultiTrackDecoderWrapper::Close),
+        InstanceMethod("getDuration", &MultiTrackDecoderWrapper::GetDuration),
+        InstanceMethod("getPosition", &MultiTrackDecoderWrapper::GetPosition),
+        InstanceMethod("getSampleRate", &MultiTrackDecoderWrapper::GetSampleRate),
+        InstanceMethod("getChannels", &MultiTrackDecoderWrapper::GetChannels),
+        InstanceMethod("getThreadCount", &MultiTrackDecoderWrapper::GetThreadCount),
+        InstanceMethod("getLastError", &MultiTrackDecoderWrapper::GetLastError)
     });
-    
-    Napi::FunctionReference* constructor = new Napi::FunctionReference();
-    *constructor = Napi::Persistent(func);
-    env.SetInstanceData(constructor);
-    
-    exports.Set("FFmpegDecoder", func);
+
+    exports.Set("MultiTrackDecoder", func);
     return exports;
 }
 
-Napi::Value DecoderWrapper::Open(const Napi::CallbackInfo& info) {
+Napi::Value MultiTrackDecoderWrapper::AddTrack(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    
+
     if (info.Length() < 1 || !info[0].IsString()) {
         Napi::TypeError::New(env, "Expected string filePath").ThrowAsJavaScriptException();
         return env.Null();
     }
-    
-    std::string filePath = info[0].As<Napi::String>().Utf8Value();
 
-    int outSampleRate = 0;
-    if (info.Length() >= 2 && !info[1].IsUndefined() && !info[1].IsNull()) {
-        if (!info[1].IsNumber()) {
-            Napi::TypeError::New(env, "Expected number outputSampleRate").ThrowAsJavaScriptException();
-            return env.Null();
-        }
-        outSampleRate = info[1].As<Napi::Number>().Int32Value();
-        if (outSampleRate <= 0) {
-            Napi::RangeError::New(env, "outputSampleRate must be > 0").ThrowAsJavaScriptException();
-            return env.Null();
-        }
+    DecoderOpenOptions options;
+    if (info.Length() >= 2 && !ParseOpenOptions(env, info[1], options)) {
+        return env.Null();
+    }
+    if (options.analysis || options.skipNonKey || options.packetStride != 1) {
+        Napi::RangeError::New(env, "Tracks do not support analysis, skipNonKey or packetStride").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    int threads = 0;
-    if (info.Length() >= 3 && !info[2].IsUndefined() && !info[2].IsNull()) {
-        if (!info[2].IsNumber()) {
-            Napi::TypeError::New(env, "Expected number threads").ThrowAsJavaScriptException();
-            return env.Null();
-        }
-        threads = info[2].As<Napi::Number>().Int32Value();
-        if (threads < 0) {
-            Napi::RangeError::New(env, "threads must be >= 0").ThrowAsJavaScriptException();
-            return env.Null();
-        }
+    int index = mixer->addTrack(info[0].As<Napi::String>().Utf8Value(), options);
+    accountMemory(env);
+    return Napi::Number::New(env, index);
+}
+
+Napi::Value MultiTrackDecoderWrapper::RemoveTrack(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected number index").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    bool success = decoder->open(filePath.c_str(), outSampleRate, threads);
-    
-    return Napi::Boolean::New(env, success);
+    int index = info[0].As<Napi::Number>().Int32Value();
+    if (!mixer->removeTrack(index)) return Napi::Boolean::New(env, false);
+
+    ReportDecoderMemory(env, 0, &accountedMemory[index]);
+    accountedMemory.erase(accountedMemory.begin() + index);
+    return Napi::Boolean::New(env, true);
 }
 
-void DecoderWrapper::Close(const Napi::CallbackInfo& info) {
-    decoder->close();
+Napi::Value MultiTrackDecoderWrapper::GetTrackCount(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), mixer->getTrackCount());
 }
 
-Napi::Value DecoderWrapper::Seek(const Napi::CallbackInfo& info) {
+Napi::Value MultiTrackDecoderWrapper::GetTrackInfo(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    
+
     if (info.Length() < 1 || !info[0].IsNumber()) {
-        Napi::TypeError::New(env, "Expected number seconds").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected number index").ThrowAsJavaScriptException();
         return env.Null();
     }
-    
-    double seconds = info[0].As<Napi::Number>().DoubleValue();
-    bool success = decoder->seek(seconds);
-    
-    return Napi::Boolean::New(env, success);
+
+    int index = info[0].As<Napi::Number>().Int32Value();
+    if (index < 0 || index >= mixer->getTrackCount()) return env.Null();
+
+    MultiTrackDecoder::TrackInfo track = mixer->getTrackInfo(index);
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("path", Napi::String::New(env, track.path));
+    obj.Set("gain", Napi::Number::New(env, track.gain));
+    obj.Set("pan", Napi::Number::New(env, track.pan));
+    obj.Set("muted", Napi::Boolean::New(env, track.muted));
+    obj.Set("solo", Napi::Boolean::New(env, track.solo));
+    obj.Set("ended", Napi::Boolean::New(env, track.ended));
+    obj.Set("duration", Napi::Number::New(env, track.duration));
+    return obj;
 }
 
-Napi::Value DecoderWrapper::Read(const Napi::CallbackInfo& info) {
+bool MultiTrackDecoderWrapper::GetTrackArgs(const Napi::CallbackInfo& info, const char* valueType, int* index) {
     Napi::Env env = info.Env();
-    
+
+    bool boolean = strcmp(valueType, "boolean") == 0;
+    if (info.Length() < 2 || !info[0].IsNumber() || !(boolean ? info[1].IsBoolean() : info[1].IsNumber())) {
+        Napi::TypeError::New(env, std::string("Expected (number index, ") + valueType + " value)").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    *index = info[0].As<Napi::Number>().Int32Value();
+    return true;
+}
+
+Napi::Value MultiTrackDecoderWrapper::SetTrackGain(const Napi::CallbackInfo& info) {
+    int index = 0;
+    if (!GetTrackArgs(info, "number", &index)) return info.Env().Null();
+    return Napi::Boolean::New(info.Env(), mixer->setTrackGain(index, info[1].As<Napi::Number>().FloatValue()));
+}
+
+Napi::Value MultiTrackDecoderWrapper::SetTrackPan(const Napi::CallbackInfo& info) {
+    int index = 0;
+    if (!GetTrackArgs(info, "number", &index)) return info.Env().Null();
+    return Napi::Boolean::New(info.Env(), mixer->setTrackPan(index, info[1].As<Napi::Number>().FloatValue()));
+}
+
+Napi::Value MultiTrackDecoderWrapper::SetTrackMute(const Napi::CallbackInfo& info) {
+    int index = 0;
+    if (!GetTrackArgs(info, "boolean", &index)) return info.Env().Null();
+    return Napi::Boolean::New(info.Env(), mixer->setTrackMute(index, info[1].As<Napi::Boolean>().Value()));
+}
+
+Napi::Value MultiTrackDecoderWrapper::SetTrackSolo(const Napi::CallbackInfo& info) {
+    int index = 0;
+    if (!GetTrackArgs(info, "boolean", &index)) return info.Env().Null();
+    return Napi::Boolean::New(info.Env(), mixer->setTrackSolo(index, info[1].As<Napi::Boolean>().Value()));
+}
+
+Napi::Value MultiTrackDecoderWrapper::ReadMixed(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
     if (info.Length() < 1 || !info[0].IsNumber()) {
         Napi::TypeError::New(env, "Expected number numSamples").ThrowAsJavaScriptException();
         return env.Null();
     }
-    
-    int numSamples = info[0].As<Napi::Number>().Int32Value();
-    
-    // Create Float32Array for output
+
+    int numSamples = std::max(0, info[0].As<Napi::Number>().Int32Value());
     Napi::Float32Array buffer = Napi::Float32Array::New(env, numSamples);
-    
-    // Read samples
-    int samplesRead = decoder->read(buffer.Data(), numSamples);
-    
-    // Return object with buffer and actual count
+    int samplesRead = mixer->readMixed(buffer.Data(), numSamples);
+    accountMemory(env);
+
     Napi::Object result = Napi::Object::New(env);
     result.Set("buffer", buffer);
     result.Set("samplesRead", Napi::Number::New(env, samplesRead));
-    
     return result;
 }
 
-Napi::Value DecoderWrapper::GetDuration(const Napi::CallbackInfo& info) {
+Napi::Value MultiTrackDecoderWrapper::ReadSeparate(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    return Napi::Number::New(env, decoder->getDuration());
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected number numSamples").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int numSamples = std::max(0, info[0].As<Napi::Number>().Int32Value());
+    int count = mixer->getTrackCount();
+    std::vector<Napi::Float32Array> buffers;
+    std::vector<float*> outputs;
+    for (int i = 0; i < count; i++) {
+        buffers.push_back(Napi::Float32Array::New(env, numSamples));
+        outputs.push_back(buffers.back().Data());
+    }
+
+    std::vector<int> samplesRead(count, 0);
+    mixer->readSeparate(outputs.data(), numSamples, samplesRead.data());
+    accountMemory(env);
+
+    Napi::Array bufferArray = Napi::Array::New(env, count);
+    Napi::Array countArray = Napi::Array::New(env, count);
+    for (int i = 0; i < count; i++) {
+        bufferArray.Set(static_cast<uint32_t>(i), buffers[i]);
+        countArray.Set(static_cast<uint32_t>(i), Napi::Number::New(env, samplesRead[i]));
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("buffers", bufferArray);
+    result.Set("samplesRead", countArray);
+    return result;
 }
 
-Napi::Value DecoderWrapper::GetSampleRate(const Napi::CallbackInfo& info) {
+Napi::Value MultiTrackDecoderWrapper::Seek(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    return Napi::Number::New(env, decoder->getSampleRate());
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected number seconds").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    bool ok = mixer->seek(info[0].As<Napi::Number>().DoubleValue());
+    accountMemory(env);
+    return Napi::Boolean::New(env, ok);
 }
 
-Napi::Value DecoderWrapper::GetChannels(const Napi::CallbackInfo& info) {
+void MultiTrackDecoderWrapper::Close(const Napi::CallbackInfo& info) {
+    mixer->close();
+    for (int64_t& accounted : accountedMemory) ReportDecoderMemory(info.Env(), 0, &accounted);
+    accountedMemory.clear();
+}
+
+Napi::Value MultiTrackDecoderWrapper::GetDuration(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), mixer->getDuration());
+}
+
+Napi::Value MultiTrackDecoderWrapper::GetPosition(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), mixer->getPosition());
+}
+
+Napi::Value MultiTrackDecoderWrapper::GetSampleRate(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), mixer->getSampleRate());
+}
+
+Napi::Value MultiTrackDecoderWrapper::GetChannels(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), MultiTrackDecoder::CHANNELS);
+}
+
+Napi::Value MultiTrackDecoderWrapper::GetThreadCount(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), mixer->getThreadCount());
+}
+
+Napi::Value MultiTrackDecoderWrapper::GetLastError(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    return Napi::Number::New(env, decoder->getChannels());
+    DecoderError error = mixer->getLastError();
+    if (!error.isSet()) return env.Null();
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("code", Napi::Number::New(env, error.code));
+    obj.Set("phase", Napi::String::New(env, errorPhaseName(error.phase)));
+    obj.Set("message", Napi::String::New(env, error.message));
+    return obj;
 }
 
-Napi::Value DecoderWrapper::GetTotalSamples(const Napi::CallbackInfo& info) {
+static Napi::Value GetMetadata(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    return Napi::Number::New(env, static_cast<double>(decoder->getTotalSamples()));
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string filePath").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string filePath = info[0].As<Napi::String>().Utf8Value();
+    FFmpegDecoder::AudioMetadata meta = FFmpegDecoder::getFileMetadata(filePath.c_str());
+    return MetadataToJS(env, meta);
 }
 
-Napi::Value DecoderWrapper::IsOpen(const Napi::CallbackInfo& info) {
+static Napi::Value AnalyzeLoudness(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    return Napi::Boolean::New(env, decoder->isOpen());
+
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected array of file paths").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array arr = info[0].As<Napi::Array>();
+    std::vector<DecoderSource> sources(arr.Length());
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+        Napi::Value v = arr.Get(i);
+        if (!v.IsString()) {
+            Napi::TypeError::New(env, "Expected string filePath").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        sources[i].path = v.As<Napi::String>().Utf8Value();
+    }
+    if (sources.empty()) {
+        Napi::RangeError::New(env, "Expected at least one file").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    DecoderOpenOptions options;
+    options.analysis = true;
+    int sampleRate = 0;
+    int threads = 0;
+    if (info.Length() >= 2 && !info[1].IsUndefined() && !info[1].IsNull()) {
+        if (!ParseOpenOptions(env, info[1], options)) {
+            return env.Null();
+        }
+        Napi::Object obj = info[1].As<Napi::Object>();
+        if (obj.Get("sampleRate").IsNumber()) sampleRate = obj.Get("sampleRate").As<Napi::Number>().Int32Value();
+        if (obj.Get("threads").IsNumber()) threads = obj.Get("threads").As<Napi::Number>().Int32Value();
+    }
+
+    // Gating blocks must cover every sample; packet skipping would skew the result
+    options.skipNonKey = false;
+    options.packetStride = 1;
+
+    LoudnessWorker* worker = new LoudnessWorker(env, sources, sampleRate, threads, options, false);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
 }
 
-Napi::Value DecoderWrapper::GetMetadata(const Napi::CallbackInfo& info) {
+// transcode(input, output, options?, onProgress?) -> { promise, cancel }
+static Napi::Value Transcode(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!decoder->isOpen()) {
-        Napi::Error::New(env, "Decoder is not open").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected input and output file paths").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    FFmpegDecoder::AudioMetadata meta = decoder->getMetadata();
-    return MetadataToJS(env, meta);
+    TranscodeOptions options;
+    if (info.Length() >= 3 && !ParseTranscodeOptions(env, info[2], options)) {
+        return env.Null();
+    }
+
+    Napi::Value onProgress = info.Length() >= 4 ? info[3] : env.Undefined();
+    std::shared_ptr<JobControl> control = std::make_shared<JobControl>();
+
+    TranscodeWorker* worker = new TranscodeWorker(env, info[0].As<Napi::String>().Utf8Value(),
+                                                  info[1].As<Napi::String>().Utf8Value(), options, control, onProgress);
+
+    Napi::Object job = Napi::Object::New(env);
+    job.Set("promise", worker->GetPromise());
+    job.Set("cancel", Napi::Function::New(env, [control](const Napi::CallbackInfo&) { control->cancel(); }, "cancel"));
+    worker->Queue();
+    return job;
 }
 
-Napi::Value DecoderWrapper::GetFileMetadata(const Napi::CallbackInfo& info) {
+// remux(input, output, options?, onProgress?) -> { promise, cancel }
+static Napi::Value Remux(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsString()) {
-        Napi::TypeError::New(env, "Expected string filePath").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected input and output file paths").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    std::string filePath = info[0].As<Napi::String>().Utf8Value();
-    FFmpegDecoder::AudioMetadata meta = FFmpegDecoder::getFileMetadata(filePath.c_str());
-    return MetadataToJS(env, meta);
+    RemuxOptions options;
+    if (info.Length() >= 3 && !ParseRemuxOptions(env, info[2], options)) {
+        return env.Null();
+    }
+
+    Napi::Value onProgress = info.Length() >= 4 ? info[3] : env.Undefined();
+    std::shared_ptr<JobControl> control = std::make_shared<JobControl>();
+
+    RemuxWorker* worker = new RemuxWorker(env, info[0].As<Napi::String>().Utf8Value(),
+                                          info[1].As<Napi::String>().Utf8Value(), options, control, onProgress);
+
+    Napi::Object job = Napi::Object::New(env);
+    job.Set("promise", worker->GetPromise());
+    job.Set("cancel", Napi::Function::New(env, [control](const Napi::CallbackInfo&) { control->cancel(); }, "cancel"));
+    worker->Queue();
+    return job;
 }
 
-static Napi::Value GetMetadata(const Napi::CallbackInfo& info) {
+// generateFixture(output, options?) -> Promise<FixtureResult>
+static Napi::Value GenerateFixture(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsString()) {
-        Napi::TypeError::New(env, "Expected string filePath").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected output file path").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    std::string filePath = info[0].As<Napi::String>().Utf8Value();
-    FFmpegDecoder::AudioMetadata meta = FFmpegDecoder::getFileMetadata(filePath.c_str());
-    return MetadataToJS(env, meta);
+    FixtureOptions options;
+    if (info.Length() >= 2 && !ParseFixtureOptions(env, info[1], options)) {
+        return env.Null();
+    }
+
+    FixtureWorker* worker = new FixtureWorker(env, info[0].As<Napi::String>().Utf8Value(), options);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// Shared by every group seek; created on first use and never destroyed, like SlabPool
+static ThreadPool& SeekGroupPool() {
+    static ThreadPool* pool = new ThreadPool(ThreadPool::defaultSize(1));
+    return *pool;
+}
+
+/**
+ * Seeks several decoders to the same output sample on the libuv thread pool.
+ * Holds every decoder's mutex for the duration, so no read can slip in
+ * between the individual seeks; the seeks themselves run in parallel.
+ */
+class SeekGroupWorker : public Napi::AsyncWorker {
+public:
+    SeekGroupWorker(Napi::Env env, double seconds)
+        : Napi::AsyncWorker(env)
+        , deferred(Napi::Promise::Deferred::New(env))
+        , seconds(seconds)
+        , success(false) {}
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+    void Add(Napi::Object owner, DecoderWrapper* wrapper) {
+        owners.push_back(Napi::Persistent(owner));
+        wrappers.push_back(wrapper);
+    }
+
+protected:
+    void Execute() override {
+        // Address order, so concurrent group seeks can't deadlock
+        std::vector<DecoderWrapper*> order(wrappers);
+        std::sort(order.begin(), order.end());
+        std::vector<std::unique_lock<std::mutex>> locks;
+        for (DecoderWrapper* wrapper : order) locks.emplace_back(wrapper->getDecodeMutex());
+
+        std::vector<FFmpegDecoder*> decoders;
+        for (DecoderWrapper* wrapper : wrappers) decoders.push_back(wrapper->getDecoder());
+
+        int count = static_cast<int>(decoders.size());
+        if (count <= 1) {
+            success = count == 0 || decoders[0]->seekExact(llround(seconds * decoders[0]->getSampleRate()));
+            return;
+        }
+        success = MultiTrackDecoder::seekGroup(decoders.data(), count, seconds, SeekGroupPool());
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        for (DecoderWrapper* wrapper : wrappers) {
+            std::unique_lock<std::mutex> lock(wrapper->getDecodeMutex(), std::try_to_lock);
+            if (lock.owns_lock()) wrapper->accountMemory(env);
+        }
+        deferred.Resolve(Napi::Boolean::New(env, success));
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    std::vector<Napi::ObjectReference> owners;
+    std::vector<DecoderWrapper*> wrappers;
+    double seconds;
+    bool success;
+};
+
+// seekGroup(decoders, seconds): Promise<boolean>, false if any decoder failed (see its getLastError())
+static Napi::Value SeekGroup(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (FFmpegDecoder[] decoders, number seconds)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array array = info[0].As<Napi::Array>();
+    Napi::FunctionReference* constructor = env.GetInstanceData<Napi::FunctionReference>();
+    SeekGroupWorker* worker = new SeekGroupWorker(env, info[1].As<Napi::Number>().DoubleValue());
+    std::set<DecoderWrapper*> seen;
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Value value = array.Get(i);
+        if (!value.IsObject() || !value.As<Napi::Object>().InstanceOf(constructor->Value())) {
+            delete worker;
+            Napi::TypeError::New(env, "decoders must be FFmpegDecoder instances").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        DecoderWrapper* wrapper = DecoderWrapper::Unwrap(value.As<Napi::Object>());
+        if (!seen.insert(wrapper).second) {
+            delete worker;
+            Napi::RangeError::New(env, "A decoder appears more than once").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        // A stream seek waits on JS for data while every member stays locked, so a
+        // sync read() on another member would deadlock the JS thread
+        if (wrapper->getDecoder()->getSource().isStream()) {
+            delete worker;
+            Napi::Error::New(env, "Not supported for stream sources").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        worker->Add(value.As<Napi::Object>(), wrapper);
+    }
+
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
+
+// getMemoryUsage() -> { total, decoders, pool }: native memory V8 has been told about
+static Napi::Value GetMemoryUsage(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("total", Napi::Number::New(env, static_cast<double>(decoderMemoryTotal.load(std::memory_order_relaxed))));
+    obj.Set("decoders", Napi::Number::New(env, decoderMemoryCount.load(std::memory_order_relaxed)));
+
+    SlabStats slab = SlabPool::instance().getStats();
+    Napi::Object pool = Napi::Object::New(env);
+    pool.Set("hits", Napi::Number::New(env, static_cast<double>(slab.hits)));
+    pool.Set("misses", Napi::Number::New(env, static_cast<double>(slab.misses)));
+    pool.Set("inUse", Napi::Number::New(env, static_cast<double>(slab.inUse)));
+    pool.Set("cached", Napi::Number::New(env, static_cast<double>(slab.cached)));
+    obj.Set("pool", pool);
+    return obj;
+}
+
+// trimMemoryPool(): frees buffers cached for reuse by closed decoders
+static Napi::Value TrimMemoryPool(const Napi::CallbackInfo& info) {
+    SlabPool::instance().trim();
+    return info.Env().Undefined();
 }
 
 // Module initialization
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
     DecoderWrapper::Init(env, exports);
+    SpectrumAnalyzerWrapper::Init(env, exports);
+    EncoderWrapper::Init(env, exports);
+    BatchTranscoderWrapper::Init(env, exports);
+    MultiTrackDecoderWrapper::Init(env, exports);
     exports.Set("getMetadata", Napi::Function::New(env, GetMetadata));
+    exports.Set("analyzeLoudness", Napi::Function::New(env, AnalyzeLoudness));
+    exports.Set("transcode", Napi::Function::New(env, Transcode));
+    exports.Set("remux", Napi::Function::New(env, Remux));
+    exports.Set("generateFixture", Napi::Function::New(env, GenerateFixture));
+    exports.Set("seekGroup", Napi::Function::New(env, SeekGroup));
+    exports.Set("getMemoryUsage", Napi::Function::New(env, GetMemoryUsage));
+    exports.Set("trimMemoryPool", Napi::Function::New(env, TrimMemoryPool));
+    exports.Set("traceEnabled", Napi::Boolean::New(env, FFMPEG_TRACE_ENABLED != 0));
     return exports;
 }
 
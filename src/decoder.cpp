@@ -1,6 +1,7 @@
 #include "decoder.h"
 #include <cstring>
 #include <algorithm>
+#include <cerrno>
 #include <cstdlib>
 
 FFmpegDecoder::FFmpegDecoder() 
@@ -17,7 +18,12 @@ FFmpegDecoder::FFmpegDecoder()
     , eofSignaled(false)
     , decoderDrained(false)
     , resamplerDrained(false)
+    , bufferStartFrame(0)
+    , nextFramePos(0)
+    , resyncPosition(false)
+    , packetCounter(0)
     , outputSampleRate(DEFAULT_OUTPUT_SAMPLE_RATE)
+    , outputChannels(OUTPUT_CHANNELS)
     , threadCount(0)
 {
     packet = av_packet_alloc();
@@ -30,19 +36,63 @@ FFmpegDecoder::~FFmpegDecoder() {
     if (frame) av_frame_free(&frame);
 }
 
-bool FFmpegDecoder::open(const char* filePath, int outSampleRate, int threads) {
+bool FFmpegDecoder::open(const char* filePath, int outSampleRate, int threads, const DecoderOpenOptions& openOptions) {
+    DecoderSource input;
+    input.path = filePath;
+    return open(input, outSampleRate, threads, openOptions);
+}
+
+bool FFmpegDecoder::open(const DecoderSource& requested, int outSampleRate, int threads, const DecoderOpenOptions& openOptions) {
     outputSampleRate = (outSampleRate > 0) ? outSampleRate : DEFAULT_OUTPUT_SAMPLE_RATE;
     threadCount = threads;
+    options = openOptions;
+    if (options.packetStride < 1 || !options.analysis) options.packetStride = 1;
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        lastError = DecoderError();
+    }
+    counters.reset();
 
-    // Open input file
-    if (avformat_open_input(&formatCtx, filePath, nullptr, nullptr) < 0) {
-        return false;
+    // Serve a local file from a mapping: no read() syscalls or page-cache copies.
+    // The mapping joins the source, so workers reopening it share it.
+    DecoderSource input = requested;
+    if (options.mmap && !input.isMemory() && !input.isStream() && !input.path.empty()) {
+        input.memory = MemoryBlock::map(input.path, options.analysis);
+    }
+
+    bool customIO = true;
+    if (input.isMemory()) {
+        // Demux straight from memory through our own AVIOContext
+        memoryReader.reset(new MemoryReader(input.memory));
+        customIO = useCustomIO(memoryReader->context());
+    } else if (input.isStream()) {
+        customIO = useCustomIO(input.stream->context());
+    } else if (!input.path.empty()) {
+        // Local files get our own reader (buffer size, hints, counters); URLs stay with avformat
+        const char* protocol = avio_find_protocol_name(input.path.c_str());
+        if (protocol && strcmp(protocol, "file") == 0) {
+            fileReader = FileReader::open(input.path, options.io, options.analysis);
+            if (fileReader) customIO = useCustomIO(fileReader->context());
+        }
+    }
+    if (!customIO) {
+        releaseIO();
+        return fail(PHASE_OPEN, AVERROR(ENOMEM), "Failed to set up input I/O");
+    }
+
+    // Open input (frees a preallocated formatCtx on failure)
+    int ret = avformat_open_input(&formatCtx, input.path.c_str(), nullptr, nullptr);
+    if (ret < 0) {
+        releaseIO();
+        return fail(PHASE_OPEN, ret, "Failed to open input");
     }
     
     // Retrieve stream information
-    if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
+    ret = avformat_find_stream_info(formatCtx, nullptr);
+    if (ret < 0) {
         avformat_close_input(&formatCtx);
-        return false;
+        releaseIO();
+        return fail(PHASE_STREAM_INFO, ret, "Failed to read stream info");
     }
     
     // Find audio stream
@@ -56,7 +106,17 @@ bool FFmpegDecoder::open(const char* filePath, int outSampleRate, int threads) {
     
     if (audioStreamIndex == -1) {
         avformat_close_input(&formatCtx);
-        return false;
+        releaseIO();
+        return fail(PHASE_STREAM_INFO, AVERROR_STREAM_NOT_FOUND, "No audio stream");
+    }
+
+    // Analysis mode: don't demux packets we never decode (cover art, other streams)
+    if (options.analysis) {
+        for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+            if (static_cast<int>(i) != audioStreamIndex) {
+                formatCtx->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
     }
     
     // Get codec parameters
@@ -66,49 +126,83 @@ bool FFmpegDecoder::open(const char* filePath, int outSampleRate, int threads) {
     const AVCodec* codec = avcodec_find_decoder(codecParams->codec_id);
     if (!codec) {
         avformat_close_input(&formatCtx);
-        return false;
+        releaseIO();
+        return fail(PHASE_CODEC, AVERROR_DECODER_NOT_FOUND, "No decoder for the audio codec");
     }
     
     // Allocate codec context
     codecCtx = avcodec_alloc_context3(codec);
     if (!codecCtx) {
         avformat_close_input(&formatCtx);
-        return false;
+        releaseIO();
+        return fail(PHASE_CODEC, AVERROR(ENOMEM), "Failed to allocate codec context");
     }
     
     // Copy codec parameters to context
-    if (avcodec_parameters_to_context(codecCtx, codecParams) < 0) {
+    ret = avcodec_parameters_to_context(codecCtx, codecParams);
+    if (ret < 0) {
         avcodec_free_context(&codecCtx);
         avformat_close_input(&formatCtx);
-        return false;
+        releaseIO();
+        return fail(PHASE_CODEC, ret, "Failed to copy codec parameters");
     }
     
+    // Decoded frames come from our own buffer pool instead of per-frame allocations
+    framePool.attach(codecCtx);
+
     // Configure threading (0 = auto-detect, >0 = specific thread count)
     if (threadCount > 0) {
         codecCtx->thread_count = threadCount;
     }
     codecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+    // Reduced-fidelity decoding for overviews (ignored by codecs that don't support it)
+    if (options.analysis && options.skipNonKey) {
+        codecCtx->skip_frame = AVDISCARD_NONKEY;
+    }
     
     // Open codec
-    if (avcodec_open2(codecCtx, codec, nullptr) < 0) {
+    ret = avcodec_open2(codecCtx, codec, nullptr);
+    if (ret < 0) {
         avcodec_free_context(&codecCtx);
         avformat_close_input(&formatCtx);
-        return false;
+        releaseIO();
+        return fail(PHASE_CODEC, ret, "Failed to open decoder");
     }
     
-    // Initialize resampler
-    if (!initResampler()) {
-        close();
-        return false;
+    if (options.analysis) {
+        // No resampler: output stays at the source rate and channel count
+        outputSampleRate = codecCtx->sample_rate;
+        outputChannels = codecCtx->ch_layout.nb_channels > 0 ? codecCtx->ch_layout.nb_channels : OUTPUT_CHANNELS;
+        if (outputSampleRate <= 0) {
+            close();
+            return fail(PHASE_CODEC, AVERROR_INVALIDDATA, "Unknown source sample rate");
+        }
+    } else {
+        outputChannels = OUTPUT_CHANNELS;
+
+        // Initialize resampler (records its own error)
+        if (!initResampler()) {
+            close();
+            return false;
+        }
     }
     
-    // Allocate sample buffer (1 second of audio)
-    sampleBufferSize = outputSampleRate * OUTPUT_CHANNELS;
-    sampleBuffer = new float[sampleBufferSize];
+    // Staging buffer for one decoded frame; grows if a later frame is larger
+    int frameSamples = codecCtx->frame_size > 0 ? codecCtx->frame_size : DEFAULT_FRAME_SAMPLES;
+    int outFrames = swrCtx ? swr_get_out_samples(swrCtx, frameSamples) : frameSamples;
+    if (!ensureBufferCapacity(std::max(outFrames, frameSamples) * outputChannels)) {
+        close();
+        return fail(PHASE_OPEN, AVERROR(ENOMEM), "Failed to allocate sample buffer");
+    }
 
     eofSignaled = false;
     decoderDrained = false;
     resamplerDrained = false;
+    bufferStartFrame = 0;
+    nextFramePos = 0;
+    packetCounter = 0;
+    source = input;
     
     return true;
 }
@@ -139,21 +233,23 @@ bool FFmpegDecoder::initResampler() {
     );
     
     if (ret < 0 || !swrCtx) {
-        return false;
+        return fail(PHASE_RESAMPLER, ret < 0 ? ret : AVERROR(ENOMEM), "Failed to configure resampler");
     }
     
     // Initialize resampler
-    if (swr_init(swrCtx) < 0) {
+    ret = swr_init(swrCtx);
+    if (ret < 0) {
         swr_free(&swrCtx);
-        return false;
+        return fail(PHASE_RESAMPLER, ret, "Failed to initialize resampler");
     }
     
     return true;
 }
 
 void FFmpegDecoder::close() {
-    delete[] sampleBuffer;
+    SlabPool::instance().release(sampleBuffer, static_cast<size_t>(sampleBufferSize) * sizeof(float));
     sampleBuffer = nullptr;
+    sampleBufferSize = 0;
     
     if (swrCtx) {
         swr_free(&swrCtx);
@@ -164,19 +260,27 @@ void FFmpegDecoder::close() {
         avcodec_free_context(&codecCtx);
         codecCtx = nullptr;
     }
+    framePool.reset();
     
     if (formatCtx) {
         avformat_close_input(&formatCtx);
         formatCtx = nullptr;
     }
+    releaseIO();
     
     audioStreamIndex = -1;
     samplesInBuffer = 0;
     bufferReadPos = 0;
+    source = DecoderSource();
 
     eofSignaled = false;
     decoderDrained = false;
     resamplerDrained = false;
+    bufferStartFrame = 0;
+    nextFramePos = 0;
+    packetCounter = 0;
+    options = DecoderOpenOptions();
+    outputChannels = OUTPUT_CHANNELS;
 }
 
 bool FFmpegDecoder::seek(double seconds) {
@@ -187,20 +291,74 @@ bool FFmpegDecoder::seek(double seconds) {
     int64_t timestamp = static_cast<int64_t>(seconds * AV_TIME_BASE);
     
     // Seek to timestamp
-    if (av_seek_frame(formatCtx, audioStreamIndex, 
-                     av_rescale_q(timestamp, AV_TIME_BASE_Q, stream->time_base),
-                     AVSEEK_FLAG_BACKWARD) < 0) {
-        return false;
+    int64_t started = monotonicNs();
+    int ret = av_seek_frame(formatCtx, audioStreamIndex,
+                            av_rescale_q(timestamp, AV_TIME_BASE_Q, stream->time_base),
+                            AVSEEK_FLAG_BACKWARD);
+    TRACE_SPAN_ARG(trace.get(), "seek", started, monotonicNs(), "ms", static_cast<int64_t>(seconds * 1000));
+    if (ret < 0) {
+        return fail(PHASE_SEEK, ret, "Seek failed");
     }
-    
+
+    resetAfterSeek(static_cast<int64_t>(seconds * outputSampleRate));
+    return true;
+}
+
+bool FFmpegDecoder::seekExact(int64_t frame) {
+    if (!formatCtx) return false;
+    if (frame < 0) frame = 0;
+
+    AVStream* stream = formatCtx->streams[audioStreamIndex];
+    int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+
+    // Land early enough for codecs that need pre-roll (e.g. Opus) to settle
+    int64_t preroll = 0;
+    if (stream->codecpar->seek_preroll > 0 && stream->codecpar->sample_rate > 0) {
+        preroll = av_rescale(stream->codecpar->seek_preroll, outputSampleRate, stream->codecpar->sample_rate);
+    }
+    int64_t timestamp = start + av_rescale_q(std::max<int64_t>(0, frame - preroll),
+                                             AVRational{1, outputSampleRate}, stream->time_base);
+
+    int64_t started = monotonicNs();
+    int ret = av_seek_frame(formatCtx, audioStreamIndex, timestamp, AVSEEK_FLAG_BACKWARD);
+    if (ret < 0) {
+        TRACE_SPAN_ARG(trace.get(), "seekExact", started, monotonicNs(), "frame", frame);
+        return fail(PHASE_SEEK, ret, "Seek failed");
+    }
+    resetAfterSeek(frame);
+
+    // Decode up to the frame holding the target; the first frame's timestamp
+    // says where the packet actually landed. Without timestamps this is no
+    // more accurate than seek().
+    resyncPosition = true;
+    while (nextFramePos <= frame) {
+        int decoded = decodeNextFrame();
+        if (decoded < 0) {
+            resyncPosition = false;
+            return false;
+        }
+        if (decoded == 0) break;    // Target is past the end
+    }
+    resyncPosition = false;
+
+    if (samplesInBuffer > 0 && bufferStartFrame < frame) {
+        bufferReadPos = static_cast<int>(std::min<int64_t>(samplesInBuffer, (frame - bufferStartFrame) * outputChannels));
+    }
+    TRACE_SPAN_ARG(trace.get(), "seekExact", started, monotonicNs(), "frame", frame);
+    return true;
+}
+
+void FFmpegDecoder::resetAfterSeek(int64_t frame) {
     // Flush codec buffers
     avcodec_flush_buffers(codecCtx);
 
     // Reset resampler state (important for gapless looping / consistent output after seek)
     if (swrCtx) {
         swr_close(swrCtx);
-        if (swr_init(swrCtx) < 0) {
+        int reinit = swr_init(swrCtx);
+        if (reinit < 0) {
             // If re-init fails, keep going; caller will see missing audio rather than crash
+            fail(PHASE_RESAMPLER, reinit, "Failed to reset resampler after seek");
         }
     }
     
@@ -212,16 +370,140 @@ bool FFmpegDecoder::seek(double seconds) {
     eofSignaled = false;
     decoderDrained = false;
     resamplerDrained = false;
-    
+
+    nextFramePos = frame;
+    bufferStartFrame = nextFramePos;
+    packetCounter = 0;
+}
+
+// Only called with the buffer fully consumed: the contents are not kept
+bool FFmpegDecoder::ensureBufferCapacity(int samples) {
+    if (samples <= sampleBufferSize) return true;
+
+    // Slab blocks come in size classes; use the whole block
+    size_t bytes = static_cast<size_t>(samples) * sizeof(float);
+    float* grown = static_cast<float*>(SlabPool::instance().allocate(bytes));
+    if (!grown) return false;
+
+    SlabPool::instance().release(sampleBuffer, static_cast<size_t>(sampleBufferSize) * sizeof(float));
+    sampleBuffer = grown;
+    sampleBufferSize = static_cast<int>(SlabPool::capacityFor(bytes) / sizeof(float));
     return true;
 }
 
+template <typename T, typename Scale>
+static void copyToFloat(const AVFrame* frame, bool planar, int srcChannels, int dstChannels, float* out, Scale scale) {
+    const int frames = frame->nb_samples;
+    const int channels = std::min(srcChannels, dstChannels);
+
+    for (int c = 0; c < channels; c++) {
+        const T* src = planar ? reinterpret_cast<const T*>(frame->extended_data[c])
+                              : reinterpret_cast<const T*>(frame->extended_data[0]) + c;
+        const int stride = planar ? 1 : srcChannels;
+        float* dst = out + c;
+        for (int i = 0; i < frames; i++) {
+            dst[static_cast<size_t>(i) * dstChannels] = scale(src[static_cast<size_t>(i) * stride]);
+        }
+    }
+
+    // Layout changed mid-stream to fewer channels: keep the output shape stable
+    for (int c = channels; c < dstChannels; c++) {
+        for (int i = 0; i < frames; i++) {
+            out[static_cast<size_t>(i) * dstChannels + c] = 0.0f;
+        }
+    }
+}
+
+int FFmpegDecoder::convertNativeFrame() {
+    const int samples = frame->nb_samples * outputChannels;
+    if (!ensureBufferCapacity(samples)) return AVERROR(ENOMEM);
+
+    AVSampleFormat fmt = static_cast<AVSampleFormat>(frame->format);
+    const bool planar = av_sample_fmt_is_planar(fmt) != 0;
+    const int srcChannels = frame->ch_layout.nb_channels > 0 ? frame->ch_layout.nb_channels : outputChannels;
+
+    switch (av_get_packed_sample_fmt(fmt)) {
+        case AV_SAMPLE_FMT_U8:
+            copyToFloat<uint8_t>(frame, planar, srcChannels, outputChannels, sampleBuffer,
+                                 [](uint8_t v) { return (static_cast<int>(v) - 128) * (1.0f / 128.0f); });
+            break;
+        case AV_SAMPLE_FMT_S16:
+            copyToFloat<int16_t>(frame, planar, srcChannels, outputChannels, sampleBuffer,
+                                 [](int16_t v) { return v * (1.0f / 32768.0f); });
+            break;
+        case AV_SAMPLE_FMT_S32:
+            copyToFloat<int32_t>(frame, planar, srcChannels, outputChannels, sampleBuffer,
+                                 [](int32_t v) { return static_cast<float>(v * (1.0 / 2147483648.0)); });
+            break;
+        case AV_SAMPLE_FMT_S64:
+            copyToFloat<int64_t>(frame, planar, srcChannels, outputChannels, sampleBuffer,
+                                 [](int64_t v) { return static_cast<float>(v * (1.0 / 9223372036854775808.0)); });
+            break;
+        case AV_SAMPLE_FMT_FLT:
+            copyToFloat<float>(frame, planar, srcChannels, outputChannels, sampleBuffer,
+                               [](float v) { return v; });
+            break;
+        case AV_SAMPLE_FMT_DBL:
+            copyToFloat<double>(frame, planar, srcChannels, outputChannels, sampleBuffer,
+                                [](double v) { return static_cast<float>(v); });
+            break;
+        default:
+            return AVERROR_PATCHWELCOME;
+    }
+
+    return samples;
+}
+
 int FFmpegDecoder::decodeNextFrame() {
     while (true) {
         // 1) First, try to receive any pending decoded frame (codec can output multiple frames per packet)
+        int64_t started = monotonicNs();
         int ret = avcodec_receive_frame(codecCtx, frame);
+        int64_t ended = monotonicNs();
+        DecoderCounters::add(counters.decodeNs, ended - started);
+        if (ret != AVERROR(EAGAIN)) TRACE_SPAN(trace.get(), "receive", started, ended);
+        if (ret == 0) DecoderCounters::add(counters.framesDecoded, 1);
+
+        // Place the frame by its timestamp: in analysis mode so skipped packets
+        // leave gaps, not shifts; after seekExact() to find where the seek landed
+        if (ret == 0 && (options.analysis || resyncPosition) && frame->best_effort_timestamp != AV_NOPTS_VALUE) {
+            AVStream* stream = formatCtx->streams[audioStreamIndex];
+            int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+            nextFramePos = av_rescale_q(frame->best_effort_timestamp - start, stream->time_base,
+                                        AVRational{1, outputSampleRate});
+            resyncPosition = false;
+        }
+
+        if (ret == 0 && options.analysis) {
+            started = monotonicNs();
+            int converted = convertNativeFrame();
+            ended = monotonicNs();
+            DecoderCounters::add(counters.resampleNs, ended - started);
+            int frames = frame->nb_samples;
+            TRACE_SPAN_ARG(trace.get(), "convert", started, ended, "frames", frames);
+            av_frame_unref(frame);
+            if (converted < 0) {
+                fail(PHASE_CONVERT, converted, "Sample conversion failed");
+                return -1;
+            }
+
+            bufferStartFrame = nextFramePos;
+            nextFramePos += frames;
+            samplesInBuffer = converted;
+            bufferReadPos = 0;
+            return samplesInBuffer;
+        }
+
         if (ret == 0) {
+            // Room for everything swr can return, so nothing backs up inside it
+            if (!ensureBufferCapacity(swr_get_out_samples(swrCtx, frame->nb_samples) * OUTPUT_CHANNELS)) {
+                av_frame_unref(frame);
+                fail(PHASE_RESAMPLE, AVERROR(ENOMEM), "Failed to grow sample buffer");
+                return -1;
+            }
+
             uint8_t* output_buffer = reinterpret_cast<uint8_t*>(sampleBuffer);
+            started = monotonicNs();
             int out_samples = swr_convert(
                 swrCtx,
                 &output_buffer,
@@ -229,9 +511,17 @@ int FFmpegDecoder::decodeNextFrame() {
                 const_cast<const uint8_t**>(frame->data),
                 frame->nb_samples
             );
+            ended = monotonicNs();
+            DecoderCounters::add(counters.resampleNs, ended - started);
+            TRACE_SPAN_ARG(trace.get(), "swr", started, ended, "frames", frame->nb_samples);
             av_frame_unref(frame);
-            if (out_samples < 0) return -1;
+            if (out_samples < 0) {
+                fail(PHASE_RESAMPLE, out_samples, "Resampling failed");
+                return -1;
+            }
 
+            bufferStartFrame = nextFramePos;
+            nextFramePos += out_samples;
             samplesInBuffer = out_samples * OUTPUT_CHANNELS;
             bufferReadPos = 0;
             return samplesInBuffer;
@@ -239,12 +529,27 @@ int FFmpegDecoder::decodeNextFrame() {
 
         if (ret == AVERROR_EOF) {
             decoderDrained = true;
+        } else if (ret == AVERROR_INVALIDDATA) {
+            // Damaged data: drop it and keep going rather than end playback
+            DecoderCounters::add(counters.corruptPackets, 1);
+            continue;
         } else if (ret != AVERROR(EAGAIN)) {
+            fail(PHASE_DECODE, ret, "Decoding failed");
             return -1;
         }
 
         // 2) If we hit decoder EOF, try draining the resampler (it can hold delayed samples)
         if (decoderDrained && !resamplerDrained) {
+            if (!swrCtx) {
+                resamplerDrained = true;
+                return 0;
+            }
+
+            if (!ensureBufferCapacity(swr_get_out_samples(swrCtx, 0) * OUTPUT_CHANNELS)) {
+                fail(PHASE_RESAMPLE, AVERROR(ENOMEM), "Failed to grow sample buffer");
+                return -1;
+            }
+
             uint8_t* output_buffer = reinterpret_cast<uint8_t*>(sampleBuffer);
             int out_samples = swr_convert(
                 swrCtx,
@@ -253,8 +558,13 @@ int FFmpegDecoder::decodeNextFrame() {
                 nullptr,
                 0
             );
-            if (out_samples < 0) return -1;
+            if (out_samples < 0) {
+                fail(PHASE_RESAMPLE, out_samples, "Resampler drain failed");
+                return -1;
+            }
             if (out_samples > 0) {
+                bufferStartFrame = nextFramePos;
+                nextFramePos += out_samples;
                 samplesInBuffer = out_samples * OUTPUT_CHANNELS;
                 bufferReadPos = 0;
                 return samplesInBuffer;
@@ -265,7 +575,20 @@ int FFmpegDecoder::decodeNextFrame() {
 
         // 3) Need more input packets (or need to flush the decoder at EOF)
         if (!eofSignaled) {
+#if FFMPEG_TRACE_ENABLED
+            // Time spent waiting on the input separates I/O stalls from demuxing
+            double blockedBefore = trace ? getIOStats().blockedTime : 0.0;
+#endif
+            started = monotonicNs();
             ret = av_read_frame(formatCtx, packet);
+            ended = monotonicNs();
+            DecoderCounters::add(counters.demuxNs, ended - started);
+#if FFMPEG_TRACE_ENABLED
+            if (trace) {
+                int64_t blockedUs = static_cast<int64_t>((getIOStats().blockedTime - blockedBefore) * 1e6);
+                TRACE_SPAN_ARG(trace.get(), "demux", started, ended, "ioBlockedUs", blockedUs);
+            }
+#endif
             if (ret < 0) {
                 if (ret == AVERROR_EOF) {
                     // Signal EOF to decoder to flush internal buffers
@@ -273,6 +596,7 @@ int FFmpegDecoder::decodeNextFrame() {
                     avcodec_send_packet(codecCtx, nullptr);
                     continue;
                 }
+                fail(PHASE_DEMUX, ret, "Reading packet failed");
                 return -1;
             }
 
@@ -281,9 +605,38 @@ int FFmpegDecoder::decodeNextFrame() {
                 continue;
             }
 
+            DecoderCounters::add(counters.packetsRead, 1);
+            DecoderCounters::add(counters.bytesIn, packet->size);
+
+            // Approximate overviews: only decode every Nth packet
+            if (options.packetStride > 1 && (packetCounter++ % options.packetStride) != 0) {
+                DecoderCounters::add(counters.skippedPackets, 1);
+                av_packet_unref(packet);
+                continue;
+            }
+
+            // Corrupt packets are flagged by the demuxer or rejected by the decoder; both are dropped
+            if (packet->flags & AV_PKT_FLAG_CORRUPT) {
+                DecoderCounters::add(counters.corruptPackets, 1);
+                av_packet_unref(packet);
+                continue;
+            }
+
+            started = monotonicNs();
+            int bytes = packet->size;
             ret = avcodec_send_packet(codecCtx, packet);
+            ended = monotonicNs();
+            DecoderCounters::add(counters.decodeNs, ended - started);
+            TRACE_SPAN_ARG(trace.get(), "send", started, ended, "bytes", bytes);
             av_packet_unref(packet);
-            if (ret < 0) return -1;
+            if (ret == AVERROR_INVALIDDATA) {
+                DecoderCounters::add(counters.corruptPackets, 1);
+                continue;
+            }
+            if (ret < 0) {
+                fail(PHASE_DECODE, ret, "Sending packet to decoder failed");
+                return -1;
+            }
             continue;
         }
 
@@ -300,6 +653,7 @@ int FFmpegDecoder::decodeNextFrame() {
 int FFmpegDecoder::read(float* outBuffer, int numSamples) {
     if (!formatCtx || !outBuffer) return 0;
     
+    int64_t started = monotonicNs();
     int totalRead = 0;
     
     while (totalRead < numSamples) {
@@ -321,9 +675,36 @@ int FFmpegDecoder::read(float* outBuffer, int numSamples) {
         totalRead += toCopy;
     }
     
+    int64_t ended = monotonicNs();
+    atomicMax(counters.maxReadNs, ended - started);
+    TRACE_SPAN_ARG(trace.get(), "read", started, ended, "samples", totalRead);
     return totalRead;
 }
 
+int FFmpegDecoder::readBlock(float* outBuffer, int numSamples, int64_t* startFrame) {
+    if (!formatCtx || !outBuffer || numSamples < outputChannels) return 0;
+
+    if (bufferReadPos >= samplesInBuffer) {
+        int64_t started = monotonicNs();
+        int decoded = decodeNextFrame();
+        int64_t ended = monotonicNs();
+        atomicMax(counters.maxReadNs, ended - started);
+        TRACE_SPAN_ARG(trace.get(), "readBlock", started, ended, "samples", decoded);
+        if (decoded <= 0) return 0;
+    }
+
+    int toCopy = std::min(samplesInBuffer - bufferReadPos, numSamples);
+    toCopy -= toCopy % outputChannels;
+
+    if (startFrame) {
+        *startFrame = bufferStartFrame + bufferReadPos / outputChannels;
+    }
+
+    memcpy(outBuffer, sampleBuffer + bufferReadPos, toCopy * sizeof(float));
+    bufferReadPos += toCopy;
+    return toCopy;
+}
+
 double FFmpegDecoder::getDuration() const {
     if (!formatCtx) return 0.0;
     
@@ -343,8 +724,129 @@ int64_t FFmpegDecoder::getTotalSamples() const {
     return static_cast<int64_t>(getDuration() * outputSampleRate);
 }
 
+bool FFmpegDecoder::useCustomIO(AVIOContext* ioCtx) {
+    formatCtx = avformat_alloc_context();
+    if (!ioCtx || !formatCtx) {
+        avformat_free_context(formatCtx);
+        formatCtx = nullptr;
+        return false;
+    }
+    formatCtx->pb = ioCtx;
+    formatCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    return true;
+}
+
+void FFmpegDecoder::releaseIO() {
+    memoryReader.reset();
+    fileReader.reset();
+}
+
+IOStats FFmpegDecoder::getIOStats() const {
+    if (fileReader) return fileReader->getStats();
+    if (memoryReader) return memoryReader->getStats();
+    if (source.stream) return source.stream->getStats();
+
+    // avformat's own I/O (URLs): only the byte count is tracked
+    IOStats stats;
+    if (formatCtx && formatCtx->pb) stats.bytesRead = formatCtx->pb->bytes_read;
+    return stats;
+}
+
+static int64_t bufferSize(const AVBufferRef* buf) {
+    return buf ? static_cast<int64_t>(buf->size) : 0;
+}
+
+DecoderMemory FFmpegDecoder::getMemoryUsage() const {
+    DecoderMemory usage;
+    usage.sampleBuffer = static_cast<int64_t>(sampleBufferSize) * sizeof(float);
+    if (trace) usage.trace = trace->memoryUsage();
+    if (source.memory) usage.source = source.memory->storage.capacity();
+
+    if (fileReader) usage.io = fileReader->memoryUsage();
+    else if (memoryReader) usage.io = memoryReader->memoryUsage();
+    else if (source.stream) usage.io = source.stream->memoryUsage();
+    else if (formatCtx && formatCtx->pb) usage.io = formatCtx->pb->buffer_size;
+
+    if (formatCtx) {
+        usage.format = sizeof(AVFormatContext);
+        for (unsigned i = 0; i < formatCtx->nb_streams; i++) {
+            AVStream* stream = formatCtx->streams[i];
+            usage.format += sizeof(AVStream) + stream->codecpar->extradata_size +
+                            static_cast<int64_t>(avformat_index_get_entries_count(stream)) * sizeof(AVIndexEntry);
+            usage.coverArt += stream->attached_pic.size;
+        }
+    }
+
+    if (codecCtx) {
+        // One frame per decoding thread is in flight with frame threading
+        int frameSamples = codecCtx->frame_size > 0 ? codecCtx->frame_size : DEFAULT_FRAME_SAMPLES;
+        int bytesPerSample = std::max(av_get_bytes_per_sample(codecCtx->sample_fmt), 1);
+        int framesInFlight = std::max(codecCtx->thread_count, 1);
+        usage.codec = sizeof(AVCodecContext) + codecCtx->extradata_size +
+                      static_cast<int64_t>(framesInFlight) * frameSamples * codecCtx->ch_layout.nb_channels * bytesPerSample;
+    }
+    if (packet) usage.codec += bufferSize(packet->buf);
+    if (frame) {
+        for (int i = 0; i < AV_NUM_DATA_POINTERS; i++) usage.codec += bufferSize(frame->buf[i]);
+    }
+
+    if (swrCtx) {
+        // Default swr filter: 32 taps x 1025 phases of float coefficients when rates differ
+        if (codecCtx && codecCtx->sample_rate != outputSampleRate) usage.resampler = 32 * 1025 * sizeof(float);
+        usage.resampler += swr_get_delay(swrCtx, outputSampleRate) * OUTPUT_CHANNELS * sizeof(float);
+    }
+    return usage;
+}
+
+void FFmpegDecoder::enableTrace(int capacity) {
+    if (!trace) trace.reset(new TraceRing(capacity));
+}
+
+bool FFmpegDecoder::fail(ErrorPhase phase, int code, const char* context) {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    lastError.code = code;
+    lastError.phase = phase;
+    lastError.message = errorString(code, context);
+    return false;
+}
+
 bool FFmpegDecoder::hasError() const {
-    return false; // TODO: Implement error tracking
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return lastError.isSet();
+}
+
+DecoderError FFmpegDecoder::getLastError() const {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return lastError;
+}
+
+void DecoderCounters::reset() {
+    for (std::atomic<int64_t>* counter : {&packetsRead, &bytesIn, &framesDecoded, &skippedPackets, &corruptPackets,
+                                          &demuxNs, &decodeNs, &resampleNs, &maxReadNs}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+}
+
+DecoderStats FFmpegDecoder::getStats() const {
+    DecoderStats stats = counters.snapshot();
+    stats.framePoolMisses = framePool.getMisses();
+    stats.framePoolHits = framePool.getRequests() - stats.framePoolMisses;
+    stats.framePoolFallbacks = framePool.getFallbacks();
+    return stats;
+}
+
+DecoderStats DecoderCounters::snapshot() const {
+    DecoderStats stats;
+    stats.packetsRead = packetsRead.load(std::memory_order_relaxed);
+    stats.bytesIn = bytesIn.load(std::memory_order_relaxed);
+    stats.framesDecoded = framesDecoded.load(std::memory_order_relaxed);
+    stats.skippedPackets = skippedPackets.load(std::memory_order_relaxed);
+    stats.corruptPackets = corruptPackets.load(std::memory_order_relaxed);
+    stats.demuxTime = demuxNs.load(std::memory_order_relaxed) / 1e9;
+    stats.decodeTime = decodeNs.load(std::memory_order_relaxed) / 1e9;
+    stats.resampleTime = resampleNs.load(std::memory_order_relaxed) / 1e9;
+    stats.maxReadLatency = maxReadNs.load(std::memory_order_relaxed) / 1e9;
+    return stats;
 }
 
 std::string FFmpegDecoder::getTag(AVDictionary* dict, const char* key) {
@@ -353,6 +855,21 @@ std::string FFmpegDecoder::getTag(AVDictionary* dict, const char* key) {
     return entry ? entry->value : "";
 }
 
+std::map<std::string, std::string> FFmpegDecoder::getTags() const {
+    std::map<std::string, std::string> tags;
+    if (!formatCtx || audioStreamIndex < 0) return tags;
+
+    // Ogg/Opus keep tags on the stream rather than the container
+    AVDictionary* dicts[2] = { formatCtx->metadata, formatCtx->streams[audioStreamIndex]->metadata };
+    for (AVDictionary* dict : dicts) {
+        const AVDictionaryEntry* entry = nullptr;
+        while (dict && (entry = av_dict_get(dict, "", entry, AV_DICT_IGNORE_SUFFIX))) {
+            tags.insert(std::make_pair(entry->key, entry->value));
+        }
+    }
+    return tags;
+}
+
 int FFmpegDecoder::parseTrackNumber(const std::string& str, int* total) {
     if (str.empty()) {
         if (total) *total = 0;
@@ -8,9 +8,104 @@ extern "C" {
 #include <libavutil/opt.h>
 }
 
+#include "io.h"
+#include "pool.h"
+#include "trace.h"
+#include "utils.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+/**
+ * Options applied when opening a decoder.
+ *
+ * Analysis mode bypasses libswresample entirely: read() returns interleaved
+ * float32 at the source sample rate and channel count, converted straight from
+ * the codec's native sample format. The flags after it trade accuracy for
+ * speed and are only honoured in analysis mode.
+ */
+struct DecoderOpenOptions {
+    bool mmap = false;          // Map local files and demux from memory (any mode; falls back to read())
+    bool analysis = false;
+    bool skipNonKey = false;    // codecCtx->skip_frame = AVDISCARD_NONKEY (where the codec supports it)
+    int packetStride = 1;       // Decode only every Nth packet (approximate overviews)
+    IOOptions io;               // Local file reads (ignored for mmap, memory and stream sources)
+};
+
+/**
+ * Where a decoder reads from: a file path/URL, or an encoded file in memory.
+ * Copyable, so workers can open a private decoder on the same input.
+ */
+struct DecoderSource {
+    std::string path;                           // Empty for memory and stream sources
+    std::shared_ptr<const MemoryBlock> memory;  // Takes precedence over path
+    std::shared_ptr<StreamReader> stream;       // Single-use: cannot be reopened by workers
+
+    bool isMemory() const { return memory != nullptr; }
+    bool isStream() const { return stream != nullptr; }
+};
+
+/**
+ * Per-instance decode counters since open(). Times are seconds.
+ */
+struct DecoderStats {
+    int64_t packetsRead = 0;        // Audio packets demuxed
+    int64_t bytesIn = 0;            // Their payload bytes
+    int64_t framesDecoded = 0;
+    int64_t skippedPackets = 0;     // packetStride
+    int64_t corruptPackets = 0;     // Rejected by the decoder and dropped
+    double demuxTime = 0.0;         // av_read_frame
+    double decodeTime = 0.0;        // avcodec_send_packet / avcodec_receive_frame
+    double resampleTime = 0.0;      // swr_convert, or sample conversion in analysis mode
+    double maxReadLatency = 0.0;    // Longest single read()/readBlock() call
+    int64_t framePoolHits = 0;      // Frame plane buffers reused from the pool
+    int64_t framePoolMisses = 0;    // ...newly allocated
+    int64_t framePoolFallbacks = 0; // Frames the codec allocated itself (no DR1 support)
+};
+
+/**
+ * Native memory held by one decoder, in bytes. FFmpeg's internal state has
+ * no size API, so format/codec/resampler are estimates from the contexts'
+ * visible buffers; the rest are exact.
+ */
+struct DecoderMemory {
+    int64_t sampleBuffer = 0;   // Decoded/resampled output waiting to be read
+    int64_t io = 0;             // AVIO buffer, prefetch/stream rings, direct-I/O bounce buffer
+    int64_t source = 0;         // Owned copy of an openBuffer() input (not mapped or borrowed memory)
+    int64_t format = 0;         // Demuxer contexts, extradata, seek index
+    int64_t coverArt = 0;       // Attached pictures held by the demuxer
+    int64_t codec = 0;          // Codec context, in-flight packet/frame buffers
+    int64_t resampler = 0;      // Filter bank and delayed samples in libswresample
+    int64_t trace = 0;          // Trace ring (trace builds)
+
+    int64_t total() const {
+        return sampleBuffer + io + source + format + coverArt + codec + resampler + trace;
+    }
+};
+
+// Lock-free, so stats can be sampled while another thread decodes
+class DecoderCounters {
+public:
+    std::atomic<int64_t> packetsRead{0};
+    std::atomic<int64_t> bytesIn{0};
+    std::atomic<int64_t> framesDecoded{0};
+    std::atomic<int64_t> skippedPackets{0};
+    std::atomic<int64_t> corruptPackets{0};
+    std::atomic<int64_t> demuxNs{0};
+    std::atomic<int64_t> decodeNs{0};
+    std::atomic<int64_t> resampleNs{0};
+    std::atomic<int64_t> maxReadNs{0};
+
+    static void add(std::atomic<int64_t>& counter, int64_t value) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+    void reset();
+    DecoderStats snapshot() const;
+};
+
 /**
  * FFmpegDecoder - High-performance audio decoder using FFmpeg libraries
  * 
@@ -19,6 +114,7 @@ extern "C" {
  * - Instant seeking via av_seek_frame()
  * - Streams samples on-demand for real-time playback
  * - Output: float32 stereo at 44.1kHz (via libswresample)
+ * - Analysis mode: native rate/channels without resampling
  */
 class FFmpegDecoder {
 private:
@@ -40,6 +136,15 @@ private:
     bool decoderDrained;
     bool resamplerDrained;
 
+    // Output position (in frames) of sampleBuffer[0]
+    int64_t bufferStartFrame;
+    int64_t nextFramePos;
+    bool resyncPosition;      // Take nextFramePos from the next frame's timestamp (seekExact)
+
+    // Analysis mode state
+    DecoderOpenOptions options;
+    int64_t packetCounter;
+
     // Metadata helpers
     static std::string getTag(AVDictionary* dict, const char* key);
     static int parseTrackNumber(const std::string& str, int* total);
@@ -47,30 +152,65 @@ private:
     // Output format (per-instance sample rate, fixed stereo)
     static const int DEFAULT_OUTPUT_SAMPLE_RATE = 44100;
     static const int OUTPUT_CHANNELS = 2;
+    static const int DEFAULT_FRAME_SAMPLES = 4096;     // Initial staging size for variable frame size codecs
 
     int outputSampleRate;
+    int outputChannels;
     int threadCount;
+    DecoderSource source;
+    std::unique_ptr<MemoryReader> memoryReader;     // Custom AVIO for memory sources
+    std::unique_ptr<FileReader> fileReader;         // Custom AVIO for local files
+    
+    bool useCustomIO(AVIOContext* ioCtx);
+    void releaseIO();
+
+    // Error reporting and telemetry
+    DecoderError lastError;
+    mutable std::mutex errorMutex;      // lastError only; readable while decoding
+    DecoderCounters counters;
+    FramePool framePool;                // get_buffer2 allocator; outlives each codec context
+    std::unique_ptr<TraceRing> trace;   // Null unless enableTrace() (trace builds only record)
+
+    bool fail(ErrorPhase phase, int code, const char* context);
     
     bool initResampler();
+    bool ensureBufferCapacity(int samples);
+    int convertNativeFrame();
     int decodeNextFrame();
     void flushBuffers();
+    void resetAfterSeek(int64_t frame);
     
 public:
     FFmpegDecoder();
     ~FFmpegDecoder();
     
     // Lifecycle
-    bool open(const char* filePath, int outSampleRate = DEFAULT_OUTPUT_SAMPLE_RATE, int threads = 0);
+    bool open(const char* filePath, int outSampleRate = DEFAULT_OUTPUT_SAMPLE_RATE, int threads = 0,
+              const DecoderOpenOptions& openOptions = DecoderOpenOptions());
+    bool open(const DecoderSource& input, int outSampleRate = DEFAULT_OUTPUT_SAMPLE_RATE, int threads = 0,
+              const DecoderOpenOptions& openOptions = DecoderOpenOptions());
     void close();
     
     // Playback
     bool seek(double seconds);
+
+    // Positions the next read() at output frame `frame` exactly: seeks to the
+    // packet before it, decodes forward and drops the samples that precede it.
+    // Decoders seeked to the same frame stay sample-aligned, whatever their
+    // packet boundaries. Slower than seek() by the decode from the packet.
+    bool seekExact(int64_t frame);
     int read(float* outBuffer, int numSamples);
+
+    // Reads from the current decoded frame only (never crosses a frame boundary)
+    // and reports the output frame position of the first returned sample, so
+    // callers can place data correctly when packets are skipped.
+    int readBlock(float* outBuffer, int numSamples, int64_t* startFrame);
     
     // Metadata
     double getDuration() const;
     int getSampleRate() const { return outputSampleRate; }
-    int getChannels() const { return OUTPUT_CHANNELS; }
+    int getThreadCount() const { return threadCount; }
+    int getChannels() const { return outputChannels; }
     int64_t getTotalSamples() const;
 
     struct AudioMetadata {
@@ -101,11 +241,31 @@ public:
     };
 
     AudioMetadata getMetadata() const;
+
+    // All container and audio stream tags, raw (container wins on duplicates)
+    std::map<std::string, std::string> getTags() const;
     static AudioMetadata getFileMetadata(const char* filePath);
     
     // Status
     bool isOpen() const { return formatCtx != nullptr; }
+    const std::string& getSourcePath() const { return source.path; }
+    const DecoderSource& getSource() const { return source; }
+    const DecoderOpenOptions& getOpenOptions() const { return options; }
+    bool isAnalysisMode() const { return options.analysis; }
+    IOStats getIOStats() const;
+    DecoderStats getStats() const;
+
+    // Not thread-safe: call from the thread that owns the decoder
+    DecoderMemory getMemoryUsage() const;
+
+    // Timeline of demux/decode/resample/read/seek spans. Call before decoding
+    // starts; trace points are compiled out unless FFMPEG_TRACE_ENABLED.
+    void enableTrace(int capacity = TraceRing::DEFAULT_CAPACITY);
+    TraceRing* getTrace() const { return trace.get(); }
+
+    // Most recent failure since open() (code 0 if none)
     bool hasError() const;
+    DecoderError getLastError() const;
 };
 
 #endif // FFMPEG_DECODER_H
@@ -0,0 +1,258 @@
+#include "detector.h"
+#include "decoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const int READ_CHUNK_FRAMES = 16384;
+
+// Log compression applied to magnitudes before differencing
+static const float FLUX_COMPRESSION = 100.0f;
+
+// Peak picking neighbourhood, in blocks (10 ms each)
+static const int PEAK_RADIUS = 3;
+static const int MEAN_BEFORE = 10;
+
+bool SegmentDetector::init(const Options& options, int numChannels, int rate) {
+    if (numChannels <= 0 || rate < 1000) return false;
+    if (options.minSilenceDuration < 0.0 || options.minOnsetInterval < 0.0) return false;
+
+    opts = options;
+    channels = numChannels;
+    sampleRate = rate;
+    blockFrames = rate / 100;
+    blockPos = 0;
+    totalFrames = 0;
+
+    thresholdLinear = static_cast<float>(std::pow(10.0, opts.silenceThreshold / 20.0));
+    blockSumSq = 0.0;
+    firstLoud = -1;
+    lastLoud = -1;
+
+    silenceStart = 0;
+    minSilenceFrames = static_cast<int64_t>(opts.minSilenceDuration * rate);
+    gaps.clear();
+
+    // Window spans at least two blocks so consecutive frames overlap
+    int size = 16;
+    while (size < blockFrames * 2) size <<= 1;
+    if (!fft.init(size)) return false;
+
+    window.resize(size);
+    for (int i = 0; i < size; i++) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / size));
+    }
+    history.assign(size, 0.0f);
+    frameBuf.resize(size);
+    binRe.resize(size / 2 + 1);
+    binIm.resize(size / 2 + 1);
+    prevLogMag.assign(size / 2 + 1, 0.0f);
+    flux.clear();
+    loudBlocks.clear();
+    return true;
+}
+
+void SegmentDetector::process(const float* samples, int frames) {
+    if (blockFrames <= 0 || !samples || frames <= 0) return;
+
+    const float gain = 1.0f / channels;
+    const int size = fft.size();
+
+    int offset = 0;
+    while (offset < frames) {
+        int take = std::min(blockFrames - blockPos, frames - offset);
+        const float* p = samples + static_cast<size_t>(offset) * channels;
+        float* mono = history.data() + (size - blockFrames) + blockPos;
+
+        float peak = 0.0f;
+        double sq = 0.0;
+        for (int i = 0; i < take; i++) {
+            const float* f = p + static_cast<size_t>(i) * channels;
+            float sum = 0.0f;
+            for (int c = 0; c < channels; c++) {
+                sum += f[c];
+                sq += static_cast<double>(f[c]) * f[c];
+                peak = std::max(peak, std::fabs(f[c]));
+            }
+            mono[i] = sum * gain;
+        }
+
+        // Only segments that cross the threshold are scanned for exact boundaries
+        if (peak > thresholdLinear) {
+            const int64_t base = totalFrames + offset;
+            for (int i = 0; i < take && firstLoud < 0; i++) {
+                const float* f = p + static_cast<size_t>(i) * channels;
+                for (int c = 0; c < channels; c++) {
+                    if (std::fabs(f[c]) > thresholdLinear) {
+                        firstLoud = base + i;
+                        break;
+                    }
+                }
+            }
+            for (int i = take - 1; i >= 0; i--) {
+                const float* f = p + static_cast<size_t>(i) * channels;
+                bool loud = false;
+                for (int c = 0; c < channels; c++) {
+                    if (std::fabs(f[c]) > thresholdLinear) loud = true;
+                }
+                if (loud) {
+                    lastLoud = base + i;
+                    break;
+                }
+            }
+        }
+
+        blockSumSq += sq;
+        blockPos += take;
+        offset += take;
+
+        if (blockPos == blockFrames) {
+            finishBlock(blockFrames);
+        }
+    }
+
+    totalFrames += frames;
+}
+
+void SegmentDetector::finishBlock(int frames) {
+    const int64_t start = static_cast<int64_t>(flux.size()) * blockFrames;
+    const double meanSq = blockSumSq / (static_cast<double>(frames) * channels);
+    const bool loud = meanSq > 0.0 && 10.0 * std::log10(meanSq) >= opts.silenceThreshold;
+
+    if (loud) {
+        if (silenceStart > 0 && start - silenceStart >= minSilenceFrames) {
+            gaps.push_back({ static_cast<double>(silenceStart) / sampleRate, static_cast<double>(start) / sampleRate });
+        }
+        silenceStart = -1;
+    } else if (silenceStart < 0) {
+        silenceStart = start;
+    }
+
+    if (opts.onsets) {
+        const int size = fft.size();
+        if (frames < blockFrames) {
+            // Partial last block: zero the unfilled tail
+            std::fill(history.begin() + (size - blockFrames) + frames, history.end(), 0.0f);
+        }
+
+        for (int i = 0; i < size; i++) {
+            frameBuf[i] = history[i] * window[i];
+        }
+        fft.forward(frameBuf.data(), binRe.data(), binIm.data());
+
+        float sum = 0.0f;
+        const int bins = size / 2 + 1;
+        for (int k = 0; k < bins; k++) {
+            float logMag = std::log1p(FLUX_COMPRESSION * std::sqrt(binRe[k] * binRe[k] + binIm[k] * binIm[k]));
+            float diff = logMag - prevLogMag[k];
+            if (diff > 0.0f) sum += diff;
+            prevLogMag[k] = logMag;
+        }
+        flux.push_back(sum);
+    } else {
+        flux.push_back(0.0f);
+    }
+    loudBlocks.push_back(loud ? 1 : 0);
+
+    // Slide the analysis window by one block
+    const int size = fft.size();
+    memmove(history.data(), history.data() + blockFrames, (size - blockFrames) * sizeof(float));
+
+    blockSumSq = 0.0;
+    blockPos = 0;
+}
+
+void SegmentDetector::finish() {
+    if (blockPos > 0) {
+        finishBlock(blockPos);
+    }
+}
+
+bool SegmentDetector::analyze(FFmpegDecoder& decoder) {
+    if (!decoder.isOpen() || decoder.getChannels() != channels) return false;
+
+    std::vector<float> chunk(static_cast<size_t>(READ_CHUNK_FRAMES) * channels);
+    while (true) {
+        int samplesRead = decoder.read(chunk.data(), static_cast<int>(chunk.size()));
+        if (samplesRead <= 0) break;
+        process(chunk.data(), samplesRead / channels);
+    }
+
+    // A read error also ends the loop; segments past it were never seen
+    finish();
+    return !decoder.hasError();
+}
+
+void SegmentDetector::pickOnsets(Result& out) const {
+    const int count = static_cast<int>(flux.size());
+    if (count < 3) return;
+
+    // Normalize to zero mean / unit variance so the threshold is level independent
+    double mean = 0.0;
+    for (float v : flux) mean += v;
+    mean /= count;
+    double var = 0.0;
+    for (float v : flux) var += (v - mean) * (v - mean);
+    double stddev = std::sqrt(var / count);
+    if (stddev <= 0.0) return;
+
+    std::vector<float> norm(count);
+    for (int i = 0; i < count; i++) {
+        norm[i] = static_cast<float>((flux[i] - mean) / stddev);
+    }
+
+    const int64_t minInterval = static_cast<int64_t>(opts.minOnsetInterval * sampleRate);
+    int64_t lastOnset = -minInterval - 1;
+
+    for (int n = 0; n < count; n++) {
+        if (!loudBlocks[n]) continue;
+
+        // Local maximum over +-PEAK_RADIUS blocks
+        bool isPeak = true;
+        for (int j = std::max(0, n - PEAK_RADIUS); j <= std::min(count - 1, n + PEAK_RADIUS) && isPeak; j++) {
+            if (norm[j] > norm[n]) isPeak = false;
+        }
+        if (!isPeak) continue;
+
+        // Above the local mean (mostly the past) by the threshold
+        int lo = std::max(0, n - MEAN_BEFORE);
+        int hi = std::min(count - 1, n + PEAK_RADIUS);
+        double localMean = 0.0;
+        for (int j = lo; j <= hi; j++) localMean += norm[j];
+        localMean /= (hi - lo + 1);
+        if (norm[n] < localMean + opts.onsetThreshold) continue;
+
+        int64_t position = static_cast<int64_t>(n) * blockFrames;
+        if (position - lastOnset < minInterval) continue;
+
+        out.onsets.push_back(static_cast<double>(position) / sampleRate);
+        lastOnset = position;
+    }
+}
+
+SegmentDetector::Result SegmentDetector::result() const {
+    Result out;
+    if (sampleRate <= 0) return out;
+
+    out.duration = static_cast<double>(totalFrames) / sampleRate;
+    if (firstLoud >= 0) {
+        out.audioStart = static_cast<double>(firstLoud) / sampleRate;
+        out.audioEnd = static_cast<double>(lastLoud + 1) / sampleRate;
+    }
+
+    // Gaps touching the audible range boundaries are leading/trailing silence, not gaps
+    for (const Segment& gap : gaps) {
+        if (gap.start >= out.audioStart && gap.end <= out.audioEnd) {
+            out.silences.push_back(gap);
+        }
+    }
+
+    if (opts.onsets) {
+        pickOnsets(out);
+    }
+    return out;
+}
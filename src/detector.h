@@ -0,0 +1,84 @@
+#ifndef FFMPEG_DETECTOR_H
+#define FFMPEG_DETECTOR_H
+
+#include "spectrum.h"
+#include <cstdint>
+#include <vector>
+
+class FFmpegDecoder;
+
+/**
+ * SegmentDetector - Silence and onset detection over a decoded stream
+ *
+ * Works on 10 ms blocks:
+ * - Leading/trailing silence: sample-accurate first/last sample above the threshold
+ * - Silence gaps: runs of blocks whose RMS is below the threshold
+ * - Onsets: peaks of the log-magnitude spectral flux (mono mixdown)
+ */
+class SegmentDetector {
+public:
+    struct Options {
+        double silenceThreshold = -60.0;    // dBFS
+        double minSilenceDuration = 0.5;    // Seconds, for gaps between audio
+        bool onsets = true;
+        double onsetThreshold = 1.0;        // Std deviations above the local mean of the flux
+        double minOnsetInterval = 0.05;     // Seconds
+    };
+
+    struct Segment {
+        double start;
+        double end;
+    };
+
+    struct Result {
+        double duration = 0.0;
+        double audioStart = 0.0;            // End of leading silence
+        double audioEnd = 0.0;              // Start of trailing silence
+        std::vector<Segment> silences;      // Gaps between audio, in order
+        std::vector<double> onsets;         // Seconds
+    };
+
+    bool init(const Options& options, int channels, int sampleRate);
+    void process(const float* samples, int frames);
+
+    // Evaluates the trailing partial block; call once after the last process()
+    void finish();
+
+    // Reads the decoder until EOF and finishes; false on a decode error
+    bool analyze(FFmpegDecoder& decoder);
+
+    Result result() const;
+
+private:
+    void finishBlock(int frames);
+    void pickOnsets(Result& out) const;
+
+    Options opts;
+    int channels = 0;
+    int sampleRate = 0;
+    int blockFrames = 0;                    // 10 ms
+    int blockPos = 0;
+    int64_t totalFrames = 0;
+
+    float thresholdLinear = 0.0f;
+    double blockSumSq = 0.0;
+    int64_t firstLoud = -1;
+    int64_t lastLoud = -1;
+
+    int64_t silenceStart = 0;               // -1 while in audio
+    int64_t minSilenceFrames = 0;
+    std::vector<Segment> gaps;
+
+    // Onset detection function, one value per block
+    RealFFT fft;
+    std::vector<float> window;
+    std::vector<float> history;             // Last fftSize mono samples
+    std::vector<float> frameBuf;
+    std::vector<float> binRe;
+    std::vector<float> binIm;
+    std::vector<float> prevLogMag;
+    std::vector<float> flux;
+    std::vector<uint8_t> loudBlocks;
+};
+
+#endif // FFMPEG_DETECTOR_H
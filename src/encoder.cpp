@@ -0,0 +1,457 @@
+#include "encoder.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+// Batch size for codecs without a fixed frame size (PCM, variable-frame-size encoders)
+static const int DEFAULT_BATCH_FRAMES = 4096;
+
+static std::string toLower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+static std::string fileExtension(const char* filePath) {
+    const char* dot = strrchr(filePath, '.');
+    const char* slash = strrchr(filePath, '/');
+    if (!dot || (slash && dot < slash)) return std::string();
+    return toLower(dot + 1);
+}
+
+// Picks the codec format closest to float32 input at the requested bit depth
+static AVSampleFormat chooseSampleFormat(const AVCodec* codec, int bitDepth) {
+    const void* configs = nullptr;
+    int count = 0;
+    // No list means any format is accepted (replaces the deprecated AVCodec::sample_fmts)
+    if (avcodec_get_supported_config(nullptr, codec, AV_CODEC_CONFIG_SAMPLE_FORMAT, 0, &configs, &count) < 0 ||
+        !configs || count <= 0) {
+        return AV_SAMPLE_FMT_FLT;
+    }
+    const AVSampleFormat* supported = static_cast<const AVSampleFormat*>(configs);
+
+    static const AVSampleFormat PREFER_FLOAT[] = { AV_SAMPLE_FMT_FLT, AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_S16P };
+    static const AVSampleFormat PREFER_S32[] = { AV_SAMPLE_FMT_S32, AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_FLT, AV_SAMPLE_FMT_FLTP };
+    const AVSampleFormat* preferred = bitDepth > 16 ? PREFER_S32 : PREFER_FLOAT;
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < count; j++) {
+            if (supported[j] == preferred[i]) return supported[j];
+        }
+    }
+    return supported[0];
+}
+
+// Requested rate if supported, else the next higher supported rate, else the highest
+static int chooseSampleRate(const AVCodec* codec, int requested) {
+    const void* configs = nullptr;
+    int count = 0;
+    if (avcodec_get_supported_config(nullptr, codec, AV_CODEC_CONFIG_SAMPLE_RATE, 0, &configs, &count) < 0 ||
+        !configs || count <= 0) {
+        return requested;
+    }
+    const int* supported = static_cast<const int*>(configs);
+
+    int best = 0;
+    int highest = 0;
+    for (int i = 0; i < count; i++) {
+        int rate = supported[i];
+        if (rate == requested) return requested;
+        if (rate > requested && (best == 0 || rate < best)) best = rate;
+        highest = std::max(highest, rate);
+    }
+    return best > 0 ? best : highest;
+}
+
+FFmpegEncoder::FFmpegEncoder()
+    : formatCtx(nullptr)
+    , codecCtx(nullptr)
+    , stream(nullptr)
+    , swrCtx(nullptr)
+    , fifo(nullptr)
+    , frame(nullptr)
+    , packet(nullptr)
+    , convertCapacity(0)
+    , inputSampleRate(0)
+    , inputChannels(0)
+    , frameSize(0)
+    , nextPts(0)
+    , framesWritten(0)
+    , headerWritten(false)
+    , passthrough(false)
+{
+    packet = av_packet_alloc();
+    frame = av_frame_alloc();
+}
+
+FFmpegEncoder::~FFmpegEncoder() {
+    // Finalize the file so a dropped encoder still leaves a playable output
+    if (isOpen()) close();
+    if (packet) av_packet_free(&packet);
+    if (frame) av_frame_free(&frame);
+}
+
+const AVCodec* FFmpegEncoder::findEncoder(const std::string& name) {
+    std::string key = toLower(name);
+
+    if (key == "flac") return avcodec_find_encoder(AV_CODEC_ID_FLAC);
+    if (key == "wav" || key == "pcm") return avcodec_find_encoder(AV_CODEC_ID_PCM_S16LE);
+    if (key == "aac" || key == "m4a") return avcodec_find_encoder(AV_CODEC_ID_AAC);
+
+    if (key == "mp3") {
+        const AVCodec* lame = avcodec_find_encoder_by_name("libmp3lame");
+        return lame ? lame : avcodec_find_encoder(AV_CODEC_ID_MP3);
+    }
+
+    if (key == "opus") {
+        // libopus is preferred; the native encoder is experimental
+        const AVCodec* libopus = avcodec_find_encoder_by_name("libopus");
+        return libopus ? libopus : avcodec_find_encoder(AV_CODEC_ID_OPUS);
+    }
+
+    if (key == "vorbis" || key == "ogg") {
+        // libvorbis is preferred; the native encoder is experimental
+        const AVCodec* libvorbis = avcodec_find_encoder_by_name("libvorbis");
+        return libvorbis ? libvorbis : avcodec_find_encoder(AV_CODEC_ID_VORBIS);
+    }
+
+    return avcodec_find_encoder_by_name(key.c_str());
+}
+
+bool FFmpegEncoder::open(const char* filePath, const EncoderOptions& options) {
+    if (isOpen()) close();
+    if (!filePath || options.sampleRate <= 0 || options.channels <= 0) return false;
+
+    inputSampleRate = options.inputSampleRate > 0 ? options.inputSampleRate : options.sampleRate;
+    inputChannels = options.inputChannels > 0 ? options.inputChannels : options.channels;
+
+    // Create output context (muxer from format name or file extension)
+    const char* formatName = options.format.empty() ? nullptr : options.format.c_str();
+    if (avformat_alloc_output_context2(&formatCtx, nullptr, formatName, filePath) < 0 || !formatCtx) {
+        formatCtx = nullptr;
+        return false;
+    }
+
+    if (!openCodec(filePath, options)) {
+        cleanup();
+        return false;
+    }
+
+    // Create stream
+    stream = avformat_new_stream(formatCtx, nullptr);
+    if (!stream || avcodec_parameters_from_context(stream->codecpar, codecCtx) < 0) {
+        cleanup();
+        return false;
+    }
+    stream->time_base = codecCtx->time_base;
+
+    for (const auto& tag : options.metadata) {
+        av_dict_set(&formatCtx->metadata, tag.first.c_str(), tag.second.c_str(), 0);
+    }
+
+    // Open output file
+    if (!(formatCtx->oformat->flags & AVFMT_NOFILE)) {
+        if (avio_open(&formatCtx->pb, filePath, AVIO_FLAG_WRITE) < 0) {
+            cleanup();
+            return false;
+        }
+    }
+
+    if (avformat_write_header(formatCtx, nullptr) < 0) {
+        return discardOutput(filePath);
+    }
+    headerWritten = true;
+
+    // Reusable frame holding one encoder frame of samples
+    frame->nb_samples = frameSize;
+    frame->format = codecCtx->sample_fmt;
+    frame->sample_rate = codecCtx->sample_rate;
+    if (av_channel_layout_copy(&frame->ch_layout, &codecCtx->ch_layout) < 0 || av_frame_get_buffer(frame, 0) < 0) {
+        return discardOutput(filePath);
+    }
+
+    fifo = av_audio_fifo_alloc(codecCtx->sample_fmt, codecCtx->ch_layout.nb_channels, frameSize * 2);
+    if (!fifo) {
+        return discardOutput(filePath);
+    }
+
+    passthrough = codecCtx->sample_fmt == AV_SAMPLE_FMT_FLT &&
+                  codecCtx->sample_rate == inputSampleRate &&
+                  codecCtx->ch_layout.nb_channels == inputChannels;
+    if (!passthrough && !initResampler()) {
+        return discardOutput(filePath);
+    }
+
+    nextPts = 0;
+    framesWritten = 0;
+    return true;
+}
+
+bool FFmpegEncoder::openCodec(const char* filePath, const EncoderOptions& options) {
+    std::string name = options.codec.empty() ? fileExtension(filePath) : options.codec;
+
+    const AVCodec* codec = name.empty() ? nullptr : findEncoder(name);
+    if (!codec && options.codec.empty()) {
+        // Unknown extension: fall back to the muxer's default audio codec
+        codec = avcodec_find_encoder(formatCtx->oformat->audio_codec);
+    }
+    if (!codec) return false;
+
+    if (codec->id == AV_CODEC_ID_PCM_S16LE && options.bitDepth > 16) {
+        codec = avcodec_find_encoder(AV_CODEC_ID_PCM_S24LE);
+        if (!codec) return false;
+    }
+
+    codecCtx = avcodec_alloc_context3(codec);
+    if (!codecCtx) return false;
+
+    codecCtx->sample_fmt = chooseSampleFormat(codec, options.bitDepth);
+    codecCtx->sample_rate = chooseSampleRate(codec, options.sampleRate);
+    av_channel_layout_default(&codecCtx->ch_layout, options.channels);
+    codecCtx->time_base = AVRational{1, codecCtx->sample_rate};
+
+    if (options.bitrate > 0) {
+        codecCtx->bit_rate = options.bitrate;
+    }
+
+    if (options.quality >= 0) {
+        switch (codec->id) {
+            case AV_CODEC_ID_FLAC:
+            case AV_CODEC_ID_OPUS:
+                // FLAC: compression level 0-12; Opus: encoder complexity 0-10
+                codecCtx->compression_level = options.quality;
+                break;
+            case AV_CODEC_ID_MP3:
+                // LAME VBR: 0 = best (V0) ... 9 = smallest (V9)
+                codecCtx->flags |= AV_CODEC_FLAG_QSCALE;
+                codecCtx->global_quality = FF_QP2LAMBDA * options.quality;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (codec->id == AV_CODEC_ID_FLAC && options.bitDepth > 16) {
+        codecCtx->bits_per_raw_sample = 24;
+    }
+
+    if (options.threads > 0) {
+        codecCtx->thread_count = options.threads;
+    }
+
+    // Native Opus encoder fallback
+    codecCtx->strict_std_compliance = FF_COMPLIANCE_EXPERIMENTAL;
+
+    if (formatCtx->oformat->flags & AVFMT_GLOBALHEADER) {
+        codecCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    if (avcodec_open2(codecCtx, codec, nullptr) < 0) return false;
+
+    frameSize = codecCtx->frame_size;
+    if (frameSize <= 0 || (codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE)) {
+        frameSize = DEFAULT_BATCH_FRAMES;
+    }
+    return true;
+}
+
+bool FFmpegEncoder::initResampler() {
+    AVChannelLayout in_ch_layout;
+    av_channel_layout_default(&in_ch_layout, inputChannels);
+
+    int ret = swr_alloc_set_opts2(
+        &swrCtx,
+        &codecCtx->ch_layout,          // Output channel layout
+        codecCtx->sample_fmt,          // Output sample format (codec native)
+        codecCtx->sample_rate,         // Output sample rate
+        &in_ch_layout,                 // Input channel layout
+        AV_SAMPLE_FMT_FLT,             // Input sample format (float32)
+        inputSampleRate,               // Input sample rate
+        0, nullptr
+    );
+    av_channel_layout_uninit(&in_ch_layout);
+
+    if (ret < 0 || !swrCtx) {
+        return false;
+    }
+
+    if (swr_init(swrCtx) < 0) {
+        swr_free(&swrCtx);
+        return false;
+    }
+
+    return true;
+}
+
+bool FFmpegEncoder::ensureConvertCapacity(int frames) {
+    if (frames <= convertCapacity) return true;
+
+    const int channels = codecCtx->ch_layout.nb_channels;
+    const bool planar = av_sample_fmt_is_planar(codecCtx->sample_fmt) != 0;
+    const int planes = planar ? channels : 1;
+    const size_t planeBytes = static_cast<size_t>(frames) * av_get_bytes_per_sample(codecCtx->sample_fmt) *
+                              (planar ? 1 : channels);
+
+    convertPlanes.resize(planes);
+    convertData.resize(planes);
+    for (int p = 0; p < planes; p++) {
+        convertPlanes[p].resize(planeBytes);
+        convertData[p] = convertPlanes[p].data();
+    }
+    convertCapacity = frames;
+    return true;
+}
+
+bool FFmpegEncoder::write(const float* samples, int numSamples) {
+    if (!isOpen() || !samples) return false;
+
+    const int frames = numSamples / inputChannels;
+    if (frames <= 0) return true;
+
+    if (passthrough) {
+        void* data = const_cast<float*>(samples);
+        if (av_audio_fifo_write(fifo, &data, frames) < frames) return false;
+    } else {
+        int capacity = swr_get_out_samples(swrCtx, frames);
+        if (capacity < 0 || !ensureConvertCapacity(capacity)) return false;
+
+        const uint8_t* input = reinterpret_cast<const uint8_t*>(samples);
+        int converted = swr_convert(swrCtx, convertData.data(), capacity, &input, frames);
+        if (converted < 0) return false;
+
+        if (converted > 0 &&
+            av_audio_fifo_write(fifo, reinterpret_cast<void**>(convertData.data()), converted) < converted) {
+            return false;
+        }
+    }
+    framesWritten += frames;
+
+    // Encode whole frames; the remainder waits for the next write()
+    while (av_audio_fifo_size(fifo) >= frameSize) {
+        if (!encodeFromFifo(frameSize)) return false;
+    }
+    return true;
+}
+
+bool FFmpegEncoder::encodeFromFifo(int frames) {
+    // The encoder may still reference the previous buffer; this reallocates only then
+    frame->nb_samples = frameSize;
+    if (av_frame_make_writable(frame) < 0) return false;
+
+    frame->nb_samples = frames;
+    if (av_audio_fifo_read(fifo, reinterpret_cast<void**>(frame->extended_data), frames) < frames) {
+        return false;
+    }
+
+    frame->pts = nextPts;
+    nextPts += frames;
+    return sendFrame(frame);
+}
+
+bool FFmpegEncoder::sendFrame(AVFrame* input) {
+    if (avcodec_send_frame(codecCtx, input) < 0) return false;
+
+    while (true) {
+        int ret = avcodec_receive_packet(codecCtx, packet);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return true;
+        if (ret < 0) return false;
+
+        av_packet_rescale_ts(packet, codecCtx->time_base, stream->time_base);
+        packet->stream_index = stream->index;
+
+        // Takes ownership of the packet data and leaves packet blank for reuse
+        if (av_interleaved_write_frame(formatCtx, packet) < 0) return false;
+    }
+}
+
+bool FFmpegEncoder::close() {
+    if (!isOpen()) return false;
+
+    bool ok = headerWritten;
+
+    // Drain samples held back by the resampler
+    if (ok && swrCtx) {
+        while (true) {
+            int capacity = swr_get_out_samples(swrCtx, 0);
+            if (capacity <= 0 || !ensureConvertCapacity(capacity)) break;
+
+            int converted = swr_convert(swrCtx, convertData.data(), capacity, nullptr, 0);
+            if (converted <= 0) break;
+            if (av_audio_fifo_write(fifo, reinterpret_cast<void**>(convertData.data()), converted) < converted) {
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    // Last (possibly short) frames, then flush the encoder
+    while (ok && fifo && av_audio_fifo_size(fifo) > 0) {
+        ok = encodeFromFifo(std::min(av_audio_fifo_size(fifo), frameSize));
+    }
+    if (ok) {
+        ok = sendFrame(nullptr);
+    }
+
+    if (headerWritten && av_write_trailer(formatCtx) < 0) {
+        ok = false;
+    }
+
+    cleanup();
+    return ok;
+}
+
+// Failure after the output file was created: drop the partial file
+bool FFmpegEncoder::discardOutput(const char* filePath) {
+    bool created = formatCtx && formatCtx->pb && !(formatCtx->oformat->flags & AVFMT_NOFILE);
+    cleanup();
+    if (created) std::remove(filePath);
+    return false;
+}
+
+void FFmpegEncoder::cleanup() {
+    if (swrCtx) {
+        swr_free(&swrCtx);
+        swrCtx = nullptr;
+    }
+
+    if (fifo) {
+        av_audio_fifo_free(fifo);
+        fifo = nullptr;
+    }
+
+    if (codecCtx) {
+        avcodec_free_context(&codecCtx);
+        codecCtx = nullptr;
+    }
+
+    if (formatCtx) {
+        if (formatCtx->pb && !(formatCtx->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&formatCtx->pb);
+        }
+        avformat_free_context(formatCtx);
+        formatCtx = nullptr;
+    }
+
+    if (frame) av_frame_unref(frame);
+    if (packet) av_packet_unref(packet);
+
+    stream = nullptr;
+    convertPlanes.clear();
+    convertData.clear();
+    convertCapacity = 0;
+    frameSize = 0;
+    headerWritten = false;
+    passthrough = false;
+}
+
+int FFmpegEncoder::getSampleRate() const {
+    return codecCtx ? codecCtx->sample_rate : 0;
+}
+
+int FFmpegEncoder::getChannels() const {
+    return codecCtx ? codecCtx->ch_layout.nb_channels : 0;
+}
+
+std::string FFmpegEncoder::getCodecName() const {
+    return (codecCtx && codecCtx->codec) ? codecCtx->codec->name : "";
+}
@@ -0,0 +1,100 @@
+#ifndef FFMPEG_ENCODER_H
+#define FFMPEG_ENCODER_H
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswresample/swresample.h>
+#include <libavutil/audio_fifo.h>
+#include <libavutil/opt.h>
+}
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Options applied when opening an encoder.
+ *
+ * Input to write() is interleaved float32 at inputSampleRate/inputChannels
+ * (0 = same as the output), which is what FFmpegDecoder::read() produces.
+ */
+struct EncoderOptions {
+    std::string codec;              // "flac", "opus", "aac", "mp3", "vorbis", "wav"; empty = from the file extension
+    std::string format;             // Muxer name; empty = from the file extension
+    int sampleRate = 44100;         // Output rate (snapped to the nearest rate the codec supports)
+    int channels = 2;
+    int inputSampleRate = 0;
+    int inputChannels = 0;
+    int bitrate = 0;                // bits/s for lossy codecs; 0 = codec default
+    int quality = -1;               // Codec-specific quality (0-10, FLAC 0-12); -1 = codec default
+    int bitDepth = 16;              // FLAC/WAV: 16 or 24
+    int threads = 0;
+    std::map<std::string, std::string> metadata;
+};
+
+/**
+ * FFmpegEncoder - In-process audio encoder using FFmpeg libraries
+ *
+ * Features:
+ * - FLAC, Opus, AAC, MP3 and WAV (PCM) into their usual containers
+ * - Streaming write() of interleaved float32, converted with libswresample
+ * - Frame-size batching through an AVAudioFifo
+ * - One AVFrame/AVPacket reused for the whole stream
+ */
+class FFmpegEncoder {
+private:
+    AVFormatContext* formatCtx;
+    AVCodecContext* codecCtx;
+    AVStream* stream;
+    SwrContext* swrCtx;
+    AVAudioFifo* fifo;
+    AVFrame* frame;
+    AVPacket* packet;
+
+    // Converted samples (codec format) before they enter the FIFO
+    std::vector<std::vector<uint8_t>> convertPlanes;
+    std::vector<uint8_t*> convertData;
+    int convertCapacity;            // In frames
+
+    int inputSampleRate;
+    int inputChannels;
+    int frameSize;                  // Samples per encoded frame
+    int64_t nextPts;
+    int64_t framesWritten;          // Input frames accepted
+    bool headerWritten;
+    bool passthrough;               // Input already matches the codec format: skip swr
+
+    bool openCodec(const char* filePath, const EncoderOptions& options);
+    bool initResampler();
+    bool ensureConvertCapacity(int frames);
+    bool encodeFromFifo(int frames);
+    bool sendFrame(AVFrame* input);
+    void cleanup();
+    bool discardOutput(const char* filePath);
+
+public:
+    FFmpegEncoder();
+    ~FFmpegEncoder();
+
+    // Lifecycle. A failed open() removes the file only if it got as far as
+    // creating it; an existing file is left alone when setup fails earlier.
+    bool open(const char* filePath, const EncoderOptions& options = EncoderOptions());
+    bool write(const float* samples, int numSamples);
+
+    // Flushes the resampler, FIFO and encoder, then writes the trailer
+    bool close();
+
+    // Status
+    bool isOpen() const { return formatCtx != nullptr; }
+    int getSampleRate() const;
+    int getChannels() const;
+    int getFrameSize() const { return frameSize; }
+    int64_t getFramesWritten() const { return framesWritten; }
+    std::string getCodecName() const;
+
+    // Maps a codec name or file extension to an encoder ("mp3" -> libmp3lame, ...)
+    static const AVCodec* findEncoder(const std::string& name);
+};
+
+#endif // FFMPEG_ENCODER_H
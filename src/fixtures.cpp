@@ -0,0 +1,125 @@
+#include "fixtures.h"
+#include "encoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+bool FixtureGenerator::fail(const std::string& message) {
+    error = message;
+    return false;
+}
+
+const char* FixtureGenerator::extensionFor(const std::string& codec) {
+    if (codec == "aac") return "m4a";
+    if (codec == "vorbis") return "ogg";
+    if (codec == "opus") return "opus";
+    if (codec == "mp3") return "mp3";
+    if (codec == "wav") return "wav";
+    return "flac";
+}
+
+const char* FixtureGenerator::signalName(FixtureOptions::Signal signal) {
+    switch (signal) {
+        case FixtureOptions::SIGNAL_IMPULSE: return "impulse";
+        case FixtureOptions::SIGNAL_SILENCE: return "silence";
+        default: return "sweep";
+    }
+}
+
+std::string FixtureGenerator::fileName(const FixtureOptions& options) {
+    char name[128];
+    snprintf(name, sizeof(name), "%s-%s-%d-%dch.%s", signalName(options.signal), options.codec.c_str(),
+             options.sampleRate, options.channels, extensionFor(options.codec));
+    return name;
+}
+
+void FixtureGenerator::synthesize(FixtureOptions::Signal signal, int sampleRate, int channels, double duration,
+                                  int64_t start, int frames, float* out) {
+    const size_t count = static_cast<size_t>(frames) * channels;
+    std::fill(out, out + count, 0.0f);
+
+    if (signal == FixtureOptions::SIGNAL_IMPULSE) {
+        // Clicks on frame multiples of the rate; the same instant on every channel
+        int64_t next = (start + sampleRate - 1) / sampleRate * sampleRate;
+        for (int64_t frame = next; frame < start + frames; frame += sampleRate) {
+            for (int c = 0; c < channels; c++) {
+                out[static_cast<size_t>(frame - start) * channels + c] = 0.9f;
+            }
+        }
+        return;
+    }
+
+    if (signal != FixtureOptions::SIGNAL_SWEEP) return;
+
+    // Exponential sweep with the phase in closed form, so block size doesn't matter.
+    // Each channel is slightly quieter than the previous one to tell them apart.
+    const double f0 = 20.0;
+    const double f1 = std::max(f0 * 2.0, std::min(20000.0, 0.45 * sampleRate));
+    const double length = std::max(duration, 1.0 / sampleRate);
+    const double rate = std::log(f1 / f0);
+
+    for (int i = 0; i < frames; i++) {
+        double t = static_cast<double>(start + i) / sampleRate;
+        double phase = 2.0 * M_PI * f0 * length / rate * (std::exp(rate * t / length) - 1.0);
+        float value = static_cast<float>(0.5 * std::sin(phase));
+        for (int c = 0; c < channels; c++) {
+            out[static_cast<size_t>(i) * channels + c] = value * (1.0f - 0.05f * c);
+        }
+    }
+}
+
+bool FixtureGenerator::run(const std::string& outputPath, const FixtureOptions& options) {
+    res = Result();
+    error.clear();
+
+    if (options.sampleRate <= 0 || options.channels < 1 || options.channels > 8 || options.duration <= 0.0) {
+        return fail("Invalid fixture parameters");
+    }
+
+    // Samples are synthesized at the requested rate; the encoder resamples if it has to snap
+    EncoderOptions encoderOptions;
+    encoderOptions.codec = options.codec;
+    encoderOptions.sampleRate = options.sampleRate;
+    encoderOptions.channels = options.channels;
+    encoderOptions.inputSampleRate = options.sampleRate;
+    encoderOptions.inputChannels = options.channels;
+    encoderOptions.bitDepth = options.bitDepth;
+    encoderOptions.metadata["title"] = fileName(options);
+    encoderOptions.metadata["comment"] = "ffmpeg-napi-interface fixture";
+
+    FFmpegEncoder encoder;
+    if (!encoder.open(outputPath.c_str(), encoderOptions)) {
+        return fail("Encoder unavailable for " + options.codec + " at " + std::to_string(options.sampleRate) + " Hz, " +
+                    std::to_string(options.channels) + " channels");
+    }
+
+    const int block = 4096;
+    const int64_t total = static_cast<int64_t>(std::llround(options.duration * options.sampleRate));
+    std::vector<float> samples(static_cast<size_t>(block) * options.channels);
+
+    for (int64_t frame = 0; frame < total; frame += block) {
+        int frames = static_cast<int>(std::min<int64_t>(block, total - frame));
+        synthesize(options.signal, options.sampleRate, options.channels, options.duration, frame, frames, samples.data());
+        if (!encoder.write(samples.data(), frames * options.channels)) {
+            encoder.close();
+            std::remove(outputPath.c_str());
+            return fail("Encoding failed: " + outputPath);
+        }
+    }
+
+    res.codec = encoder.getCodecName();
+    res.sampleRate = encoder.getSampleRate();
+    res.channels = encoder.getChannels();
+    res.frames = total;
+
+    if (!encoder.close()) {
+        std::remove(outputPath.c_str());
+        return fail("Failed to finalize output: " + outputPath);
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef FFMPEG_FIXTURES_H
+#define FFMPEG_FIXTURES_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Description of one synthetic test file.
+ *
+ * Signals are computed from the absolute frame index, so a given spec always
+ * produces the same samples (encoders may still differ between FFmpeg builds).
+ */
+struct FixtureOptions {
+    enum Signal {
+        SIGNAL_SWEEP,       // Log sweep 20 Hz -> 0.45 * rate, -6 dBFS
+        SIGNAL_IMPULSE,     // One-sample clicks at the start of every second
+        SIGNAL_SILENCE
+    };
+
+    std::string codec = "flac";     // Any FFmpegEncoder codec ("wav", "flac", "mp3", "aac", "opus", "vorbis")
+    int sampleRate = 44100;         // Requested; the encoder snaps it to the nearest supported rate
+    int channels = 2;               // 1-8, default layout for the count
+    Signal signal = SIGNAL_SWEEP;
+    double duration = 10.0;         // Seconds
+    int bitDepth = 16;              // FLAC/WAV
+};
+
+/**
+ * FixtureGenerator - Encodes deterministic sweeps, impulses and silence with
+ * the bundled encoders, so benchmarks and regression checks need no
+ * checked-in media
+ */
+class FixtureGenerator {
+public:
+    struct Result {
+        std::string codec;          // Encoder actually used
+        int sampleRate = 0;         // After snapping
+        int channels = 0;
+        int64_t frames = 0;
+    };
+
+    // On failure the partial output is removed and getError() says why
+    bool run(const std::string& outputPath, const FixtureOptions& options);
+
+    const Result& result() const { return res; }
+    const std::string& getError() const { return error; }
+
+    // Fills frames x channels interleaved samples starting at frame start
+    static void synthesize(FixtureOptions::Signal signal, int sampleRate, int channels, double duration,
+                           int64_t start, int frames, float* out);
+
+    // "sweep-flac-44100-2ch.flac" style name; the extension picks the container
+    static std::string fileName(const FixtureOptions& options);
+    static const char* extensionFor(const std::string& codec);
+    static const char* signalName(FixtureOptions::Signal signal);
+
+private:
+    bool fail(const std::string& message);
+
+    Result res;
+    std::string error;
+};
+
+#endif // FFMPEG_FIXTURES_H
@@ -0,0 +1,744 @@
+#include "io.h"
+#include "pool.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+extern "C" {
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+IOStats IOCounters::snapshot() const {
+    IOStats stats;
+    stats.bytesRead = bytesRead.load(std::memory_order_relaxed);
+    stats.reads = reads.load(std::memory_order_relaxed);
+    stats.seeks = seeks.load(std::memory_order_relaxed);
+    stats.blockedTime = blocked.load(std::memory_order_relaxed) / 1e9;
+    return stats;
+}
+
+std::shared_ptr<const MemoryBlock> MemoryBlock::copy(const uint8_t* data, size_t size) {
+    std::shared_ptr<MemoryBlock> block = std::make_shared<MemoryBlock>();
+    block->storage.assign(data, data + size);
+    block->data = block->storage.data();
+    block->size = size;
+    return block;
+}
+
+std::shared_ptr<const MemoryBlock> MemoryBlock::borrow(const uint8_t* data, size_t size) {
+    std::shared_ptr<MemoryBlock> block = std::make_shared<MemoryBlock>();
+    block->data = data;
+    block->size = size;
+    return block;
+}
+
+#ifdef _WIN32
+
+std::shared_ptr<const MemoryBlock> MemoryBlock::map(const std::string& path, bool sequential) {
+    int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (length <= 0) return nullptr;
+    std::wstring widePath(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], length);
+
+    DWORD flags = sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 ||
+        static_cast<uint64_t>(size.QuadPart) > static_cast<uint64_t>(SIZE_MAX)) {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);      // The mapping keeps the file open
+    if (!mapping) return nullptr;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);   // The view keeps the mapping alive
+    if (!view) return nullptr;
+
+    MemoryBlock* block = new MemoryBlock();
+    block->data = static_cast<const uint8_t*>(view);
+    block->size = static_cast<size_t>(size.QuadPart);
+    return std::shared_ptr<const MemoryBlock>(block, [view](const MemoryBlock* b) {
+        UnmapViewOfFile(view);
+        delete b;
+    });
+}
+
+#else
+
+// Prefetched on open for random-access mappings (container headers, index)
+static const size_t MAP_PREFETCH_BYTES = 1 << 20;
+
+std::shared_ptr<const MemoryBlock> MemoryBlock::map(const std::string& path, bool sequential) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);            // The mapping holds its own reference
+    if (addr == MAP_FAILED) return nullptr;
+
+    // Advisory only; failures are harmless
+    if (sequential) {
+        madvise(addr, size, MADV_SEQUENTIAL);
+        madvise(addr, size, MADV_WILLNEED);
+    } else {
+        madvise(addr, std::min(size, MAP_PREFETCH_BYTES), MADV_WILLNEED);
+    }
+
+    MemoryBlock* block = new MemoryBlock();
+    block->data = static_cast<const uint8_t*>(addr);
+    block->size = size;
+    return std::shared_ptr<const MemoryBlock>(block, [addr, size](const MemoryBlock* b) {
+        munmap(addr, size);
+        delete b;
+    });
+}
+
+#endif
+
+MemoryReader::MemoryReader(std::shared_ptr<const MemoryBlock> memory)
+    : block(memory)
+    , position(0)
+    , ioCtx(nullptr)
+{
+    uint8_t* buffer = static_cast<uint8_t*>(av_malloc(IO_BUFFER_SIZE));
+    if (!buffer) return;
+
+    ioCtx = avio_alloc_context(buffer, IO_BUFFER_SIZE, 0, this, &MemoryReader::readPacket, nullptr,
+                               &MemoryReader::seekPacket);
+    if (!ioCtx) {
+        av_free(buffer);
+    }
+}
+
+MemoryReader::~MemoryReader() {
+    if (ioCtx) {
+        // libavformat may have replaced the buffer; free whatever it holds now
+        av_freep(&ioCtx->buffer);
+        avio_context_free(&ioCtx);
+    }
+}
+
+size_t MemoryReader::memoryUsage() const {
+    return ioCtx ? ioCtx->buffer_size : 0;
+}
+
+int MemoryReader::readPacket(void* opaque, uint8_t* buf, int bufSize) {
+    MemoryReader* reader = static_cast<MemoryReader*>(opaque);
+    if (reader->position >= reader->block->size) {
+        return AVERROR_EOF;
+    }
+
+    size_t count = std::min(static_cast<size_t>(bufSize), reader->block->size - reader->position);
+    memcpy(buf, reader->block->data + reader->position, count);
+    reader->position += count;
+    reader->counters.addRead(static_cast<int64_t>(count), 0);
+    return static_cast<int>(count);
+}
+
+int64_t MemoryReader::seekPacket(void* opaque, int64_t offset, int whence) {
+    MemoryReader* reader = static_cast<MemoryReader*>(opaque);
+    const int64_t size = static_cast<int64_t>(reader->block->size);
+
+    int64_t target;
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE:
+            return size;
+        case SEEK_SET:
+            target = offset;
+            break;
+        case SEEK_CUR:
+            target = static_cast<int64_t>(reader->position) + offset;
+            break;
+        case SEEK_END:
+            target = size + offset;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+
+    if (target < 0 || target > size) {
+        return AVERROR(EINVAL);
+    }
+
+    reader->position = static_cast<size_t>(target);
+    reader->counters.addSeek();
+    return target;
+}
+
+StreamReader::StreamReader(RequestFn requestFn, const Options& opts)
+    : request(requestFn)
+    , options(opts)
+    , ioCtx(nullptr)
+    , head(0)
+    , count(0)
+    , position(0)
+    , generation(0)
+    , pending(false)
+    , eof(false)
+    , failed(false)
+    , aborted(false)
+{
+    options.chunkSize = std::max(4096, options.chunkSize);
+    options.readAhead = std::max(options.chunkSize, options.readAhead);
+    ring.resize(options.readAhead);
+
+    uint8_t* buffer = static_cast<uint8_t*>(av_malloc(IO_BUFFER_SIZE));
+    if (!buffer) return;
+
+    ioCtx = avio_alloc_context(buffer, IO_BUFFER_SIZE, 0, this, &StreamReader::readPacket, nullptr,
+                               &StreamReader::seekPacket);
+    if (!ioCtx) {
+        av_free(buffer);
+        return;
+    }
+    ioCtx->seekable = options.seekable ? AVIO_SEEKABLE_NORMAL : 0;
+}
+
+StreamReader::~StreamReader() {
+    if (ioCtx) {
+        av_freep(&ioCtx->buffer);
+        avio_context_free(&ioCtx);
+    }
+}
+
+void StreamReader::requestMore() {
+    if (pending || eof || failed || aborted) return;
+    if (ring.size() - count < static_cast<size_t>(options.chunkSize)) return;
+
+    int length = options.chunkSize;
+    int64_t offset = position + static_cast<int64_t>(count);
+    if (options.size >= 0) {
+        if (offset >= options.size) {
+            eof = true;
+            return;
+        }
+        length = static_cast<int>(std::min<int64_t>(length, options.size - offset));
+    }
+
+    pending = true;
+    request(generation, offset, length);
+}
+
+void StreamReader::append(const uint8_t* data, size_t length) {
+    if (count + length > ring.size()) {
+        // Producer returned more than asked: grow and linearize
+        std::vector<uint8_t> grown(count + length);
+        for (size_t i = 0; i < count; i++) grown[i] = ring[(head + i) % ring.size()];
+        ring.swap(grown);
+        head = 0;
+    }
+
+    size_t tail = (head + count) % ring.size();
+    size_t first = std::min(length, ring.size() - tail);
+    memcpy(ring.data() + tail, data, first);
+    memcpy(ring.data(), data + first, length - first);
+    count += length;
+}
+
+void StreamReader::discard(size_t length) {
+    head = (head + length) % ring.size();
+    count -= length;
+    position += static_cast<int64_t>(length);
+}
+
+void StreamReader::supply(uint64_t gen, const uint8_t* data, size_t length) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (gen != generation || aborted) return;
+
+    pending = false;
+    counters.addRead(static_cast<int64_t>(length), 0);
+    if (length == 0) {
+        eof = true;
+    } else {
+        append(data, length);
+        requestMore();
+    }
+    ready.notify_all();
+}
+
+void StreamReader::fail(uint64_t gen, const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (gen != generation) return;
+
+    pending = false;
+    failed = true;
+    error = message;
+    ready.notify_all();
+}
+
+void StreamReader::abort() {
+    std::lock_guard<std::mutex> lock(mutex);
+    aborted = true;
+    ready.notify_all();
+}
+
+std::string StreamReader::getError() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
+
+size_t StreamReader::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ring.capacity() + (ioCtx ? ioCtx->buffer_size : 0);
+}
+
+int StreamReader::readPacket(void* opaque, uint8_t* buf, int bufSize) {
+    StreamReader* reader = static_cast<StreamReader*>(opaque);
+    std::unique_lock<std::mutex> lock(reader->mutex);
+
+    while (true) {
+        if (reader->aborted) return AVERROR_EXIT;
+
+        if (reader->count > 0) {
+            size_t length = std::min(static_cast<size_t>(bufSize), reader->count);
+            size_t first = std::min(length, reader->ring.size() - reader->head);
+            memcpy(buf, reader->ring.data() + reader->head, first);
+            memcpy(buf + first, reader->ring.data(), length - first);
+            reader->discard(length);
+            reader->requestMore();
+            return static_cast<int>(length);
+        }
+
+        if (reader->failed) return AVERROR(EIO);
+        if (reader->eof) return AVERROR_EOF;
+
+        reader->requestMore();
+        int64_t waitStart = nowNs();
+        reader->ready.wait(lock);
+        reader->counters.addBlocked(nowNs() - waitStart);
+    }
+}
+
+int64_t StreamReader::seekPacket(void* opaque, int64_t offset, int whence) {
+    StreamReader* reader = static_cast<StreamReader*>(opaque);
+    std::lock_guard<std::mutex> lock(reader->mutex);
+    const int64_t size = reader->options.size;
+
+    int64_t target;
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE:
+            return size >= 0 ? size : AVERROR(ENOSYS);
+        case SEEK_SET:
+            target = offset;
+            break;
+        case SEEK_CUR:
+            target = reader->position + offset;
+            break;
+        case SEEK_END:
+            if (size < 0) return AVERROR(ENOSYS);
+            target = size + offset;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+
+    if (target < 0 || (size >= 0 && target > size)) {
+        return AVERROR(EINVAL);
+    }
+
+    // Forward within what is already buffered: no round trip
+    if (target >= reader->position && target <= reader->position + static_cast<int64_t>(reader->count)) {
+        reader->discard(static_cast<size_t>(target - reader->position));
+        reader->requestMore();
+        return target;
+    }
+
+    if (!reader->options.seekable) {
+        return AVERROR(ESPIPE);
+    }
+
+    reader->counters.addSeek();
+    reader->generation++;
+    reader->head = 0;
+    reader->count = 0;
+    reader->position = target;
+    reader->pending = false;
+    reader->eof = false;
+    reader->requestMore();
+    return target;
+}
+
+// --- FileReader ---
+
+#ifdef _WIN32
+static int64_t preadFile(int fd, uint8_t* buf, size_t length, int64_t offset) {
+    if (_lseeki64(fd, offset, SEEK_SET) < 0) return -1;
+    return _read(fd, buf, static_cast<unsigned int>(std::min<size_t>(length, INT32_MAX)));
+}
+#else
+static int64_t preadFile(int fd, uint8_t* buf, size_t length, int64_t offset) {
+    ssize_t n;
+    do {
+        n = pread(fd, buf, length, static_cast<off_t>(offset));
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+#endif
+
+FileReader::FileReader()
+    : fd(-1)
+    , size(0)
+    , position(0)
+    , readAhead(0)
+    , prefetchedUntil(0)
+    , direct(false)
+    , aligned(nullptr)
+    , alignedCapacity(0)
+    , alignedStart(0)
+    , alignedLength(0)
+    , ring(nullptr)
+    , ringCapacity(0)
+    , ringHead(0)
+    , ringCount(0)
+    , ringStart(0)
+    , chunkSize(0)
+    , generation(0)
+    , ringEnd(false)
+    , stopping(false)
+    , ioError(0)
+    , ioCtx(nullptr)
+{
+}
+
+std::unique_ptr<FileReader> FileReader::open(const std::string& path, const IOOptions& options, bool sequential) {
+    std::unique_ptr<FileReader> reader(new FileReader());
+    int bufferSize = std::min(std::max(options.bufferSize, 4096), 16 << 20);
+
+#ifdef _WIN32
+    int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (length <= 0) return nullptr;
+    std::wstring widePath(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], length);
+
+    // No fadvise/O_DIRECT equivalent for CRT handles; the CRT access hints are the closest
+    int flags = _O_RDONLY | _O_BINARY;
+    if (options.advice == IOOptions::ADVICE_RANDOM) flags |= _O_RANDOM;
+    else if (options.advice == IOOptions::ADVICE_SEQUENTIAL || (options.advice == IOOptions::ADVICE_AUTO && sequential)) flags |= _O_SEQUENTIAL;
+    reader->fd = _wopen(widePath.c_str(), flags);
+    if (reader->fd < 0) return nullptr;
+
+    reader->size = _filelengthi64(reader->fd);
+    if (reader->size < 0) return nullptr;
+#else
+    int flags = O_RDONLY | O_CLOEXEC;
+#ifdef O_DIRECT
+    if (options.direct) {
+        reader->fd = ::open(path.c_str(), flags | O_DIRECT);
+        reader->direct = reader->fd >= 0;
+    }
+#endif
+    if (reader->fd < 0) {
+        reader->fd = ::open(path.c_str(), flags);     // Also the fallback where O_DIRECT is refused
+    }
+    if (reader->fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(reader->fd, &st) != 0 || !S_ISREG(st.st_mode)) return nullptr;
+    reader->size = static_cast<int64_t>(st.st_size);
+
+#if defined(__APPLE__) && defined(F_NOCACHE)
+    // Uncached but without alignment rules, so the plain read path serves it
+    if (options.direct) fcntl(reader->fd, F_NOCACHE, 1);
+#endif
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    IOOptions::Advice advice = options.advice;
+    if (advice == IOOptions::ADVICE_AUTO) {
+        advice = sequential ? IOOptions::ADVICE_SEQUENTIAL : IOOptions::ADVICE_NORMAL;
+    }
+    switch (advice) {
+        case IOOptions::ADVICE_SEQUENTIAL: posix_fadvise(reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL); break;
+        case IOOptions::ADVICE_RANDOM: posix_fadvise(reader->fd, 0, 0, POSIX_FADV_RANDOM); break;
+        case IOOptions::ADVICE_NOREUSE: posix_fadvise(reader->fd, 0, 0, POSIX_FADV_NOREUSE); break;
+        default: break;
+    }
+#endif
+#endif
+
+    reader->readAhead = std::max(0, options.readAhead);
+
+    if (options.prefetch > 0) {
+        // Whole aligned chunks, so direct reads stay aligned as the ring wraps
+        reader->chunkSize = (static_cast<size_t>(bufferSize) + DIRECT_ALIGNMENT - 1) & ~(DIRECT_ALIGNMENT - 1);
+        size_t capacity = std::max(static_cast<size_t>(options.prefetch), 2 * reader->chunkSize);
+        reader->ringCapacity = (capacity + reader->chunkSize - 1) / reader->chunkSize * reader->chunkSize;
+        reader->ring = static_cast<uint8_t*>(SlabPool::instance().allocate(reader->ringCapacity));
+        if (!reader->ring) return nullptr;
+    } else if (reader->direct) {
+        // Room for a full AVIO refill starting mid-block, in whole aligned blocks
+        reader->alignedCapacity = (static_cast<size_t>(bufferSize) + 2 * DIRECT_ALIGNMENT - 1) & ~(DIRECT_ALIGNMENT - 1);
+        reader->aligned = static_cast<uint8_t*>(SlabPool::instance().allocate(reader->alignedCapacity));
+        if (!reader->aligned) return nullptr;
+    }
+
+    uint8_t* buffer = static_cast<uint8_t*>(av_malloc(bufferSize));
+    if (!buffer) return nullptr;
+
+    reader->ioCtx = avio_alloc_context(buffer, bufferSize, 0, reader.get(), &FileReader::readPacket, nullptr,
+                                       &FileReader::seekPacket);
+    if (!reader->ioCtx) {
+        av_free(buffer);
+        return nullptr;
+    }
+
+    if (reader->ring) {
+        reader->prefetcher = std::thread(&FileReader::prefetchLoop, reader.get());
+    }
+    return reader;
+}
+
+FileReader::~FileReader() {
+    if (prefetcher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        drained.notify_all();
+        prefetcher.join();
+    }
+
+    if (ioCtx) {
+        av_freep(&ioCtx->buffer);
+        avio_context_free(&ioCtx);
+    }
+    SlabPool::instance().release(aligned, alignedCapacity);
+    SlabPool::instance().release(ring, ringCapacity);
+    if (fd >= 0) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+}
+
+size_t FileReader::memoryUsage() const {
+    // ring and aligned are sized once at open
+    return (ioCtx ? ioCtx->buffer_size : 0) + alignedCapacity + ringCapacity;
+}
+
+int64_t FileReader::readAt(uint8_t* buf, size_t length, int64_t offset) {
+    int64_t start = nowNs();
+    int64_t n = preadFile(fd, buf, length, offset);
+    counters.addRead(n > 0 ? n : 0, nowNs() - start);
+    return n;
+}
+
+void FileReader::prefetch() {
+#ifdef POSIX_FADV_WILLNEED
+    // Re-arm once half the window is consumed, so the kernel stays ahead
+    if (readAhead <= 0 || position + readAhead / 2 < prefetchedUntil) return;
+    int64_t from = std::max(position, prefetchedUntil);
+    int64_t until = std::min(size, position + readAhead);
+    if (until > from) {
+        posix_fadvise(fd, static_cast<off_t>(from), static_cast<off_t>(until - from), POSIX_FADV_WILLNEED);
+    }
+    prefetchedUntil = until;
+#endif
+}
+
+int FileReader::readDirect(uint8_t* buf, int bufSize) {
+    int64_t end = alignedStart + static_cast<int64_t>(alignedLength);
+    if (position < alignedStart || position >= end) {
+        int64_t blockStart = position & ~static_cast<int64_t>(DIRECT_ALIGNMENT - 1);
+        int64_t n = readAt(aligned, alignedCapacity, blockStart);
+#if !defined(_WIN32) && defined(O_DIRECT)
+        if (n < 0 && errno == EINVAL) {
+            // Filesystem accepted O_DIRECT at open but not for reads: go buffered
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+            direct = false;
+            n = readAt(buf, static_cast<size_t>(bufSize), position);
+            return n < 0 ? AVERROR(errno) : n == 0 ? AVERROR_EOF : static_cast<int>(n);
+        }
+#endif
+        if (n < 0) return AVERROR(errno);
+        alignedStart = blockStart;
+        alignedLength = static_cast<size_t>(n);
+        end = alignedStart + n;
+        if (position >= end) return AVERROR_EOF;
+    }
+
+    size_t count = std::min(static_cast<size_t>(bufSize), static_cast<size_t>(end - position));
+    memcpy(buf, aligned + (position - alignedStart), count);
+    return static_cast<int>(count);
+}
+
+void FileReader::prefetchLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // Wait for free space (a whole chunk, so direct reads stay aligned) and unread file
+        drained.wait(lock, [this] {
+            return stopping || (ioError == 0 && !ringEnd && ringCount + chunkSize <= ringCapacity &&
+                                ringStart + static_cast<int64_t>(ringCount) < size);
+        });
+        if (stopping) return;
+
+        uint64_t requested = generation;
+        size_t tail = (ringHead + ringCount) % ringCapacity;
+        size_t length = std::min(chunkSize, ringCapacity - tail);     // Less only after a short read
+        int64_t offset = ringStart + static_cast<int64_t>(ringCount);
+
+        // The chunk beyond ringCount is only touched by this thread; a seek
+        // meanwhile bumps generation and the result is dropped
+        lock.unlock();
+        int64_t n = preadFile(fd, ring + tail, length, offset);
+#if !defined(_WIN32) && defined(O_DIRECT)
+        if (n < 0 && errno == EINVAL && direct) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+            direct = false;
+            n = preadFile(fd, ring + tail, length, offset);
+        }
+#endif
+        int error = n < 0 ? errno : 0;
+        lock.lock();
+
+        counters.addRead(n > 0 ? n : 0, 0);     // Off the demuxer thread, so not blocked time
+        if (requested != generation) continue;
+
+        if (n < 0) {
+            ioError = error;
+        } else if (n == 0) {
+            ringEnd = true;         // File shrank; stop at what exists
+        } else {
+            ringCount += static_cast<size_t>(n);
+        }
+        filled.notify_all();
+    }
+}
+
+int FileReader::readPrefetched(uint8_t* buf, int bufSize) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        // Drop bytes before the read position (alignment slack, short forward seeks)
+        size_t skip = std::min(static_cast<size_t>(position - ringStart), ringCount);
+        if (skip > 0) {
+            ringHead = (ringHead + skip) % ringCapacity;
+            ringCount -= skip;
+            ringStart += static_cast<int64_t>(skip);
+            drained.notify_one();
+        }
+        if (ringCount > 0 || ioError != 0 || ringEnd) break;
+
+        int64_t waitStart = nowNs();
+        filled.wait(lock);
+        counters.addBlocked(nowNs() - waitStart);
+    }
+    if (ringCount == 0) {
+        return ioError != 0 ? AVERROR(ioError) : AVERROR_EOF;
+    }
+
+    size_t total = std::min(static_cast<size_t>(bufSize), ringCount);
+    size_t first = std::min(total, ringCapacity - ringHead);
+    memcpy(buf, ring + ringHead, first);
+    memcpy(buf + first, ring, total - first);
+
+    ringHead = (ringHead + total) % ringCapacity;
+    ringCount -= total;
+    ringStart += static_cast<int64_t>(total);
+    lock.unlock();
+
+    drained.notify_one();
+    return static_cast<int>(total);
+}
+
+void FileReader::seekPrefetched(int64_t target) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (target >= ringStart && target <= ringStart + static_cast<int64_t>(ringCount)) return;
+
+        // Restart the ring at the aligned block holding target
+        generation++;
+        ringHead = 0;
+        ringCount = 0;
+        ringStart = target & ~static_cast<int64_t>(DIRECT_ALIGNMENT - 1);
+        ringEnd = false;
+        ioError = 0;
+    }
+    drained.notify_one();
+}
+
+int FileReader::readPacket(void* opaque, uint8_t* buf, int bufSize) {
+    FileReader* reader = static_cast<FileReader*>(opaque);
+    if (reader->position >= reader->size) return AVERROR_EOF;
+
+    if (reader->ring) {
+        int n = reader->readPrefetched(buf, bufSize);
+        if (n > 0) reader->position += n;
+        return n;
+    }
+
+    reader->prefetch();
+
+    int n;
+    if (reader->direct) {
+        n = reader->readDirect(buf, bufSize);
+    } else {
+        int64_t count = reader->readAt(buf, static_cast<size_t>(bufSize), reader->position);
+        n = count < 0 ? AVERROR(errno) : count == 0 ? AVERROR_EOF : static_cast<int>(count);
+    }
+
+    if (n > 0) reader->position += n;
+    return n;
+}
+
+int64_t FileReader::seekPacket(void* opaque, int64_t offset, int whence) {
+    FileReader* reader = static_cast<FileReader*>(opaque);
+
+    int64_t target;
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE:
+            return reader->size;
+        case SEEK_SET:
+            target = offset;
+            break;
+        case SEEK_CUR:
+            target = reader->position + offset;
+            break;
+        case SEEK_END:
+            target = reader->size + offset;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+
+    if (target < 0) return AVERROR(EINVAL);
+
+    if (reader->ring) reader->seekPrefetched(target);
+    reader->position = target;
+    reader->prefetchedUntil = target;   // Prefetch restarts from the new position
+    reader->counters.addSeek();
+    return target;
+}
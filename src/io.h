@@ -0,0 +1,272 @@
+#ifndef FFMPEG_IO_H
+#define FFMPEG_IO_H
+
+extern "C" {
+#include <libavformat/avio.h>
+}
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Tuning for local file input.
+ *
+ * Hints are best effort: options a platform or filesystem does not support
+ * are ignored rather than failing the open.
+ */
+struct IOOptions {
+    enum Advice {
+        ADVICE_AUTO,            // Sequential when scanning (analysis), normal otherwise
+        ADVICE_NORMAL,
+        ADVICE_SEQUENTIAL,
+        ADVICE_RANDOM,
+        ADVICE_NOREUSE
+    };
+
+    int bufferSize = 32768;     // AVIO buffer: bytes per read() syscall (libavformat default 32 KB)
+    int readAhead = 0;          // Bytes prefetched ahead of the read position (WILLNEED); 0 = kernel default
+    int prefetch = 0;           // Bytes read ahead on a helper thread; 0 = read on the demuxer thread
+    bool direct = false;        // O_DIRECT / F_NOCACHE: bypass the page cache
+    Advice advice = ADVICE_AUTO;
+};
+
+/**
+ * I/O counters of one input. reads counts syscalls for files, callbacks for
+ * memory and producer requests for streams; blockedTime is the wall-clock
+ * time spent waiting for them.
+ */
+struct IOStats {
+    int64_t bytesRead = 0;
+    int64_t reads = 0;
+    int64_t seeks = 0;
+    double blockedTime = 0.0;   // Seconds
+};
+
+// Lock-free, so stats can be sampled while another thread decodes
+class IOCounters {
+public:
+    void addRead(int64_t bytes, int64_t blockedNs) {
+        bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+        reads.fetch_add(1, std::memory_order_relaxed);
+        blocked.fetch_add(blockedNs, std::memory_order_relaxed);
+    }
+    void addBlocked(int64_t blockedNs) { blocked.fetch_add(blockedNs, std::memory_order_relaxed); }
+    void addSeek() { seeks.fetch_add(1, std::memory_order_relaxed); }
+    IOStats snapshot() const;
+
+private:
+    std::atomic<int64_t> bytesRead{0};
+    std::atomic<int64_t> reads{0};
+    std::atomic<int64_t> seeks{0};
+    std::atomic<int64_t> blocked{0};
+};
+
+/**
+ * An encoded file held in memory.
+ *
+ * Either owns a copy (storage) or borrows memory kept alive elsewhere, e.g.
+ * a JS Buffer pinned by the binding. Shared read-only between decoders.
+ */
+struct MemoryBlock {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    std::vector<uint8_t> storage;   // Owned copy; empty when borrowed
+
+    static std::shared_ptr<const MemoryBlock> copy(const uint8_t* data, size_t size);
+    static std::shared_ptr<const MemoryBlock> borrow(const uint8_t* data, size_t size);
+
+    // Maps a local file read-only; unmapped when the last reference goes.
+    // sequential hints a front-to-back scan, otherwise only the head is
+    // prefetched so random seeks don't evict useful pages.
+    // nullptr for anything that cannot be mapped (URLs, pipes, empty files).
+    static std::shared_ptr<const MemoryBlock> map(const std::string& path, bool sequential);
+};
+
+/**
+ * MemoryReader - Custom AVIOContext with read/seek callbacks over a MemoryBlock
+ *
+ * Each reader has its own position, so several decoders can read the same
+ * block concurrently.
+ */
+class MemoryReader {
+public:
+    explicit MemoryReader(std::shared_ptr<const MemoryBlock> block);
+    ~MemoryReader();
+
+    MemoryReader(const MemoryReader&) = delete;
+    MemoryReader& operator=(const MemoryReader&) = delete;
+
+    // nullptr if allocation failed; owned by the reader (use with AVFMT_FLAG_CUSTOM_IO)
+    AVIOContext* context() const { return ioCtx; }
+    IOStats getStats() const { return counters.snapshot(); }
+    size_t memoryUsage() const;     // AVIO buffer (the block is counted by its owner)
+
+private:
+    static const int IO_BUFFER_SIZE = 32768;
+
+    static int readPacket(void* opaque, uint8_t* buf, int bufSize);
+    static int64_t seekPacket(void* opaque, int64_t offset, int whence);
+
+    std::shared_ptr<const MemoryBlock> block;
+    size_t position;
+    AVIOContext* ioCtx;
+    IOCounters counters;
+};
+
+/**
+ * FileReader - Custom AVIOContext over a local file with a tunable buffer
+ *
+ * Reads with pread() (one syscall per AVIO refill of bufferSize bytes),
+ * applies posix_fadvise hints, keeps readAhead bytes of WILLNEED prefetch in
+ * front of the read position, and for direct I/O goes through an aligned
+ * bounce buffer.
+ *
+ * With IOOptions::prefetch a helper thread does the reads instead, filling a
+ * page-aligned ring ahead of the demuxer so cold reads (spinning disks, NFS)
+ * overlap with decoding. A seek outside the buffered range restarts it there.
+ * blockedTime is then only the time the demuxer waited on the ring.
+ */
+class FileReader {
+public:
+    // nullptr if the path is not a readable local file; sequential selects ADVICE_AUTO's hint
+    static std::unique_ptr<FileReader> open(const std::string& path, const IOOptions& options, bool sequential);
+    ~FileReader();
+
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    AVIOContext* context() const { return ioCtx; }
+    IOStats getStats() const { return counters.snapshot(); }
+    bool isDirect() const { return direct; }
+    size_t memoryUsage() const;     // AVIO buffer, bounce buffer and prefetch ring
+
+private:
+    static const size_t DIRECT_ALIGNMENT = 4096;
+
+    FileReader();
+
+    static int readPacket(void* opaque, uint8_t* buf, int bufSize);
+    static int64_t seekPacket(void* opaque, int64_t offset, int whence);
+
+    int64_t readAt(uint8_t* buf, size_t length, int64_t offset);    // One syscall, counted
+    int readDirect(uint8_t* buf, int bufSize);
+    void prefetch();
+
+    // Helper thread mode
+    void prefetchLoop();
+    int readPrefetched(uint8_t* buf, int bufSize);
+    void seekPrefetched(int64_t target);
+
+    int fd;
+    int64_t size;
+    int64_t position;
+    int readAhead;
+    int64_t prefetchedUntil;
+
+    // Direct I/O bounce buffer, reused while reads stay inside it
+    bool direct;
+    uint8_t* aligned;
+    size_t alignedCapacity;
+    int64_t alignedStart;
+    size_t alignedLength;
+
+    // Prefetch ring: ringCount bytes from file offset ringStart at ring[ringHead]
+    std::thread prefetcher;
+    std::mutex mutex;
+    std::condition_variable filled;
+    std::condition_variable drained;
+    uint8_t* ring;
+    size_t ringCapacity;
+    size_t ringHead;
+    size_t ringCount;
+    int64_t ringStart;
+    size_t chunkSize;
+    uint64_t generation;
+    bool ringEnd;                   // Short file: nothing more to read before a seek
+    bool stopping;
+    int ioError;
+
+    AVIOContext* ioCtx;
+    IOCounters counters;
+};
+
+/**
+ * StreamReader - Custom AVIOContext fed by an external producer (e.g. JS)
+ *
+ * The demuxer thread blocks in the read callback until bytes arrive. Data is
+ * requested ahead of the read position in chunks, up to readAhead bytes, so
+ * the producer can fetch while the decoder works. One request is outstanding
+ * at a time. A seek outside the buffered range bumps the generation, so late
+ * replies to older requests are dropped.
+ *
+ * The request callback runs on the demuxer thread (or the thread calling
+ * supply()) with the reader's lock held. It must only queue the request.
+ */
+class StreamReader {
+public:
+    typedef std::function<void(uint64_t generation, int64_t offset, int length)> RequestFn;
+
+    struct Options {
+        int64_t size = -1;              // Total bytes; -1 = unknown
+        bool seekable = false;          // Producer can serve arbitrary offsets
+        int readAhead = 1 << 20;        // Bytes buffered ahead of the read position
+        int chunkSize = 64 * 1024;      // Bytes per request
+    };
+
+    StreamReader(RequestFn request, const Options& options);
+    ~StreamReader();
+
+    StreamReader(const StreamReader&) = delete;
+    StreamReader& operator=(const StreamReader&) = delete;
+
+    // nullptr if allocation failed; owned by the reader (use with AVFMT_FLAG_CUSTOM_IO)
+    AVIOContext* context() const { return ioCtx; }
+
+    // Producer side: reply to a request (length 0 = end of stream) or report an error
+    void supply(uint64_t generation, const uint8_t* data, size_t length);
+    void fail(uint64_t generation, const std::string& message);
+
+    // Wakes a blocked read with AVERROR_EXIT; later reads fail too
+    void abort();
+
+    std::string getError() const;
+    IOStats getStats() const { return counters.snapshot(); }
+    size_t memoryUsage() const;     // AVIO buffer and byte ring
+
+private:
+    static const int IO_BUFFER_SIZE = 32768;
+
+    static int readPacket(void* opaque, uint8_t* buf, int bufSize);
+    static int64_t seekPacket(void* opaque, int64_t offset, int whence);
+
+    void requestMore();             // Caller holds mutex
+    void append(const uint8_t* data, size_t length);
+    void discard(size_t length);
+
+    RequestFn request;
+    Options options;
+    AVIOContext* ioCtx;
+
+    mutable std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<uint8_t> ring;      // Circular buffer of bytes from position on
+    size_t head;
+    size_t count;
+    int64_t position;               // Stream offset of ring[head]
+    uint64_t generation;
+    bool pending;
+    bool eof;
+    bool failed;
+    bool aborted;
+    std::string error;
+    IOCounters counters;            // reads = producer requests
+};
+
+#endif // FFMPEG_IO_H
@@ -0,0 +1,71 @@
+#ifndef FFMPEG_JOB_H
+#define FFMPEG_JOB_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+/**
+ * Progress snapshot of a long-running native job
+ */
+struct JobProgress {
+    double progress = 0.0;      // 0..1 (0 while the total is unknown)
+    double processed = 0.0;     // Seconds of audio processed
+    double duration = 0.0;      // Seconds of audio in total (0 = unknown)
+    double speed = 0.0;         // Processed seconds per wall-clock second
+};
+
+/**
+ * JobControl - Cancellation flag and throttled progress reporting
+ *
+ * Shared between the thread running a job and the thread that may cancel
+ * it; only the job thread calls start()/report().
+ */
+class JobControl {
+public:
+    typedef std::function<void(const JobProgress&)> ProgressCallback;
+
+    void cancel() { cancelled.store(true); }
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+    void setProgressCallback(ProgressCallback callback, double intervalSeconds = 0.1) {
+        onProgress = callback;
+        interval = std::chrono::duration<double>(intervalSeconds);
+    }
+
+    void start() {
+        startTime = std::chrono::steady_clock::now();
+        lastReport = startTime - std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+    }
+
+    // Invokes the callback at most once per interval unless forced
+    void report(double processed, double duration, bool force = false) {
+        if (!onProgress) return;
+
+        auto now = std::chrono::steady_clock::now();
+        if (!force && now - lastReport < interval) return;
+        lastReport = now;
+
+        JobProgress p;
+        p.processed = processed;
+        p.duration = duration;
+        p.progress = duration > 0.0 ? std::min(1.0, processed / duration) : 0.0;
+        double elapsed = std::chrono::duration<double>(now - startTime).count();
+        p.speed = elapsed > 0.0 ? processed / elapsed : 0.0;
+        onProgress(p);
+    }
+
+    double elapsed() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+private:
+    std::atomic<bool> cancelled{false};
+    ProgressCallback onProgress;
+    std::chrono::duration<double> interval{0.1};
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point lastReport;
+};
+
+#endif // FFMPEG_JOB_H
@@ -0,0 +1,403 @@
+#include "loudness.h"
+#include "decoder.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define LOUDNESS_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define LOUDNESS_NEON 1
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Two-lane double vector: K-weighting runs one channel pair per vector
+#if defined(LOUDNESS_SSE2)
+typedef __m128d vec2;
+static inline vec2 v2_set(double lane0, double lane1) { return _mm_set_pd(lane1, lane0); }
+static inline vec2 v2_splat(double v) { return _mm_set1_pd(v); }
+static inline vec2 v2_load(const double* p) { return _mm_loadu_pd(p); }
+static inline void v2_store(double* p, vec2 v) { _mm_storeu_pd(p, v); }
+static inline vec2 v2_add(vec2 a, vec2 b) { return _mm_add_pd(a, b); }
+static inline vec2 v2_sub(vec2 a, vec2 b) { return _mm_sub_pd(a, b); }
+static inline vec2 v2_mul(vec2 a, vec2 b) { return _mm_mul_pd(a, b); }
+#elif defined(LOUDNESS_NEON)
+typedef float64x2_t vec2;
+static inline vec2 v2_set(double lane0, double lane1) { double t[2] = { lane0, lane1 }; return vld1q_f64(t); }
+static inline vec2 v2_splat(double v) { return vdupq_n_f64(v); }
+static inline vec2 v2_load(const double* p) { return vld1q_f64(p); }
+static inline void v2_store(double* p, vec2 v) { vst1q_f64(p, v); }
+static inline vec2 v2_add(vec2 a, vec2 b) { return vaddq_f64(a, b); }
+static inline vec2 v2_sub(vec2 a, vec2 b) { return vsubq_f64(a, b); }
+static inline vec2 v2_mul(vec2 a, vec2 b) { return vmulq_f64(a, b); }
+#else
+struct vec2 { double v[2]; };
+static inline vec2 v2_set(double lane0, double lane1) { vec2 r = { { lane0, lane1 } }; return r; }
+static inline vec2 v2_splat(double v) { return v2_set(v, v); }
+static inline vec2 v2_load(const double* p) { return v2_set(p[0], p[1]); }
+static inline void v2_store(double* p, vec2 a) { p[0] = a.v[0]; p[1] = a.v[1]; }
+static inline vec2 v2_add(vec2 a, vec2 b) { return v2_set(a.v[0] + b.v[0], a.v[1] + b.v[1]); }
+static inline vec2 v2_sub(vec2 a, vec2 b) { return v2_set(a.v[0] - b.v[0], a.v[1] - b.v[1]); }
+static inline vec2 v2_mul(vec2 a, vec2 b) { return v2_set(a.v[0] * b.v[0], a.v[1] * b.v[1]); }
+#endif
+
+static const int SHORT_TERM_SUB_BLOCKS = 30;    // 3 s of 100 ms sub-blocks
+static const int MOMENTARY_SUB_BLOCKS = 4;      // 400 ms
+static const int TRUE_PEAK_TAPS = 12;           // Per polyphase branch
+static const int MAX_CHANNELS = 64;
+static const int READ_CHUNK_FRAMES = 16384;
+
+static const double ABSOLUTE_GATE_LUFS = -70.0;
+static const double RELATIVE_GATE_LU = -10.0;
+static const double RANGE_RELATIVE_GATE_LU = -20.0;
+static const double REPLAYGAIN_REFERENCE_LUFS = -18.0;
+
+static double energyToLoudness(double energy) {
+    return -0.691 + 10.0 * std::log10(energy);
+}
+
+static double loudnessToEnergy(double lufs) {
+    return std::pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+LoudnessAnalyzer::LoudnessAnalyzer()
+    : channels(0)
+    , sampleRate(0)
+    , subBlockFrames(0)
+    , subBlockPos(0)
+    , totalFrames(0)
+    , shelf()
+    , highpass()
+    , recentCount(0)
+    , recentPos(0)
+    , oversample(1)
+    , firTaps(0)
+    , historyPos(0)
+    , samplePeak(0.0f)
+    , truePeak(0.0f)
+{
+}
+
+bool LoudnessAnalyzer::init(int numChannels, int rate) {
+    if (numChannels <= 0 || numChannels > MAX_CHANNELS || rate <= 0) return false;
+
+    channels = numChannels;
+    sampleRate = rate;
+    subBlockFrames = std::max(1, static_cast<int>(std::lround(rate * 0.1)));
+    subBlockPos = 0;
+    totalFrames = 0;
+
+    // K-weighting pre-filter (BS.1770-4), re-derived for the actual sample rate
+    double f0 = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = std::tan(M_PI * f0 / rate);
+    double vh = std::pow(10.0, gain / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    shelf.b1 = 2.0 * (k * k - vh) / a0;
+    shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+    // RLB high-pass
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+    highpass.b0 = 1.0;
+    highpass.b1 = -2.0;
+    highpass.b2 = 1.0;
+    highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+    highpass.a2 = (1.0 - k / q + k * k) / a0;
+
+    const int pairs = (channels + 1) / 2;
+    state.assign(static_cast<size_t>(pairs) * 8, 0.0);
+    subBlockEnergy.assign(static_cast<size_t>(pairs) * 2, 0.0);
+
+    // Channel weights: 1.0 for front channels, 1.41 for surrounds, LFE excluded
+    // (assumes FFmpeg's default layouts for 5.0/5.1/7.1)
+    weights.assign(channels, 1.0);
+    if (channels == 5) {
+        weights[3] = weights[4] = 1.41;
+    } else if (channels >= 6) {
+        weights[3] = 0.0;
+        for (int c = 4; c < channels; c++) weights[c] = 1.41;
+    }
+
+    recentSubBlocks.assign(SHORT_TERM_SUB_BLOCKS, 0.0);
+    recentCount = 0;
+    recentPos = 0;
+    blockEnergies.clear();
+    shortTermEnergies.clear();
+
+    // True-peak interpolator: windowed-sinc polyphase FIR (BS.1770-4 Annex 2)
+    oversample = rate < 96000 ? 4 : (rate < 192000 ? 2 : 1);
+    firTaps = oversample > 1 ? TRUE_PEAK_TAPS : 0;
+    polyphase.clear();
+    history.clear();
+    if (oversample > 1) {
+        const int length = oversample * firTaps;
+        std::vector<double> h(length);
+        for (int n = 0; n < length; n++) {
+            double t = (n - (length - 1) / 2.0) / oversample;
+            double sinc = (t == 0.0) ? 1.0 : std::sin(M_PI * t) / (M_PI * t);
+            double w = 2.0 * M_PI * n / (length - 1);
+            double window = 0.35875 - 0.48829 * std::cos(w) + 0.14128 * std::cos(2.0 * w) - 0.01168 * std::cos(3.0 * w);
+            h[n] = sinc * window;
+        }
+
+        // Coefficients stored oldest-sample-first so each branch is a straight dot product
+        polyphase.resize(length);
+        for (int p = 0; p < oversample; p++) {
+            double sum = 0.0;
+            for (int j = 0; j < firTaps; j++) sum += h[p + (firTaps - 1 - j) * oversample];
+            for (int j = 0; j < firTaps; j++) {
+                polyphase[p * firTaps + j] = static_cast<float>(h[p + (firTaps - 1 - j) * oversample] / sum);
+            }
+        }
+        history.assign(static_cast<size_t>(channels) * firTaps * 2, 0.0f);
+    }
+    historyPos = 0;
+    samplePeak = 0.0f;
+    truePeak = 0.0f;
+
+    return true;
+}
+
+void LoudnessAnalyzer::updatePeaks(const float* samples, int frames) {
+    float sp = samplePeak;
+    float tp = truePeak;
+
+    for (int i = 0; i < frames; i++) {
+        const float* f = samples + static_cast<size_t>(i) * channels;
+        for (int c = 0; c < channels; c++) {
+            float x = f[c];
+            sp = std::max(sp, std::fabs(x));
+
+            if (oversample > 1) {
+                // Mirrored ring: the last firTaps samples are always contiguous
+                float* h = &history[static_cast<size_t>(c) * firTaps * 2];
+                h[historyPos] = x;
+                h[historyPos + firTaps] = x;
+                const float* window = h + historyPos + 1;
+
+                for (int p = 0; p < oversample; p++) {
+                    const float* coef = &polyphase[p * firTaps];
+                    float y = 0.0f;
+                    for (int j = 0; j < firTaps; j++) y += coef[j] * window[j];
+                    tp = std::max(tp, std::fabs(y));
+                }
+            }
+        }
+        if (oversample > 1) {
+            historyPos = (historyPos + 1) % firTaps;
+        }
+    }
+
+    samplePeak = sp;
+    truePeak = std::max(tp, sp);
+}
+
+void LoudnessAnalyzer::processSegment(const float* samples, int frames) {
+    const vec2 sb0 = v2_splat(shelf.b0), sb1 = v2_splat(shelf.b1), sb2 = v2_splat(shelf.b2);
+    const vec2 sa1 = v2_splat(shelf.a1), sa2 = v2_splat(shelf.a2);
+    const vec2 hb0 = v2_splat(highpass.b0), hb1 = v2_splat(highpass.b1), hb2 = v2_splat(highpass.b2);
+    const vec2 ha1 = v2_splat(highpass.a1), ha2 = v2_splat(highpass.a2);
+
+    const int pairs = (channels + 1) / 2;
+    for (int p = 0; p < pairs; p++) {
+        const int c0 = p * 2;
+        const bool hasSecond = c0 + 1 < channels;
+        double* z = &state[static_cast<size_t>(p) * 8];
+
+        // Transposed direct form II, both stages, both lanes
+        vec2 s1z1 = v2_load(z), s1z2 = v2_load(z + 2);
+        vec2 s2z1 = v2_load(z + 4), s2z2 = v2_load(z + 6);
+        vec2 energy = v2_splat(0.0);
+
+        for (int i = 0; i < frames; i++) {
+            const float* f = samples + static_cast<size_t>(i) * channels + c0;
+            vec2 x = v2_set(f[0], hasSecond ? f[1] : 0.0);
+
+            vec2 y = v2_add(v2_mul(sb0, x), s1z1);
+            s1z1 = v2_add(v2_sub(v2_mul(sb1, x), v2_mul(sa1, y)), s1z2);
+            s1z2 = v2_sub(v2_mul(sb2, x), v2_mul(sa2, y));
+
+            vec2 out = v2_add(v2_mul(hb0, y), s2z1);
+            s2z1 = v2_add(v2_sub(v2_mul(hb1, y), v2_mul(ha1, out)), s2z2);
+            s2z2 = v2_sub(v2_mul(hb2, y), v2_mul(ha2, out));
+
+            energy = v2_add(energy, v2_mul(out, out));
+        }
+
+        v2_store(z, s1z1);
+        v2_store(z + 2, s1z2);
+        v2_store(z + 4, s2z1);
+        v2_store(z + 6, s2z2);
+
+        // Flush decaying state before it turns denormal during long silences
+        for (int j = 0; j < 8; j++) {
+            if (std::fabs(z[j]) < 1e-30) z[j] = 0.0;
+        }
+
+        double e[2];
+        v2_store(e, energy);
+        subBlockEnergy[c0] += e[0];
+        subBlockEnergy[c0 + 1] += e[1];
+    }
+}
+
+void LoudnessAnalyzer::finishSubBlock() {
+    double energy = 0.0;
+    for (int c = 0; c < channels; c++) {
+        energy += weights[c] * subBlockEnergy[c];
+    }
+    std::fill(subBlockEnergy.begin(), subBlockEnergy.end(), 0.0);
+    energy /= subBlockFrames;
+
+    recentSubBlocks[recentPos] = energy;
+    recentPos = (recentPos + 1) % SHORT_TERM_SUB_BLOCKS;
+    recentCount = std::min(recentCount + 1, SHORT_TERM_SUB_BLOCKS);
+
+    if (recentCount >= MOMENTARY_SUB_BLOCKS) {
+        double sum = 0.0;
+        for (int i = 1; i <= MOMENTARY_SUB_BLOCKS; i++) {
+            sum += recentSubBlocks[(recentPos - i + SHORT_TERM_SUB_BLOCKS) % SHORT_TERM_SUB_BLOCKS];
+        }
+        blockEnergies.push_back(sum / MOMENTARY_SUB_BLOCKS);
+    }
+
+    if (recentCount >= SHORT_TERM_SUB_BLOCKS) {
+        double sum = 0.0;
+        for (double e : recentSubBlocks) sum += e;
+        shortTermEnergies.push_back(sum / SHORT_TERM_SUB_BLOCKS);
+    }
+}
+
+void LoudnessAnalyzer::process(const float* samples, int frames) {
+    if (channels <= 0 || !samples || frames <= 0) return;
+
+    updatePeaks(samples, frames);
+
+    int offset = 0;
+    while (offset < frames) {
+        int take = std::min(subBlockFrames - subBlockPos, frames - offset);
+        processSegment(samples + static_cast<size_t>(offset) * channels, take);
+        subBlockPos += take;
+        offset += take;
+
+        if (subBlockPos >= subBlockFrames) {
+            finishSubBlock();
+            subBlockPos = 0;
+        }
+    }
+
+    totalFrames += frames;
+}
+
+bool LoudnessAnalyzer::analyze(FFmpegDecoder& decoder) {
+    if (!decoder.isOpen() || decoder.getChannels() != channels) return false;
+
+    std::vector<float> chunk(static_cast<size_t>(READ_CHUNK_FRAMES) * channels);
+    while (true) {
+        int samplesRead = decoder.read(chunk.data(), static_cast<int>(chunk.size()));
+        if (samplesRead <= 0) break;
+        process(chunk.data(), samplesRead / channels);
+    }
+    // A read error also ends the loop; don't report a truncated file as measured
+    return !decoder.hasError();
+}
+
+double LoudnessAnalyzer::gatedLoudness(const std::vector<double>& blocks) {
+    const double absThreshold = loudnessToEnergy(ABSOLUTE_GATE_LUFS);
+
+    double sum = 0.0;
+    size_t count = 0;
+    for (double e : blocks) {
+        if (e > absThreshold) {
+            sum += e;
+            count++;
+        }
+    }
+    if (count == 0) return -HUGE_VAL;
+
+    const double threshold = std::max(absThreshold, (sum / count) * std::pow(10.0, RELATIVE_GATE_LU / 10.0));
+    sum = 0.0;
+    count = 0;
+    for (double e : blocks) {
+        if (e > threshold) {
+            sum += e;
+            count++;
+        }
+    }
+    if (count == 0) return -HUGE_VAL;
+
+    return energyToLoudness(sum / count);
+}
+
+double LoudnessAnalyzer::loudnessRange(const std::vector<double>& shortTerm) {
+    const double absThreshold = loudnessToEnergy(ABSOLUTE_GATE_LUFS);
+
+    double sum = 0.0;
+    size_t count = 0;
+    for (double e : shortTerm) {
+        if (e > absThreshold) {
+            sum += e;
+            count++;
+        }
+    }
+    if (count == 0) return 0.0;
+
+    const double threshold = std::max(absThreshold, (sum / count) * std::pow(10.0, RANGE_RELATIVE_GATE_LU / 10.0));
+    std::vector<double> gated;
+    gated.reserve(count);
+    for (double e : shortTerm) {
+        if (e > threshold) gated.push_back(energyToLoudness(e));
+    }
+    if (gated.size() < 2) return 0.0;
+
+    std::sort(gated.begin(), gated.end());
+    const size_t last = gated.size() - 1;
+    double low = gated[static_cast<size_t>(std::lround(last * 0.10))];
+    double high = gated[static_cast<size_t>(std::lround(last * 0.95))];
+    return high - low;
+}
+
+LoudnessAnalyzer::Result LoudnessAnalyzer::result() const {
+    Result r;
+    r.integrated = gatedLoudness(blockEnergies);
+    r.range = loudnessRange(shortTermEnergies);
+    r.samplePeak = samplePeak;
+    r.truePeak = truePeak;
+    r.replayGain = std::isfinite(r.integrated) ? REPLAYGAIN_REFERENCE_LUFS - r.integrated : 0.0;
+    r.duration = sampleRate > 0 ? static_cast<double>(totalFrames) / sampleRate : 0.0;
+    return r;
+}
+
+LoudnessAnalyzer::Result LoudnessAnalyzer::combine(const std::vector<const LoudnessAnalyzer*>& tracks) {
+    std::vector<double> blocks;
+    std::vector<double> shortTerm;
+    Result r;
+
+    for (const LoudnessAnalyzer* track : tracks) {
+        if (!track) continue;
+        blocks.insert(blocks.end(), track->blockEnergies.begin(), track->blockEnergies.end());
+        shortTerm.insert(shortTerm.end(), track->shortTermEnergies.begin(), track->shortTermEnergies.end());
+        r.samplePeak = std::max(r.samplePeak, static_cast<double>(track->samplePeak));
+        r.truePeak = std::max(r.truePeak, static_cast<double>(track->truePeak));
+        if (track->sampleRate > 0) {
+            r.duration += static_cast<double>(track->totalFrames) / track->sampleRate;
+        }
+    }
+
+    r.integrated = gatedLoudness(blocks);
+    r.range = loudnessRange(shortTerm);
+    r.replayGain = std::isfinite(r.integrated) ? REPLAYGAIN_REFERENCE_LUFS - r.integrated : 0.0;
+    return r;
+}
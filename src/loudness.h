@@ -0,0 +1,85 @@
+#ifndef FFMPEG_LOUDNESS_H
+#define FFMPEG_LOUDNESS_H
+
+#include <cstdint>
+#include <vector>
+
+class FFmpegDecoder;
+
+/**
+ * LoudnessAnalyzer - EBU R128 / ITU-R BS.1770-4 loudness measurement
+ *
+ * Consumes interleaved float32 samples and measures:
+ * - Integrated loudness (LUFS, gated 400 ms blocks)
+ * - Loudness range (LU, EBU Tech 3342)
+ * - Sample peak and true peak (4x oversampled below 96 kHz)
+ *
+ * Gating blocks are kept so several analyzers can be combined into an
+ * album measurement. K-weighting runs two channels per SIMD vector.
+ */
+class LoudnessAnalyzer {
+public:
+    struct Result {
+        double integrated = 0.0;    // LUFS (-inf if nothing passes the gate)
+        double range = 0.0;         // LU
+        double samplePeak = 0.0;    // Linear
+        double truePeak = 0.0;      // Linear
+        double replayGain = 0.0;    // dB relative to the ReplayGain 2.0 reference (-18 LUFS)
+        double duration = 0.0;      // Seconds analyzed
+    };
+
+    LoudnessAnalyzer();
+
+    bool init(int channels, int sampleRate);
+    void process(const float* samples, int frames);
+
+    // Reads the decoder until EOF; false on a decode error
+    bool analyze(FFmpegDecoder& decoder);
+
+    Result result() const;
+
+    // Album measurement over the pooled gating blocks of several tracks
+    static Result combine(const std::vector<const LoudnessAnalyzer*>& tracks);
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    void processSegment(const float* samples, int frames);
+    void finishSubBlock();
+    void updatePeaks(const float* samples, int frames);
+
+    static double gatedLoudness(const std::vector<double>& blocks);
+    static double loudnessRange(const std::vector<double>& shortTerm);
+
+    int channels;
+    int sampleRate;
+    int subBlockFrames;             // 100 ms
+    int subBlockPos;
+    int64_t totalFrames;
+
+    Biquad shelf;                   // Stage 1: high shelf (head effects)
+    Biquad highpass;                // Stage 2: RLB high-pass
+    std::vector<double> state;      // 4 doubles per channel (2 per stage), padded to a channel pair
+    std::vector<double> weights;    // BS.1770 channel weights
+    std::vector<double> subBlockEnergy;
+
+    std::vector<double> recentSubBlocks;    // Ring of the last 30 sub-block energies (3 s)
+    int recentCount;
+    int recentPos;
+
+    std::vector<double> blockEnergies;      // 400 ms momentary blocks, 75% overlap
+    std::vector<double> shortTermEnergies;  // 3 s short-term windows, 100 ms hop
+
+    // Peak detection
+    int oversample;
+    int firTaps;
+    std::vector<float> polyphase;           // oversample * firTaps coefficients
+    std::vector<float> history;             // firTaps * 2 per channel (mirrored ring)
+    int historyPos;
+    float samplePeak;
+    float truePeak;
+};
+
+#endif // FFMPEG_LOUDNESS_H
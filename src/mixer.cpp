@@ -0,0 +1,296 @@
+#include "mixer.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define MIXER_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MIXER_NEON 1
+#endif
+
+// Four-lane float vector: two interleaved stereo frames (L, R, L, R) per vector
+#if defined(MIXER_SSE2)
+typedef __m128 vec4;
+static inline vec4 v4_gains(float left, float right) { return _mm_set_ps(right, left, right, left); }
+static inline vec4 v4_load(const float* p) { return _mm_loadu_ps(p); }
+static inline void v4_store(float* p, vec4 v) { _mm_storeu_ps(p, v); }
+static inline vec4 v4_madd(vec4 acc, vec4 a, vec4 b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+#elif defined(MIXER_NEON)
+typedef float32x4_t vec4;
+static inline vec4 v4_gains(float left, float right) { float t[4] = { left, right, left, right }; return vld1q_f32(t); }
+static inline vec4 v4_load(const float* p) { return vld1q_f32(p); }
+static inline void v4_store(float* p, vec4 v) { vst1q_f32(p, v); }
+static inline vec4 v4_madd(vec4 acc, vec4 a, vec4 b) { return vmlaq_f32(acc, a, b); }
+#else
+struct vec4 { float v[4]; };
+static inline vec4 v4_gains(float left, float right) { vec4 r = { { left, right, left, right } }; return r; }
+static inline vec4 v4_load(const float* p) { vec4 r = { { p[0], p[1], p[2], p[3] } }; return r; }
+static inline void v4_store(float* p, vec4 a) { p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3]; }
+static inline vec4 v4_madd(vec4 acc, vec4 a, vec4 b) {
+    vec4 r = { { acc.v[0] + a.v[0] * b.v[0], acc.v[1] + a.v[1] * b.v[1],
+                 acc.v[2] + a.v[2] * b.v[2], acc.v[3] + a.v[3] * b.v[3] } };
+    return r;
+}
+#endif
+
+// output += input * (left, right) over interleaved stereo samples
+static void mixConstant(float* output, const float* input, int samples, float left, float right) {
+    const vec4 gains = v4_gains(left, right);
+    int i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        v4_store(output + i, v4_madd(v4_load(output + i), v4_load(input + i), gains));
+    }
+    for (; i + 1 < samples; i += 2) {
+        output[i] += input[i] * left;
+        output[i + 1] += input[i + 1] * right;
+    }
+}
+
+// Same, with the gains moving linearly from (fromLeft, fromRight) to (toLeft, toRight)
+static void mixRamp(float* output, const float* input, int samples,
+                    float fromLeft, float fromRight, float toLeft, float toRight) {
+    int frames = samples / MultiTrackDecoder::CHANNELS;
+    if (frames <= 0) return;
+
+    float stepLeft = (toLeft - fromLeft) / frames;
+    float stepRight = (toRight - fromRight) / frames;
+    for (int frame = 0; frame < frames; frame++) {
+        float left = fromLeft + stepLeft * (frame + 1);
+        float right = fromRight + stepRight * (frame + 1);
+        output[frame * 2] += input[frame * 2] * left;
+        output[frame * 2 + 1] += input[frame * 2 + 1] * right;
+    }
+}
+
+MultiTrackDecoder::MultiTrackDecoder(int sampleRate, int threads)
+    : sampleRate(sampleRate > 0 ? sampleRate : 44100)
+    , position(0)
+    // The calling thread decodes one track itself; threads = 1 decodes everything inline
+    , pool((threads > 0 ? threads : ThreadPool::defaultSize(1)) - 1)
+{
+}
+
+MultiTrackDecoder::~MultiTrackDecoder() {
+    pool.wait();
+}
+
+int MultiTrackDecoder::addTrack(const std::string& path, const DecoderOpenOptions& options) {
+    std::unique_ptr<Track> track(new Track());
+    track->decoder.reset(new FFmpegDecoder());
+
+    // Mixing assumes stereo at the mixer's rate with every packet decoded, so
+    // only the I/O options carry over
+    DecoderOpenOptions trackOptions;
+    trackOptions.mmap = options.mmap;
+    trackOptions.io = options.io;
+
+    // Tracks already decode in parallel; codec threads would only oversubscribe
+    if (!track->decoder->open(path.c_str(), sampleRate, 1, trackOptions)) {
+        lastError = track->decoder->getLastError();
+        return -1;
+    }
+    if (position > 0 && !track->decoder->seekExact(position)) {
+        lastError = track->decoder->getLastError();
+        return -1;
+    }
+
+    track->info.path = path;
+    track->info.duration = track->decoder->getDuration();
+    bool anySolo = false;
+    for (const std::unique_ptr<Track>& other : tracks) anySolo = anySolo || other->info.solo;
+    targetGains(*track, anySolo, &track->appliedLeft, &track->appliedRight);
+
+    tracks.push_back(std::move(track));
+    lastError = DecoderError();
+    return static_cast<int>(tracks.size()) - 1;
+}
+
+bool MultiTrackDecoder::removeTrack(int index) {
+    if (!valid(index)) return false;
+    tracks.erase(tracks.begin() + index);
+    return true;
+}
+
+void MultiTrackDecoder::close() {
+    tracks.clear();
+    position = 0;
+    lastError = DecoderError();
+}
+
+MultiTrackDecoder::TrackInfo MultiTrackDecoder::getTrackInfo(int index) const {
+    return valid(index) ? tracks[index]->info : TrackInfo();
+}
+
+DecoderMemory MultiTrackDecoder::getTrackMemory(int index) const {
+    return valid(index) ? tracks[index]->decoder->getMemoryUsage() : DecoderMemory();
+}
+
+bool MultiTrackDecoder::setTrackGain(int index, float gain) {
+    if (!valid(index) || !(gain >= 0.0f)) return false;
+    tracks[index]->info.gain = gain;
+    return true;
+}
+
+bool MultiTrackDecoder::setTrackPan(int index, float pan) {
+    if (!valid(index) || !(pan >= -1.0f && pan <= 1.0f)) return false;
+    tracks[index]->info.pan = pan;
+    return true;
+}
+
+bool MultiTrackDecoder::setTrackMute(int index, bool muted) {
+    if (!valid(index)) return false;
+    tracks[index]->info.muted = muted;
+    return true;
+}
+
+bool MultiTrackDecoder::setTrackSolo(int index, bool solo) {
+    if (!valid(index)) return false;
+    tracks[index]->info.solo = solo;
+    return true;
+}
+
+void MultiTrackDecoder::targetGains(const Track& track, bool anySolo, float* left, float* right) const {
+    if (track.info.muted || (anySolo && !track.info.solo)) {
+        *left = 0.0f;
+        *right = 0.0f;
+        return;
+    }
+    *left = track.info.gain * std::min(1.0f, 1.0f - track.info.pan);
+    *right = track.info.gain * std::min(1.0f, 1.0f + track.info.pan);
+}
+
+void MultiTrackDecoder::decodeAll(float* const* outputs, int numSamples) {
+    auto decode = [this, outputs, numSamples](size_t index) {
+        Track& track = *tracks[index];
+        track.samplesRead = track.info.ended ? 0 : track.decoder->read(outputs[index], numSamples);
+        if (track.samplesRead < numSamples) track.info.ended = true;
+    };
+
+    for (size_t i = 1; i < tracks.size(); i++) {
+        pool.submit([decode, i] { decode(i); });
+    }
+    if (!tracks.empty()) decode(0);
+    pool.wait();
+}
+
+int MultiTrackDecoder::readMixed(float* output, int numSamples) {
+    numSamples -= numSamples % CHANNELS;
+    if (!output || numSamples <= 0) return 0;
+
+    std::vector<float*> outputs(tracks.size());
+    for (size_t i = 0; i < tracks.size(); i++) {
+        tracks[i]->buffer.resize(numSamples);
+        outputs[i] = tracks[i]->buffer.data();
+    }
+    decodeAll(outputs.data(), numSamples);
+
+    bool anySolo = false;
+    int mixed = 0;
+    for (const std::unique_ptr<Track>& track : tracks) {
+        anySolo = anySolo || track->info.solo;
+        mixed = std::max(mixed, track->samplesRead);
+    }
+
+    memset(output, 0, numSamples * sizeof(float));
+    for (const std::unique_ptr<Track>& track : tracks) {
+        float left = 0.0f, right = 0.0f;
+        targetGains(*track, anySolo, &left, &right);
+
+        const float* input = track->buffer.data();
+        int samples = track->samplesRead - track->samplesRead % CHANNELS;
+        if (left != track->appliedLeft || right != track->appliedRight) {
+            mixRamp(output, input, samples, track->appliedLeft, track->appliedRight, left, right);
+        } else if (left != 0.0f || right != 0.0f) {
+            mixConstant(output, input, samples, left, right);
+        }
+        track->appliedLeft = left;
+        track->appliedRight = right;
+    }
+
+    position += mixed / CHANNELS;
+    return mixed;
+}
+
+int MultiTrackDecoder::readSeparate(float* const* outputs, int numSamples, int* samplesRead) {
+    if (!outputs || numSamples <= 0) return 0;
+
+    decodeAll(outputs, numSamples);
+
+    int longest = 0;
+    for (size_t i = 0; i < tracks.size(); i++) {
+        if (samplesRead) samplesRead[i] = tracks[i]->samplesRead;
+        longest = std::max(longest, tracks[i]->samplesRead);
+    }
+    position += longest / CHANNELS;
+    return longest;
+}
+
+bool MultiTrackDecoder::seek(double seconds) {
+    if (seconds < 0.0) seconds = 0.0;
+
+    std::vector<FFmpegDecoder*> decoders;
+    for (const std::unique_ptr<Track>& track : tracks) decoders.push_back(track->decoder.get());
+
+    std::unique_ptr<bool[]> results(new bool[tracks.size()]);
+    bool ok = seekGroup(decoders.data(), static_cast<int>(decoders.size()), seconds, pool, results.get());
+    for (size_t i = 0; i < tracks.size(); i++) {
+        // A track that failed to seek would play out of sync; silence it instead
+        tracks[i]->info.ended = !results[i];
+        if (!results[i] && lastError.code == 0) lastError = tracks[i]->decoder->getLastError();
+    }
+    if (ok) lastError = DecoderError();
+
+    position = llround(seconds * sampleRate);
+    return ok;
+}
+
+bool MultiTrackDecoder::seekGroup(FFmpegDecoder* const* decoders, int count, double seconds,
+                                  ThreadPool& pool, bool* results) {
+    if (count <= 0) return true;
+
+    std::vector<char> succeeded(count, 0);
+    auto seekOne = [decoders, seconds, &succeeded](int index) {
+        FFmpegDecoder* decoder = decoders[index];
+        succeeded[index] = decoder->seekExact(llround(seconds * decoder->getSampleRate()));
+    };
+
+    if (count == 1) {
+        seekOne(0);
+    } else {
+        // Waits for its own seeks only (not pool.wait()), so the pool can be shared
+        std::mutex mutex;
+        std::condition_variable done;
+        int remaining = count - 1;
+        for (int i = 1; i < count; i++) {
+            pool.submit([&, i] {
+                seekOne(i);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--remaining == 0) done.notify_one();
+            });
+        }
+        seekOne(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&remaining] { return remaining == 0; });
+    }
+
+    bool ok = true;
+    for (int i = 0; i < count; i++) {
+        if (results) results[i] = succeeded[i] != 0;
+        ok = ok && succeeded[i];
+    }
+    return ok;
+}
+
+double MultiTrackDecoder::getDuration() const {
+    double longest = 0.0;
+    for (const std::unique_ptr<Track>& track : tracks) {
+        longest = std::max(longest, track->info.duration);
+    }
+    return longest;
+}
@@ -0,0 +1,111 @@
+#ifndef FFMPEG_MIXER_H
+#define FFMPEG_MIXER_H
+
+#include "decoder.h"
+#include "thread_pool.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * MultiTrackDecoder - Synchronized decoding and mixing of several files
+ *
+ * Owns one decoder per track, all opened at the same output rate as
+ * interleaved stereo float32. Each readMixed() decodes every track in
+ * parallel on the mixer's pool (the calling thread takes the first track),
+ * then sums them with per-track gain, pan, mute and solo into one buffer.
+ * Muted and un-soloed tracks are still decoded so they stay in sync.
+ *
+ * Pan is a balance control: 0 leaves both channels at unity, -1 silences
+ * the right channel, 1 the left. Gain, pan, mute and solo changes ramp
+ * linearly across the next read so they don't click.
+ *
+ * Not thread-safe: one thread drives the mixer.
+ */
+class MultiTrackDecoder {
+public:
+    static const int CHANNELS = 2;
+
+    struct TrackInfo {
+        std::string path;
+        float gain = 1.0f;
+        float pan = 0.0f;
+        bool muted = false;
+        bool solo = false;
+        bool ended = false;
+        double duration = 0.0;
+    };
+
+    // Tracks decoded at once, including the calling thread: 0 = one per
+    // hardware thread, 1 = everything on the caller (no pool threads)
+    explicit MultiTrackDecoder(int sampleRate = 44100, int threads = 0);
+    ~MultiTrackDecoder();
+
+    MultiTrackDecoder(const MultiTrackDecoder&) = delete;
+    MultiTrackDecoder& operator=(const MultiTrackDecoder&) = delete;
+
+    // Returns the track index, or -1 (see getLastError()). New tracks start
+    // at the mixer's current position. Only options.mmap and options.io apply.
+    int addTrack(const std::string& path, const DecoderOpenOptions& options = DecoderOpenOptions());
+    // Later tracks move down one index
+    bool removeTrack(int index);
+    // Removes every track and rewinds to 0
+    void close();
+    int getTrackCount() const { return static_cast<int>(tracks.size()); }
+    TrackInfo getTrackInfo(int index) const;
+    DecoderMemory getTrackMemory(int index) const;
+
+    bool setTrackGain(int index, float gain);
+    bool setTrackPan(int index, float pan);
+    bool setTrackMute(int index, bool muted);
+    bool setTrackSolo(int index, bool solo);
+
+    // numSamples interleaved stereo samples. Returns the samples of the
+    // longest track still playing (shorter tracks contribute silence), 0
+    // once every track has ended.
+    int readMixed(float* output, int numSamples);
+
+    // Unmixed: one buffer of numSamples per track, samplesRead[i] per track
+    int readSeparate(float* const* outputs, int numSamples, int* samplesRead);
+
+    // Sample-accurate: every track resumes at the same output frame
+    bool seek(double seconds);
+
+    // Seeks each decoder to the output frame at `seconds` with seekExact(), in
+    // parallel on pool (the calling thread takes the first decoder). Waits
+    // only for its own seeks, so the pool may be shared. False if any failed;
+    // results[i] (optional) is each decoder's outcome.
+    static bool seekGroup(FFmpegDecoder* const* decoders, int count, double seconds,
+                          ThreadPool& pool, bool* results = nullptr);
+
+    double getDuration() const;     // Longest track
+    double getPosition() const { return static_cast<double>(position) / sampleRate; }
+    int getSampleRate() const { return sampleRate; }
+    int getThreadCount() const { return pool.size() + 1; }
+
+    DecoderError getLastError() const { return lastError; }
+
+private:
+    struct Track {
+        TrackInfo info;
+        std::unique_ptr<FFmpegDecoder> decoder;
+        std::vector<float> buffer;  // Decoded block for readMixed()
+        int samplesRead = 0;
+        float appliedLeft = 0.0f;   // Channel gains used for the previous block (ramp start)
+        float appliedRight = 0.0f;
+    };
+
+    void decodeAll(float* const* outputs, int numSamples);
+    void targetGains(const Track& track, bool anySolo, float* left, float* right) const;
+    bool valid(int index) const { return index >= 0 && index < static_cast<int>(tracks.size()); }
+
+    int sampleRate;
+    int64_t position;               // Output frames since 0
+    std::vector<std::unique_ptr<Track>> tracks;
+    DecoderError lastError;
+
+    // Declared last: joined before the tracks are destroyed
+    ThreadPool pool;
+};
+
+#endif // FFMPEG_MIXER_H
@@ -0,0 +1,203 @@
+#include "pool.h"
+#include <cstdlib>
+
+extern "C" {
+#include <libavutil/error.h>
+}
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+static void* allocAligned(size_t alignment, size_t size) {
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void* memory = nullptr;
+    return posix_memalign(&memory, alignment, size) == 0 ? memory : nullptr;
+#endif
+}
+
+static void freeAligned(void* memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+// Never destroyed: decoders may still release blocks during process teardown
+SlabPool& SlabPool::instance() {
+    static SlabPool* pool = new SlabPool();
+    return *pool;
+}
+
+int SlabPool::classFor(size_t size) {
+    size_t capacity = MIN_CLASS;
+    for (int index = 0; index < CLASS_COUNT; index++, capacity <<= 1) {
+        if (size <= capacity) return index;
+    }
+    return -1;
+}
+
+size_t SlabPool::capacityFor(size_t size) {
+    int index = classFor(size);
+    if (index < 0) return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    return MIN_CLASS << index;
+}
+
+void* SlabPool::allocate(size_t size) {
+    if (size == 0) return nullptr;
+
+    size_t capacity = capacityFor(size);
+    int index = classFor(size);
+    if (index >= 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeLists[index].empty()) {
+            void* block = freeLists[index].back();
+            freeLists[index].pop_back();
+            stats.hits++;
+            stats.cached -= capacity;
+            stats.inUse += capacity;
+            return block;
+        }
+    }
+
+    void* block = allocAligned(ALIGNMENT, capacity);
+    if (!block) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.misses++;
+    stats.inUse += capacity;
+    return block;
+}
+
+void SlabPool::release(void* block, size_t size) {
+    if (!block) return;
+
+    size_t capacity = capacityFor(size);
+    int index = classFor(size);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.inUse -= capacity;
+        if (index >= 0 && stats.cached + static_cast<int64_t>(capacity) <= static_cast<int64_t>(MAX_CACHED)) {
+            freeLists[index].push_back(block);
+            stats.cached += capacity;
+            return;
+        }
+    }
+    freeAligned(block);
+}
+
+void SlabPool::trim() {
+    std::vector<void*> blocks;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::vector<void*>& list : freeLists) {
+            blocks.insert(blocks.end(), list.begin(), list.end());
+            list.clear();
+        }
+        stats.cached = 0;
+    }
+    for (void* block : blocks) freeAligned(block);
+}
+
+SlabStats SlabPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+FramePool::FramePool()
+    : pool(nullptr)
+    , bufferSize(0)
+{
+}
+
+FramePool::~FramePool() {
+    reset();
+}
+
+void FramePool::attach(AVCodecContext* codecCtx) {
+    reset();
+    requests.store(0, std::memory_order_relaxed);
+    misses.store(0, std::memory_order_relaxed);
+    fallbacks.store(0, std::memory_order_relaxed);
+
+    codecCtx->opaque = this;
+    codecCtx->get_buffer2 = &FramePool::getBuffer;
+}
+
+void FramePool::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    av_buffer_pool_uninit(&pool);
+    bufferSize = 0;
+}
+
+size_t FramePool::getBufferSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bufferSize;
+}
+
+int FramePool::getBuffer(AVCodecContext* codecCtx, AVFrame* frame, int flags) {
+    FramePool* self = static_cast<FramePool*>(codecCtx->opaque);
+    AVSampleFormat format = static_cast<AVSampleFormat>(frame->format);
+    int channels = frame->ch_layout.nb_channels;
+    int planes = av_sample_fmt_is_planar(format) ? channels : 1;
+
+    if (!(codecCtx->codec->capabilities & AV_CODEC_CAP_DR1) || planes <= 0 || planes > AV_NUM_DATA_POINTERS) {
+        self->fallbacks.fetch_add(1, std::memory_order_relaxed);
+        return avcodec_default_get_buffer2(codecCtx, frame, flags);
+    }
+
+    int linesize = 0;
+    int ret = av_samples_get_buffer_size(&linesize, channels, frame->nb_samples, format, 0);
+    if (ret < 0) return ret;
+
+    // Same slack as libavcodec's default audio pool, for SIMD over-reads
+    size_t needed = static_cast<size_t>(linesize) + 16 + 64 - 1;
+
+    std::lock_guard<std::mutex> lock(self->mutex);
+    if (!self->pool || needed > self->bufferSize) {
+        av_buffer_pool_uninit(&self->pool);
+        self->bufferSize = SlabPool::capacityFor(needed);
+        self->pool = av_buffer_pool_init2(self->bufferSize, self, &FramePool::allocBuffer, nullptr);
+        if (!self->pool) {
+            self->bufferSize = 0;
+            return AVERROR(ENOMEM);
+        }
+    }
+
+    for (int i = 0; i < planes; i++) {
+        frame->buf[i] = av_buffer_pool_get(self->pool);
+        if (!frame->buf[i]) {
+            for (int j = 0; j < i; j++) av_buffer_unref(&frame->buf[j]);
+            return AVERROR(ENOMEM);
+        }
+        frame->data[i] = frame->buf[i]->data;
+    }
+    frame->linesize[0] = linesize;
+    frame->extended_data = frame->data;
+    self->requests.fetch_add(planes, std::memory_order_relaxed);
+    return 0;
+}
+
+// Called by the AVBufferPool (under FramePool::mutex) when it has no free buffer
+AVBufferRef* FramePool::allocBuffer(void* opaque, size_t size) {
+    FramePool* self = static_cast<FramePool*>(opaque);
+    uint8_t* data = static_cast<uint8_t*>(SlabPool::instance().allocate(size));
+    if (!data) return nullptr;
+
+    AVBufferRef* buffer = av_buffer_create(data, size, &FramePool::freeBlock,
+                                           reinterpret_cast<void*>(static_cast<uintptr_t>(size)), 0);
+    if (!buffer) {
+        SlabPool::instance().release(data, size);
+        return nullptr;
+    }
+    self->misses.fetch_add(1, std::memory_order_relaxed);
+    return buffer;
+}
+
+// Runs when the AVBufferPool itself is freed; may be after the FramePool is gone
+void FramePool::freeBlock(void* opaque, uint8_t* data) {
+    SlabPool::instance().release(data, static_cast<size_t>(reinterpret_cast<uintptr_t>(opaque)));
+}
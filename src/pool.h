@@ -0,0 +1,116 @@
+#ifndef FFMPEG_POOL_H
+#define FFMPEG_POOL_H
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * Counters of the process-wide slab pool. Bytes are block capacities.
+ */
+struct SlabStats {
+    int64_t hits = 0;           // Allocations served from the cache
+    int64_t misses = 0;         // Allocations that went to the heap
+    int64_t inUse = 0;          // Bytes handed out and not yet released
+    int64_t cached = 0;         // Bytes held for reuse
+};
+
+/**
+ * SlabPool - Process-wide cache of page-aligned buffers in power-of-two size classes
+ *
+ * Decoders allocate the same few buffer sizes on every open (staging
+ * buffers, prefetch rings, direct-I/O bounce buffers) and free them on
+ * close. Recycling them by size class keeps library scans and long-running
+ * servers from fragmenting the heap. Requests above the largest class go
+ * straight to the heap; the cache is capped at MAX_CACHED bytes.
+ *
+ * Blocks are aligned to ALIGNMENT, so they are valid O_DIRECT targets.
+ * release() must be given the size that was passed to allocate() (or
+ * anything that rounds to the same class, such as capacityFor()).
+ */
+class SlabPool {
+public:
+    static const size_t ALIGNMENT = 4096;
+    static const size_t MIN_CLASS = 4096;                   // 4 KB
+    static const int CLASS_COUNT = 11;                      // 4 KB .. 4 MB
+    static const size_t MAX_CACHED = 64u * 1024 * 1024;
+
+    static SlabPool& instance();
+
+    // nullptr if out of memory
+    void* allocate(size_t size);
+    void release(void* block, size_t size);
+
+    // Usable bytes of a block allocated with this size
+    static size_t capacityFor(size_t size);
+
+    // Frees everything cached
+    void trim();
+    SlabStats getStats() const;
+
+private:
+    SlabPool() = default;
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    static int classFor(size_t size);       // -1 above the largest class
+
+    std::vector<void*> freeLists[CLASS_COUNT];
+    mutable std::mutex mutex;
+    SlabStats stats;
+};
+
+/**
+ * FramePool - get_buffer2 allocator for one audio decoder
+ *
+ * Serves decoded frame planes from a single AVBufferPool sized for the
+ * codec's frames, backed by SlabPool blocks, so the decode loop reuses the
+ * same few buffers instead of going through malloc/free per frame. A frame
+ * larger than the current buffers replaces the pool (outstanding frames keep
+ * the old one alive until they are released). Codecs without
+ * AV_CODEC_CAP_DR1, or with more planes than AVFrame::buf holds, use
+ * avcodec_default_get_buffer2.
+ *
+ * get_buffer2 may be called from codec threads; the pool is guarded and the
+ * counters are atomic, so stats can be read while decoding.
+ */
+class FramePool {
+public:
+    FramePool();
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Installs the allocator and resets the counters; call before avcodec_open2
+    void attach(AVCodecContext* codecCtx);
+    // Drops the pool; call after the codec context is freed
+    void reset();
+
+    int64_t getRequests() const { return requests.load(std::memory_order_relaxed); }
+    int64_t getMisses() const { return misses.load(std::memory_order_relaxed); }
+    int64_t getFallbacks() const { return fallbacks.load(std::memory_order_relaxed); }
+    size_t getBufferSize() const;
+
+private:
+    static int getBuffer(AVCodecContext* codecCtx, AVFrame* frame, int flags);
+    static AVBufferRef* allocBuffer(void* opaque, size_t size);
+    static void freeBlock(void* opaque, uint8_t* data);
+
+    mutable std::mutex mutex;
+    AVBufferPool* pool;
+    size_t bufferSize;
+
+    std::atomic<int64_t> requests{0};      // Plane buffers handed to the codec
+    std::atomic<int64_t> misses{0};        // ...that needed a new allocation
+    std::atomic<int64_t> fallbacks{0};     // Frames left to the default allocator
+};
+
+#endif // FFMPEG_POOL_H
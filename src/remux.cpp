@@ -0,0 +1,293 @@
+#include "remux.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+bool Remuxer::fail(const std::string& message) {
+    error = message;
+    return false;
+}
+
+void Remuxer::cleanup(AVFormatContext** in, AVFormatContext** out) {
+    if (*out) {
+        if ((*out)->pb && !((*out)->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&(*out)->pb);
+        }
+        avformat_free_context(*out);
+        *out = nullptr;
+    }
+
+    if (*in) {
+        avformat_close_input(in);
+        *in = nullptr;
+    }
+}
+
+// Applies tag overrides/removals; stream dictionaries only get keys they already carry
+static void applyTags(AVDictionary** dict, const RemuxOptions& options, bool existingOnly) {
+    for (const auto& tag : options.metadata) {
+        if (existingOnly && !av_dict_get(*dict, tag.first.c_str(), nullptr, 0)) continue;
+        av_dict_set(dict, tag.first.c_str(), tag.second.c_str(), 0);
+    }
+    for (const std::string& key : options.removeTags) {
+        av_dict_set(dict, key.c_str(), nullptr, 0);
+    }
+}
+
+// True when both paths name one existing file (links and relative paths included)
+static bool sameFile(const std::string& a, const std::string& b) {
+    std::error_code ec;
+    return std::filesystem::equivalent(std::filesystem::u8path(a), std::filesystem::u8path(b), ec);
+}
+
+bool Remuxer::run(const std::string& inputPath, const std::string& outputPath,
+                  const RemuxOptions& options, JobControl* control) {
+    res = Result();
+    error.clear();
+    cancelled = false;
+
+    JobControl localControl;
+    if (!control) control = &localControl;
+    control->start();
+
+    // Opening the output truncates it before a single packet is read
+    if (sameFile(inputPath, outputPath)) {
+        return fail("Output is the input file: " + outputPath);
+    }
+
+    AVFormatContext* in = nullptr;
+    AVFormatContext* out = nullptr;
+
+    // Open input
+    if (avformat_open_input(&in, inputPath.c_str(), nullptr, nullptr) < 0) {
+        return fail("Failed to open input: " + inputPath);
+    }
+    if (avformat_find_stream_info(in, nullptr) < 0) {
+        cleanup(&in, &out);
+        return fail("Failed to read stream info: " + inputPath);
+    }
+
+    int audioIndex = av_find_best_stream(in, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (audioIndex < 0) {
+        cleanup(&in, &out);
+        return fail("No audio stream: " + inputPath);
+    }
+    AVStream* inAudio = in->streams[audioIndex];
+
+    // Create output context
+    const char* formatName = options.format.empty() ? nullptr : options.format.c_str();
+    if (avformat_alloc_output_context2(&out, nullptr, formatName, outputPath.c_str()) < 0 || !out) {
+        out = nullptr;
+        cleanup(&in, &out);
+        return fail("Unsupported output format: " + outputPath);
+    }
+
+    if (avformat_query_codec(out->oformat, inAudio->codecpar->codec_id, FF_COMPLIANCE_NORMAL) == 0) {
+        cleanup(&in, &out);
+        return fail("Codec not supported by the output container: " + outputPath);
+    }
+
+    AVStream* outAudio = avformat_new_stream(out, nullptr);
+    if (!outAudio || avcodec_parameters_copy(outAudio->codecpar, inAudio->codecpar) < 0) {
+        cleanup(&in, &out);
+        return fail("Failed to create output stream");
+    }
+    outAudio->codecpar->codec_tag = 0;      // Tags are container specific
+    outAudio->time_base = inAudio->time_base;
+
+    // Cover art: an attached-picture stream written as a single packet
+    AVStream* inPicture = nullptr;
+    if (options.coverArt == RemuxOptions::COVER_KEEP) {
+        for (unsigned int i = 0; i < in->nb_streams; i++) {
+            if (in->streams[i]->disposition & AV_DISPOSITION_ATTACHED_PIC) {
+                inPicture = in->streams[i];
+                break;
+            }
+        }
+    }
+
+    AVCodecID pictureCodec = AV_CODEC_ID_NONE;
+    if (inPicture) {
+        pictureCodec = inPicture->codecpar->codec_id;
+    } else if (options.coverArt == RemuxOptions::COVER_REPLACE && !options.coverArtData.empty()) {
+        pictureCodec = options.coverArtMimeType == "image/png" ? AV_CODEC_ID_PNG : AV_CODEC_ID_MJPEG;
+    }
+
+    // Containers without picture support just lose the cover
+    AVStream* outPicture = nullptr;
+    if (pictureCodec != AV_CODEC_ID_NONE && avformat_query_codec(out->oformat, pictureCodec, FF_COMPLIANCE_NORMAL) == 1) {
+        outPicture = avformat_new_stream(out, nullptr);
+        if (!outPicture) {
+            cleanup(&in, &out);
+            return fail("Failed to create cover art stream");
+        }
+        if (inPicture) {
+            avcodec_parameters_copy(outPicture->codecpar, inPicture->codecpar);
+        } else {
+            outPicture->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+            outPicture->codecpar->codec_id = pictureCodec;
+        }
+        outPicture->codecpar->codec_tag = 0;
+        outPicture->disposition = AV_DISPOSITION_ATTACHED_PIC;
+    }
+
+    if (options.copyMetadata) {
+        av_dict_copy(&out->metadata, in->metadata, 0);
+        av_dict_copy(&outAudio->metadata, inAudio->metadata, 0);
+    }
+    applyTags(&out->metadata, options, false);
+    applyTags(&outAudio->metadata, options, true);
+
+    // Open output file
+    if (!(out->oformat->flags & AVFMT_NOFILE)) {
+        if (avio_open(&out->pb, outputPath.c_str(), AVIO_FLAG_WRITE) < 0) {
+            cleanup(&in, &out);
+            return fail("Failed to open output: " + outputPath);
+        }
+    }
+
+    if (avformat_write_header(out, nullptr) < 0) {
+        cleanup(&in, &out);
+        std::remove(outputPath.c_str());
+        return fail("Failed to write header: " + outputPath);
+    }
+
+    bool ok = true;
+    if (outPicture) {
+        AVPacket* picture = av_packet_alloc();
+        if (!picture) {
+            ok = fail("Out of memory");
+        } else {
+            if (inPicture) {
+                ok = av_packet_ref(picture, &inPicture->attached_pic) >= 0;
+            } else {
+                ok = av_new_packet(picture, static_cast<int>(options.coverArtData.size())) >= 0;
+                if (ok) memcpy(picture->data, options.coverArtData.data(), options.coverArtData.size());
+            }
+
+            if (ok) {
+                picture->stream_index = outPicture->index;
+                picture->flags |= AV_PKT_FLAG_KEY;
+                picture->pts = 0;
+                picture->dts = 0;
+                ok = av_interleaved_write_frame(out, picture) >= 0;
+            }
+            if (!ok) fail("Failed to write cover art");
+            av_packet_free(&picture);
+        }
+    }
+
+    if (ok) {
+        ok = copyPackets(in, out, audioIndex, outAudio, options, control);
+    }
+
+    if (av_write_trailer(out) < 0 && ok) {
+        ok = fail("Failed to finalize output: " + outputPath);
+    }
+
+    cleanup(&in, &out);
+
+    if (!ok) {
+        std::remove(outputPath.c_str());
+        return false;
+    }
+
+    res.elapsed = control->elapsed();
+    control->report(res.duration, res.duration, true);
+    return true;
+}
+
+bool Remuxer::copyPackets(AVFormatContext* in, AVFormatContext* out, int inIndex, AVStream* outStream,
+                          const RemuxOptions& options, JobControl* control) {
+    AVStream* inStream = in->streams[inIndex];
+    const AVRational tb = inStream->time_base;
+    const int64_t origin = inStream->start_time != AV_NOPTS_VALUE ? inStream->start_time : 0;
+
+    const bool trimStart = options.start > 0.0;
+    const bool trimEnd = options.end > 0.0 && options.end > options.start;
+    const int64_t startTs = origin + av_rescale_q(static_cast<int64_t>(options.start * AV_TIME_BASE), AV_TIME_BASE_Q, tb);
+    const int64_t endTs = origin + av_rescale_q(static_cast<int64_t>(options.end * AV_TIME_BASE), AV_TIME_BASE_Q, tb);
+
+    double total = trimEnd ? options.end : (in->duration > 0 ? static_cast<double>(in->duration) / AV_TIME_BASE : 0.0);
+    total = total > options.start ? total - options.start : 0.0;
+
+    if (trimStart) {
+        // Lands on the packet at or before start; earlier packets are dropped below
+        av_seek_frame(in, inIndex, startTs, AVSEEK_FLAG_BACKWARD);
+    }
+
+    AVPacket* pkt = av_packet_alloc();
+    if (!pkt) return fail("Out of memory");
+
+    int64_t offset = AV_NOPTS_VALUE;
+    int64_t firstTs = AV_NOPTS_VALUE;
+    int64_t lastEnd = AV_NOPTS_VALUE;
+    bool ok = true;
+
+    while (true) {
+        if (control->isCancelled()) {
+            cancelled = true;
+            ok = fail("Remux cancelled");
+            break;
+        }
+
+        int ret = av_read_frame(in, pkt);
+        if (ret == AVERROR_EOF) break;
+        if (ret < 0) {
+            ok = fail("Read error");
+            break;
+        }
+
+        if (pkt->stream_index != inIndex) {
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+        if (ts != AV_NOPTS_VALUE) {
+            if (trimStart && ts + pkt->duration <= startTs) {
+                av_packet_unref(pkt);
+                continue;
+            }
+            if (trimEnd && ts >= endTs) {
+                av_packet_unref(pkt);
+                break;
+            }
+
+            if (firstTs == AV_NOPTS_VALUE) firstTs = ts;
+            lastEnd = ts + pkt->duration;
+        }
+
+        // Trimmed output starts at zero
+        if (trimStart) {
+            if (offset == AV_NOPTS_VALUE) {
+                offset = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : (ts != AV_NOPTS_VALUE ? ts : 0);
+            }
+            if (pkt->pts != AV_NOPTS_VALUE) pkt->pts -= offset;
+            if (pkt->dts != AV_NOPTS_VALUE) pkt->dts -= offset;
+        }
+
+        res.packets++;
+        res.bytes += pkt->size;
+
+        av_packet_rescale_ts(pkt, tb, outStream->time_base);
+        pkt->stream_index = outStream->index;
+        pkt->pos = -1;
+
+        if (av_interleaved_write_frame(out, pkt) < 0) {
+            ok = fail("Write error");
+            break;
+        }
+
+        if (firstTs != AV_NOPTS_VALUE) {
+            control->report((lastEnd - firstTs) * av_q2d(tb), total);
+        }
+    }
+
+    av_packet_free(&pkt);
+
+    if (firstTs != AV_NOPTS_VALUE && lastEnd != AV_NOPTS_VALUE) {
+        res.duration = (lastEnd - firstTs) * av_q2d(tb);
+    }
+    return ok;
+}
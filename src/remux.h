@@ -0,0 +1,71 @@
+#ifndef FFMPEG_REMUX_H
+#define FFMPEG_REMUX_H
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+#include "job.h"
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Options for a stream-copy remux.
+ *
+ * Trimming snaps to packet boundaries: the first packet is the one that
+ * contains start, the last one ends at or after end.
+ */
+struct RemuxOptions {
+    enum CoverArtAction {
+        COVER_KEEP,
+        COVER_REPLACE,
+        COVER_REMOVE
+    };
+
+    std::string format;                             // Muxer name; empty = from the file extension
+    double start = 0.0;                             // Seconds
+    double end = 0.0;                               // Seconds; 0 = end of file
+    bool copyMetadata = true;
+    std::map<std::string, std::string> metadata;    // Tags to set (override copied ones)
+    std::vector<std::string> removeTags;
+    CoverArtAction coverArt = COVER_KEEP;
+    std::vector<uint8_t> coverArtData;              // COVER_REPLACE
+    std::string coverArtMimeType;                   // "image/jpeg" or "image/png"
+};
+
+/**
+ * Remuxer - Copies the audio stream (and cover art) into a new container
+ * without decoding
+ */
+class Remuxer {
+public:
+    struct Result {
+        double duration = 0.0;      // Seconds of audio written
+        double elapsed = 0.0;
+        int64_t packets = 0;
+        int64_t bytes = 0;          // Audio payload bytes
+    };
+
+    // On failure the partial output is removed and getError() says why.
+    // Refuses to overwrite the input in place.
+    bool run(const std::string& inputPath, const std::string& outputPath,
+             const RemuxOptions& options, JobControl* control = nullptr);
+
+    const Result& result() const { return res; }
+    const std::string& getError() const { return error; }
+    bool wasCancelled() const { return cancelled; }
+
+private:
+    bool fail(const std::string& message);
+    bool copyPackets(AVFormatContext* in, AVFormatContext* out, int inIndex, AVStream* outStream,
+                     const RemuxOptions& options, JobControl* control);
+    void cleanup(AVFormatContext** in, AVFormatContext** out);
+
+    Result res;
+    std::string error;
+    bool cancelled = false;
+};
+
+#endif // FFMPEG_REMUX_H
@@ -0,0 +1,286 @@
+#include "spectrum.h"
+#include "decoder.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const int MIN_FFT_SIZE = 16;
+static const int MAX_FFT_SIZE = 65536;
+static const int READ_CHUNK_FRAMES = 16384;
+
+static bool isPowerOfTwo(int v) {
+    return v > 0 && (v & (v - 1)) == 0;
+}
+
+bool RealFFT::init(int size) {
+    if (!isPowerOfTwo(size) || size < MIN_FFT_SIZE || size > MAX_FFT_SIZE) return false;
+
+    n = size;
+    const int half = n / 2;
+
+    int bits = 0;
+    while ((1 << bits) < half) bits++;
+    bitReverse.resize(half);
+    for (int i = 0; i < half; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        bitReverse[i] = r;
+    }
+
+    twiddleRe.resize(half / 2);
+    twiddleIm.resize(half / 2);
+    for (int i = 0; i < half / 2; i++) {
+        double theta = -2.0 * M_PI * i / half;
+        twiddleRe[i] = static_cast<float>(std::cos(theta));
+        twiddleIm[i] = static_cast<float>(std::sin(theta));
+    }
+
+    unpackRe.resize(half + 1);
+    unpackIm.resize(half + 1);
+    for (int k = 0; k <= half; k++) {
+        double theta = 2.0 * M_PI * k / n;
+        unpackRe[k] = static_cast<float>(std::cos(theta));
+        unpackIm[k] = static_cast<float>(std::sin(theta));
+    }
+
+    workRe.resize(half);
+    workIm.resize(half);
+    return true;
+}
+
+void RealFFT::forward(const float* in, float* re, float* im) {
+    const int half = n / 2;
+    float* zr = workRe.data();
+    float* zi = workIm.data();
+
+    // Pack even/odd samples as one complex sequence, in bit-reversed order
+    for (int i = 0; i < half; i++) {
+        int j = bitReverse[i];
+        zr[j] = in[2 * i];
+        zi[j] = in[2 * i + 1];
+    }
+
+    // Iterative radix-2 butterflies; the inner loop is contiguous per stage
+    for (int len = 2; len <= half; len <<= 1) {
+        const int step = half / len;
+        const int span = len / 2;
+        for (int start = 0; start < half; start += len) {
+            float* ar = zr + start;
+            float* ai = zi + start;
+            float* br = ar + span;
+            float* bi = ai + span;
+            for (int k = 0; k < span; k++) {
+                float wr = twiddleRe[k * step];
+                float wi = twiddleIm[k * step];
+                float tr = br[k] * wr - bi[k] * wi;
+                float ti = br[k] * wi + bi[k] * wr;
+                br[k] = ar[k] - tr;
+                bi[k] = ai[k] - ti;
+                ar[k] += tr;
+                ai[k] += ti;
+            }
+        }
+    }
+
+    // Split the packed transform into the spectrum of the real input
+    for (int k = 0; k <= half; k++) {
+        int a = k % half;
+        int b = (half - k) % half;
+        float zkr = zr[a], zki = zi[a];
+        float zcr = zr[b], zci = zi[b];
+
+        float evenRe = 0.5f * (zkr + zcr);
+        float evenIm = 0.5f * (zki - zci);
+        float oddRe = 0.5f * (zki + zci);
+        float oddIm = 0.5f * (zcr - zkr);
+
+        float c = unpackRe[k];
+        float s = unpackIm[k];
+        re[k] = evenRe + c * oddRe + s * oddIm;
+        im[k] = evenIm + c * oddIm - s * oddRe;
+    }
+}
+
+bool SpectrumAnalyzer::parseWindow(const std::string& name, WindowType* type) {
+    if (name == "hann") *type = WINDOW_HANN;
+    else if (name == "hamming") *type = WINDOW_HAMMING;
+    else if (name == "blackman") *type = WINDOW_BLACKMAN;
+    else if (name == "rectangular") *type = WINDOW_RECTANGULAR;
+    else return false;
+    return true;
+}
+
+bool SpectrumAnalyzer::init(const Options& options, int numChannels, int rate) {
+    if (numChannels <= 0 || rate <= 0) return false;
+    if (options.hopSize <= 0 || options.hopSize > options.fftSize || options.bands < 0) return false;
+    if (!fft.init(options.fftSize)) return false;
+
+    opts = options;
+    channels = numChannels;
+    sampleRate = rate;
+
+    const int size = opts.fftSize;
+    window.resize(size);
+    double sum = 0.0;
+    for (int i = 0; i < size; i++) {
+        double x = 2.0 * M_PI * i / size;
+        double w;
+        switch (opts.window) {
+            case WINDOW_HAMMING:     w = 0.54 - 0.46 * std::cos(x); break;
+            case WINDOW_BLACKMAN:    w = 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x); break;
+            case WINDOW_RECTANGULAR: w = 1.0; break;
+            case WINDOW_HANN:
+            default:                 w = 0.5 - 0.5 * std::cos(x); break;
+        }
+        window[i] = static_cast<float>(w);
+        sum += w;
+    }
+    // A full-scale sine lands at 1.0 (0 dB) in its bin
+    binScale = static_cast<float>(2.0 / sum);
+
+    const int bins = size / 2 + 1;
+    frameBuf.resize(size);
+    binRe.resize(bins);
+    binIm.resize(bins);
+    power.resize(bins);
+
+    bandStart.clear();
+    bandEnd.clear();
+    bandCenter.clear();
+    if (opts.bands > 0) {
+        const double nyquist = rate / 2.0;
+        double fmax = opts.maxFrequency > 0.0 ? std::min(opts.maxFrequency, nyquist) : nyquist;
+        double fmin = std::max(opts.minFrequency, 1.0);
+        if (fmin >= fmax) return false;
+
+        const double binHz = static_cast<double>(rate) / size;
+        const double ratio = std::log(fmax / fmin) / opts.bands;
+        for (int b = 0; b < opts.bands; b++) {
+            double lo = fmin * std::exp(ratio * b);
+            double hi = fmin * std::exp(ratio * (b + 1));
+            int start = static_cast<int>(std::ceil(lo / binHz));
+            int end = static_cast<int>(std::ceil(hi / binHz));
+
+            // Bands narrower than a bin fall back to the nearest bin
+            if (end <= start) {
+                start = std::min(bins - 1, static_cast<int>(std::lround(std::sqrt(lo * hi) / binHz)));
+                end = start + 1;
+            }
+            bandStart.push_back(std::min(start, bins - 1));
+            bandEnd.push_back(std::min(end, bins));
+            bandCenter.push_back(static_cast<float>(std::sqrt(lo * hi)));
+        }
+    }
+
+    reset();
+    return true;
+}
+
+void SpectrumAnalyzer::reset() {
+    fifo.clear();
+    fifoStart = 0;
+}
+
+std::vector<float> SpectrumAnalyzer::frequencies() const {
+    if (opts.bands > 0) return bandCenter;
+
+    std::vector<float> freqs(opts.fftSize / 2 + 1);
+    for (size_t k = 0; k < freqs.size(); k++) {
+        freqs[k] = static_cast<float>(static_cast<double>(k) * sampleRate / opts.fftSize);
+    }
+    return freqs;
+}
+
+void SpectrumAnalyzer::computeFrame(const float* input, std::vector<float>& out) {
+    const int size = opts.fftSize;
+    for (int i = 0; i < size; i++) {
+        frameBuf[i] = input[i] * window[i];
+    }
+
+    fft.forward(frameBuf.data(), binRe.data(), binIm.data());
+
+    const int bins = size / 2 + 1;
+    for (int k = 0; k < bins; k++) {
+        float scale = (k == 0 || k == bins - 1) ? binScale * 0.5f : binScale;
+        float r = binRe[k] * scale;
+        float m = binIm[k] * scale;
+        power[k] = r * r + m * m;
+    }
+
+    const size_t base = out.size();
+    out.resize(base + frameSize());
+    float* dst = out.data() + base;
+
+    if (opts.bands > 0) {
+        for (int b = 0; b < opts.bands; b++) {
+            float sum = 0.0f;
+            for (int k = bandStart[b]; k < bandEnd[b]; k++) sum += power[k];
+            dst[b] = sum / (bandEnd[b] - bandStart[b]);
+        }
+    } else {
+        std::copy(power.begin(), power.end(), dst);
+    }
+
+    const int count = frameSize();
+    if (opts.decibels) {
+        for (int i = 0; i < count; i++) {
+            // 10*log10(power) == 20*log10(magnitude)
+            float db = dst[i] > 0.0f ? 10.0f * std::log10(dst[i]) : opts.floorDb;
+            dst[i] = std::max(db, opts.floorDb);
+        }
+    } else {
+        for (int i = 0; i < count; i++) dst[i] = std::sqrt(dst[i]);
+    }
+}
+
+int SpectrumAnalyzer::process(const float* samples, int frames, std::vector<float>& out) {
+    if (channels <= 0 || !samples || frames <= 0) return 0;
+
+    // Mix down to mono
+    const size_t base = fifo.size();
+    fifo.resize(base + frames);
+    const float gain = 1.0f / channels;
+    for (int i = 0; i < frames; i++) {
+        const float* f = samples + static_cast<size_t>(i) * channels;
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++) sum += f[c];
+        fifo[base + i] = sum * gain;
+    }
+
+    int produced = 0;
+    const size_t size = static_cast<size_t>(opts.fftSize);
+    while (fifo.size() - fifoStart >= size) {
+        computeFrame(fifo.data() + fifoStart, out);
+        fifoStart += opts.hopSize;
+        produced++;
+    }
+
+    // Drop consumed samples once they dominate the buffer
+    if (fifoStart > size) {
+        fifo.erase(fifo.begin(), fifo.begin() + fifoStart);
+        fifoStart = 0;
+    }
+
+    return produced;
+}
+
+bool SpectrumAnalyzer::analyze(FFmpegDecoder& decoder, std::vector<float>& out, int* frameCount) {
+    if (!decoder.isOpen() || decoder.getChannels() != channels) return false;
+
+    int total = 0;
+    std::vector<float> chunk(static_cast<size_t>(READ_CHUNK_FRAMES) * channels);
+    while (true) {
+        int samplesRead = decoder.read(chunk.data(), static_cast<int>(chunk.size()));
+        if (samplesRead <= 0) break;
+        total += process(chunk.data(), samplesRead / channels, out);
+    }
+
+    if (frameCount) *frameCount = total;
+    // A read error also ends the loop; don't report a short spectrogram as complete
+    return !decoder.hasError();
+}
@@ -0,0 +1,107 @@
+#ifndef FFMPEG_SPECTRUM_H
+#define FFMPEG_SPECTRUM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class FFmpegDecoder;
+
+/**
+ * RealFFT - Power-of-two real-input FFT
+ *
+ * Runs an N/2-point radix-2 complex FFT on split real/imaginary arrays
+ * (contiguous butterflies the compiler can vectorize) and unpacks the
+ * result into N/2 + 1 bins.
+ */
+class RealFFT {
+public:
+    bool init(int size);
+    int size() const { return n; }
+
+    // in: n real samples; re/im: n/2 + 1 bins each
+    void forward(const float* in, float* re, float* im);
+
+private:
+    int n = 0;
+    std::vector<int> bitReverse;        // n/2 entries
+    std::vector<float> twiddleRe;       // n/4 entries (complex stage)
+    std::vector<float> twiddleIm;
+    std::vector<float> unpackRe;        // n/2 + 1 entries (real unpack)
+    std::vector<float> unpackIm;
+    std::vector<float> workRe;
+    std::vector<float> workIm;
+};
+
+/**
+ * SpectrumAnalyzer - Streaming STFT with windowing, overlap and optional
+ * log-frequency banding
+ *
+ * Input is interleaved float32 (mixed down to mono); each completed hop
+ * appends one magnitude frame (linear or dB) to the caller's output.
+ */
+class SpectrumAnalyzer {
+public:
+    enum WindowType {
+        WINDOW_HANN,
+        WINDOW_HAMMING,
+        WINDOW_BLACKMAN,
+        WINDOW_RECTANGULAR
+    };
+
+    struct Options {
+        int fftSize = 2048;
+        int hopSize = 512;
+        WindowType window = WINDOW_HANN;
+        int bands = 0;                  // > 0: log-spaced bands instead of linear bins
+        double minFrequency = 20.0;     // Band range (bands > 0 only)
+        double maxFrequency = 0.0;      // 0 = Nyquist
+        bool decibels = true;
+        float floorDb = -120.0f;
+    };
+
+    static bool parseWindow(const std::string& name, WindowType* type);
+
+    bool init(const Options& options, int channels, int sampleRate);
+    void reset();
+
+    // Returns the number of frames appended to out (frameSize() values each)
+    int process(const float* samples, int frames, std::vector<float>& out);
+
+    // Offline: reads the decoder until EOF; false on a decode error
+    bool analyze(FFmpegDecoder& decoder, std::vector<float>& out, int* frameCount);
+
+    int frameSize() const { return opts.bands > 0 ? opts.bands : opts.fftSize / 2 + 1; }
+    const Options& getOptions() const { return opts; }
+    int getSampleRate() const { return sampleRate; }
+    int getChannels() const { return channels; }
+
+    // Center frequency (Hz) of each output value
+    std::vector<float> frequencies() const;
+
+private:
+    void computeFrame(const float* input, std::vector<float>& out);
+
+    Options opts;
+    int channels = 0;
+    int sampleRate = 0;
+
+    RealFFT fft;
+    std::vector<float> window;
+    float binScale = 0.0f;
+
+    std::vector<float> fifo;            // Mono samples awaiting analysis
+    size_t fifoStart = 0;
+
+    std::vector<float> frameBuf;
+    std::vector<float> binRe;
+    std::vector<float> binIm;
+    std::vector<float> power;
+
+    // Log bands: [bandStart[b], bandEnd[b]) bin ranges
+    std::vector<int> bandStart;
+    std::vector<int> bandEnd;
+    std::vector<float> bandCenter;
+};
+
+#endif // FFMPEG_SPECTRUM_H
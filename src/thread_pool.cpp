@@ -0,0 +1,88 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threads)
+    : nextSequence(0)
+    , running(0)
+    , stopping(false)
+{
+    threads = std::max(0, threads);
+    workers.reserve(threads);
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        tasks = std::priority_queue<Task>();
+    }
+    available.notify_all();
+
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+int ThreadPool::defaultSize(int threadsPerTask) {
+    int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    if (hardware <= 0) hardware = 2;
+    return std::max(1, hardware / std::max(1, threadsPerTask));
+}
+
+void ThreadPool::submit(std::function<void()> task, int priority) {
+    if (workers.empty()) {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        tasks.push(Task{ priority, nextSequence++, std::move(task) });
+    }
+    available.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return tasks.empty() && running == 0; });
+}
+
+void ThreadPool::clear() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks = std::priority_queue<Task>();
+    }
+    idle.notify_all();
+}
+
+size_t ThreadPool::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping) return;
+
+            task = std::move(const_cast<Task&>(tasks.top()).run);
+            tasks.pop();
+            running++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running--;
+        }
+        idle.notify_all();
+    }
+}
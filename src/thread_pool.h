@@ -0,0 +1,65 @@
+#ifndef FFMPEG_THREAD_POOL_H
+#define FFMPEG_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * ThreadPool - Fixed set of worker threads with a priority queue
+ *
+ * Higher priority runs first; equal priorities run in submission order.
+ * Pending tasks are discarded on destruction, running ones are joined.
+ * A pool of 0 threads runs each task inline in submit().
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task, int priority = 0);
+
+    // Blocks until the queue is empty and no task is running
+    void wait();
+
+    // Drops queued tasks that have not started
+    void clear();
+
+    int size() const { return static_cast<int>(workers.size()); }
+    size_t pending() const;
+
+    // Pool size that keeps threads * threadsPerTask within the hardware threads
+    static int defaultSize(int threadsPerTask);
+
+private:
+    struct Task {
+        int priority;
+        uint64_t sequence;
+        std::function<void()> run;
+
+        bool operator<(const Task& other) const {
+            if (priority != other.priority) return priority < other.priority;
+            return sequence > other.sequence;
+        }
+    };
+
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::priority_queue<Task> tasks;
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::condition_variable idle;
+    uint64_t nextSequence;
+    int running;
+    bool stopping;
+};
+
+#endif // FFMPEG_THREAD_POOL_H
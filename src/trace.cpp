@@ -0,0 +1,66 @@
+#include "trace.h"
+#include "utils.h"
+
+TraceRing::TraceRing(int capacity) {
+    uint64_t size = 1;
+    while (size < static_cast<uint64_t>(capacity > 0 ? capacity : 1)) size <<= 1;
+    slots.reset(new Slot[size]);
+    mask = size - 1;
+}
+
+void TraceRing::record(const char* name, int64_t start, int64_t duration,
+                       const char* argName, int64_t arg) {
+    uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[index & mask];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.argName.store(argName, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(duration, std::memory_order_relaxed);
+    slot.arg.store(arg, std::memory_order_relaxed);
+    slot.thread.store(currentThread(), std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+void TraceRing::instant(const char* name, const char* argName, int64_t arg) {
+    record(name, monotonicNs(), -1, argName, arg);
+}
+
+std::vector<TraceEvent> TraceRing::snapshot() const {
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t begin = tail.load(std::memory_order_relaxed);
+    if (end - begin > mask + 1) begin = end - (mask + 1);
+
+    std::vector<TraceEvent> events;
+    events.reserve(static_cast<size_t>(end - begin));
+    for (uint64_t index = begin; index < end; index++) {
+        const Slot& slot = slots[index & mask];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before != 2 * index + 2) continue;     // Being written, or already overwritten
+
+        TraceEvent event;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.argName = slot.argName.load(std::memory_order_relaxed);
+        event.start = slot.start.load(std::memory_order_relaxed);
+        event.duration = slot.duration.load(std::memory_order_relaxed);
+        event.arg = slot.arg.load(std::memory_order_relaxed);
+        event.thread = slot.thread.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) continue;
+        events.push_back(event);
+    }
+    return events;
+}
+
+void TraceRing::clear() {
+    tail.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+int TraceRing::currentThread() {
+    static std::atomic<int> nextThread{1};
+    thread_local int thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+    return thread;
+}
@@ -0,0 +1,87 @@
+#ifndef FFMPEG_TRACE_H
+#define FFMPEG_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * One timeline entry. Names must outlive the ring (string literals, or
+ * interned by the caller).
+ */
+struct TraceEvent {
+    const char* name = nullptr;
+    const char* argName = nullptr;  // Optional single argument
+    int64_t start = 0;              // monotonicNs()
+    int64_t duration = 0;           // ns; negative = instant event
+    int64_t arg = 0;
+    int thread = 0;                 // Small per-process thread number
+};
+
+/**
+ * TraceRing - Fixed-size, lock-free ring of the most recent trace events
+ *
+ * Any thread may record; the oldest events are overwritten. Each slot
+ * carries a sequence number so snapshot() can run concurrently with writers
+ * and skips slots that are mid-write or already recycled.
+ */
+class TraceRing {
+public:
+    static const int DEFAULT_CAPACITY = 4096;
+
+    explicit TraceRing(int capacity = DEFAULT_CAPACITY);
+
+    TraceRing(const TraceRing&) = delete;
+    TraceRing& operator=(const TraceRing&) = delete;
+
+    void record(const char* name, int64_t start, int64_t duration,
+                const char* argName = nullptr, int64_t arg = 0);
+    void instant(const char* name, const char* argName = nullptr, int64_t arg = 0);
+
+    // Oldest first
+    std::vector<TraceEvent> snapshot() const;
+    void clear();
+
+    int capacity() const { return static_cast<int>(mask + 1); }
+    size_t memoryUsage() const { return (mask + 1) * sizeof(Slot); }
+    int64_t recorded() const { return head.load(std::memory_order_relaxed); }
+
+    static int currentThread();
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};     // 2*index+1 while writing, 2*index+2 when done
+        std::atomic<const char*> name{nullptr};
+        std::atomic<const char*> argName{nullptr};
+        std::atomic<int64_t> start{0};
+        std::atomic<int64_t> duration{0};
+        std::atomic<int64_t> arg{0};
+        std::atomic<int> thread{0};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask;
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};          // First index kept after clear()
+};
+
+/**
+ * Trace points compile to nothing unless built with FFMPEG_NAPI_TRACE
+ * (node-gyp rebuild --enable_trace=true). ring is a TraceRing pointer; a
+ * null ring records nothing.
+ */
+#ifdef FFMPEG_NAPI_TRACE
+#define FFMPEG_TRACE_ENABLED 1
+#define TRACE_SPAN(ring, name, start, end) \
+    do { if (ring) (ring)->record((name), (start), (end) - (start)); } while (0)
+#define TRACE_SPAN_ARG(ring, name, start, end, argName, arg) \
+    do { if (ring) (ring)->record((name), (start), (end) - (start), (argName), (arg)); } while (0)
+#else
+#define FFMPEG_TRACE_ENABLED 0
+// Unevaluated, so timestamps taken only for tracing don't warn as unused
+#define TRACE_SPAN(ring, name, start, end) ((void)sizeof((start) + (end)))
+#define TRACE_SPAN_ARG(ring, name, start, end, argName, arg) ((void)sizeof((start) + (end) + (arg)))
+#endif
+
+#endif // FFMPEG_TRACE_H
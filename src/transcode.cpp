@@ -0,0 +1,106 @@
+#include "transcode.h"
+#include "decoder.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Frames moved from decoder to encoder per step
+static const int TRANSCODE_CHUNK_FRAMES = 8192;
+
+bool Transcoder::fail(const std::string& message) {
+    error = message;
+    return false;
+}
+
+bool Transcoder::run(const std::string& inputPath, const std::string& outputPath,
+                     const TranscodeOptions& options, JobControl* control) {
+    res = Result();
+    error.clear();
+    cancelled = false;
+
+    JobControl localControl;
+    if (!control) control = &localControl;
+    control->start();
+
+    FFmpegDecoder decoder;
+    DecoderOpenOptions decodeOptions;
+    decodeOptions.analysis = true;
+    if (!decoder.open(inputPath.c_str(), 0, options.decoderThreads, decodeOptions)) {
+        return fail("Failed to open input: " + inputPath);
+    }
+
+    const int inChannels = decoder.getChannels();
+    const double duration = decoder.getDuration();
+
+    EncoderOptions encoderOptions = options.encoder;
+    encoderOptions.sampleRate = options.sampleRate > 0 ? options.sampleRate : decoder.getSampleRate();
+    encoderOptions.channels = options.channels > 0 ? options.channels : inChannels;
+    encoderOptions.inputSampleRate = decoder.getSampleRate();
+    encoderOptions.inputChannels = inChannels;
+
+    if (options.copyMetadata) {
+        // insert() keeps explicitly requested tags
+        std::map<std::string, std::string> tags = decoder.getTags();
+        encoderOptions.metadata.insert(tags.begin(), tags.end());
+    }
+
+    FFmpegEncoder encoder;
+    if (!encoder.open(outputPath.c_str(), encoderOptions)) {
+        return fail("Failed to open output: " + outputPath);
+    }
+
+    const float gain = static_cast<float>(std::pow(10.0, options.gain / 20.0));
+    const bool applyGain = options.gain != 0.0;
+
+    std::vector<float> chunk(static_cast<size_t>(TRANSCODE_CHUNK_FRAMES) * inChannels);
+    int64_t framesDone = 0;
+    bool ok = true;
+
+    while (true) {
+        if (control->isCancelled()) {
+            cancelled = true;
+            error = "Transcode cancelled";
+            ok = false;
+            break;
+        }
+
+        int samplesRead = decoder.read(chunk.data(), static_cast<int>(chunk.size()));
+        if (samplesRead <= 0) {
+            // read() stops at EOF and on errors alike; don't pass a truncated file off as complete
+            if (decoder.hasError()) {
+                ok = fail("Decode error in " + inputPath + ": " + decoder.getLastError().message);
+            }
+            break;
+        }
+
+        if (applyGain) {
+            for (int i = 0; i < samplesRead; i++) chunk[i] *= gain;
+        }
+
+        if (!encoder.write(chunk.data(), samplesRead)) {
+            ok = fail("Encode error: " + outputPath);
+            break;
+        }
+
+        framesDone += samplesRead / inChannels;
+        control->report(static_cast<double>(framesDone) / decoder.getSampleRate(), duration);
+    }
+
+    res.sampleRate = encoder.getSampleRate();
+    res.channels = encoder.getChannels();
+    res.codec = encoder.getCodecName();
+
+    if (!encoder.close() && ok) {
+        ok = fail("Failed to finalize output: " + outputPath);
+    }
+
+    if (!ok) {
+        std::remove(outputPath.c_str());
+        return false;
+    }
+
+    res.duration = static_cast<double>(framesDone) / decoder.getSampleRate();
+    res.elapsed = control->elapsed();
+    control->report(res.duration, duration > 0.0 ? duration : res.duration, true);
+    return true;
+}
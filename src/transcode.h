@@ -0,0 +1,56 @@
+#ifndef FFMPEG_TRANSCODE_H
+#define FFMPEG_TRANSCODE_H
+
+#include "encoder.h"
+#include "job.h"
+#include <string>
+
+/**
+ * Options for a file-to-file transcode.
+ *
+ * encoder.sampleRate/channels are ignored in favour of sampleRate/channels
+ * here, where 0 keeps the source value.
+ */
+struct TranscodeOptions {
+    EncoderOptions encoder;
+    int sampleRate = 0;
+    int channels = 0;
+    double gain = 0.0;          // dB applied before encoding
+    bool copyMetadata = true;   // Source tags, overridden by encoder.metadata
+    int decoderThreads = 0;
+};
+
+/**
+ * Transcoder - demux -> decode -> gain -> resample -> encode -> mux on the
+ * calling thread
+ *
+ * The decoder runs in analysis mode (native rate/channels, no resampler), so
+ * the encoder's libswresample is the only conversion stage.
+ */
+class Transcoder {
+public:
+    struct Result {
+        double duration = 0.0;      // Seconds encoded
+        double elapsed = 0.0;       // Wall-clock seconds
+        int sampleRate = 0;
+        int channels = 0;
+        std::string codec;
+    };
+
+    // On failure the partial output is removed and getError() says why
+    bool run(const std::string& inputPath, const std::string& outputPath,
+             const TranscodeOptions& options, JobControl* control = nullptr);
+
+    const Result& result() const { return res; }
+    const std::string& getError() const { return error; }
+    bool wasCancelled() const { return cancelled; }
+
+private:
+    bool fail(const std::string& message);
+
+    Result res;
+    std::string error;
+    bool cancelled = false;
+};
+
+#endif // FFMPEG_TRANSCODE_H
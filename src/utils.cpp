@@ -1,8 +1,31 @@
 #include "utils.h"
+#include <cstdio>
 
-// Placeholder for utility functions
-// Can be expanded with helper functions for:
-// - Error handling
-// - Logging
-// - Format conversion
-// - etc.
+extern "C" {
+#include <libavutil/error.h>
+}
+
+const char* errorPhaseName(ErrorPhase phase) {
+    switch (phase) {
+        case PHASE_OPEN: return "open";
+        case PHASE_STREAM_INFO: return "streamInfo";
+        case PHASE_CODEC: return "codec";
+        case PHASE_RESAMPLER: return "resampler";
+        case PHASE_DEMUX: return "demux";
+        case PHASE_DECODE: return "decode";
+        case PHASE_RESAMPLE: return "resample";
+        case PHASE_CONVERT: return "convert";
+        case PHASE_SEEK: return "seek";
+        default: return "none";
+    }
+}
+
+std::string errorString(int code, const char* context) {
+    char reason[AV_ERROR_MAX_STRING_SIZE] = {0};
+    if (av_strerror(code, reason, sizeof(reason)) < 0) {
+        snprintf(reason, sizeof(reason), "Error %d", code);
+    }
+
+    if (!context) return reason;
+    return std::string(context) + ": " + reason;
+}
@@ -2,6 +2,56 @@
 #define FFMPEG_UTILS_H
 
 // Utility functions for FFmpeg NAPI interface
-// Placeholder for future utility implementations
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * Where in the decode pipeline an error happened.
+ */
+enum ErrorPhase {
+    PHASE_NONE,
+    PHASE_OPEN,         // Opening the input / probing the container
+    PHASE_STREAM_INFO,
+    PHASE_CODEC,        // Finding or opening the decoder
+    PHASE_RESAMPLER,    // Setting up libswresample
+    PHASE_DEMUX,        // av_read_frame
+    PHASE_DECODE,       // avcodec_send_packet / avcodec_receive_frame
+    PHASE_RESAMPLE,     // swr_convert
+    PHASE_CONVERT,      // Analysis-mode sample conversion
+    PHASE_SEEK
+};
+
+const char* errorPhaseName(ErrorPhase phase);
+
+/**
+ * A failure with its AVERROR code (negative), the phase it happened in and a
+ * readable message. code 0 means no error.
+ */
+struct DecoderError {
+    int code = 0;
+    ErrorPhase phase = PHASE_NONE;
+    std::string message;
+
+    bool isSet() const { return code != 0; }
+};
+
+// av_strerror() as a std::string, prefixed with context ("context: reason")
+std::string errorString(int code, const char* context = nullptr);
+
+// Monotonic clock for latency measurements
+inline int64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Lock-free running maximum
+inline void atomicMax(std::atomic<int64_t>& target, int64_t value) {
+    int64_t current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
 
 #endif // FFMPEG_UTILS_H
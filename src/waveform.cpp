@@ -0,0 +1,316 @@
+#include "waveform.h"
+#include "decoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+const int PeakPyramid::DEFAULT_LEVELS[] = { 256, 1024, 4096, 16384, 65536 };
+const int PeakPyramid::DEFAULT_LEVEL_COUNT = sizeof(DEFAULT_LEVELS) / sizeof(DEFAULT_LEVELS[0]);
+
+// Frames pulled from the decoder per read() while building
+static const int READ_CHUNK_FRAMES = 16384;
+
+// Peaks file layout (little-endian):
+//   "FPKS" | u16 version | u16 channels | u32 sampleRate | u64 totalFrames | u32 levelCount
+//   per level: u32 samplesPerBucket | u32 bucketCount | bucketCount * channels * (s16 min, s16 max, s16 rms)
+static const uint8_t PEAKS_MAGIC[4] = { 'F', 'P', 'K', 'S' };
+static const uint16_t PEAKS_VERSION = 1;
+
+static void put16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v & 0xFF));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+static void put32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>((v >> (i * 8)) & 0xFF));
+}
+
+static void put64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>((v >> (i * 8)) & 0xFF));
+}
+
+static uint16_t get16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static uint64_t get64(const uint8_t* p) {
+    return static_cast<uint64_t>(get32(p)) | (static_cast<uint64_t>(get32(p + 4)) << 32);
+}
+
+static int16_t quantize(float v) {
+    float clamped = std::max(-1.0f, std::min(1.0f, v));
+    return static_cast<int16_t>(std::lround(clamped * 32767.0f));
+}
+
+std::vector<uint8_t> PeakData::serialize() const {
+    std::vector<uint8_t> out;
+
+    size_t payload = 0;
+    for (const Level& level : levels) {
+        payload += 8 + static_cast<size_t>(level.bucketCount) * channels * 6;
+    }
+    out.reserve(24 + payload);
+
+    out.insert(out.end(), PEAKS_MAGIC, PEAKS_MAGIC + 4);
+    put16(out, PEAKS_VERSION);
+    put16(out, static_cast<uint16_t>(channels));
+    put32(out, static_cast<uint32_t>(sampleRate));
+    put64(out, static_cast<uint64_t>(totalFrames));
+    put32(out, static_cast<uint32_t>(levels.size()));
+
+    for (const Level& level : levels) {
+        put32(out, static_cast<uint32_t>(level.samplesPerBucket));
+        put32(out, static_cast<uint32_t>(level.bucketCount));
+
+        size_t count = static_cast<size_t>(level.bucketCount) * channels;
+        for (size_t i = 0; i < count; i++) {
+            put16(out, static_cast<uint16_t>(quantize(level.min[i])));
+            put16(out, static_cast<uint16_t>(quantize(level.max[i])));
+            put16(out, static_cast<uint16_t>(quantize(level.rms[i])));
+        }
+    }
+
+    return out;
+}
+
+bool PeakData::deserialize(const uint8_t* data, size_t size) {
+    if (!data || size < 24 || memcmp(data, PEAKS_MAGIC, 4) != 0) return false;
+    if (get16(data + 4) != PEAKS_VERSION) return false;
+
+    int fileChannels = get16(data + 6);
+    if (fileChannels <= 0 || fileChannels > PeakData::MAX_CHANNELS) return false;
+
+    // Each level needs at least its 8-byte header; reject counts the data can't hold
+    uint32_t levelCount = get32(data + 20);
+    if (levelCount > (size - 24) / 8) return false;
+
+    std::vector<Level> fileLevels(levelCount);
+    size_t pos = 24;
+
+    for (Level& level : fileLevels) {
+        if (size - pos < 8) return false;
+        level.samplesPerBucket = static_cast<int>(get32(data + pos));
+        uint32_t buckets = get32(data + pos + 4);
+        pos += 8;
+
+        size_t count = static_cast<size_t>(buckets) * fileChannels;
+        if ((size - pos) / 6 < count) return false;
+
+        level.bucketCount = static_cast<int>(buckets);
+        level.min.resize(count);
+        level.max.resize(count);
+        level.rms.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            level.min[i] = static_cast<int16_t>(get16(data + pos)) / 32767.0f;
+            level.max[i] = static_cast<int16_t>(get16(data + pos + 2)) / 32767.0f;
+            level.rms[i] = static_cast<int16_t>(get16(data + pos + 4)) / 32767.0f;
+            pos += 6;
+        }
+    }
+
+    channels = fileChannels;
+    sampleRate = static_cast<int>(get32(data + 8));
+    totalFrames = static_cast<int64_t>(get64(data + 12));
+    levels.swap(fileLevels);
+    return true;
+}
+
+bool PeakPyramid::validLevels(const std::vector<int>& samplesPerBucket) {
+    if (samplesPerBucket.empty()) return false;
+
+    for (size_t i = 0; i < samplesPerBucket.size(); i++) {
+        if (samplesPerBucket[i] <= 0) return false;
+        if (i > 0) {
+            int prev = samplesPerBucket[i - 1];
+            if (samplesPerBucket[i] <= prev || samplesPerBucket[i] % prev != 0) return false;
+        }
+    }
+    return true;
+}
+
+bool PeakPyramid::init(const std::vector<int>& samplesPerBucket, int channels, int sampleRate) {
+    if (!validLevels(samplesPerBucket) || channels <= 0 || channels > PeakData::MAX_CHANNELS) return false;
+
+    peaks = PeakData();
+    peaks.channels = channels;
+    peaks.sampleRate = sampleRate;
+    peaks.levels.resize(samplesPerBucket.size());
+    for (size_t i = 0; i < samplesPerBucket.size(); i++) {
+        peaks.levels[i].samplesPerBucket = samplesPerBucket[i];
+    }
+
+    accumulators.assign(samplesPerBucket.size(), Accumulator());
+    for (Accumulator& acc : accumulators) {
+        acc.min.resize(channels);
+        acc.max.resize(channels);
+        acc.sumSq.resize(channels);
+        resetAccumulator(acc);
+    }
+    return true;
+}
+
+void PeakPyramid::resetAccumulator(Accumulator& acc) {
+    std::fill(acc.min.begin(), acc.min.end(), std::numeric_limits<float>::max());
+    std::fill(acc.max.begin(), acc.max.end(), -std::numeric_limits<float>::max());
+    std::fill(acc.sumSq.begin(), acc.sumSq.end(), 0.0);
+    acc.frames = 0;
+    acc.sampled = 0;
+}
+
+void PeakPyramid::emitBucket(size_t level) {
+    Accumulator& acc = accumulators[level];
+    PeakData::Level& out = peaks.levels[level];
+    const int channels = peaks.channels;
+
+    if (acc.sampled == 0) {
+        // Bucket fell entirely inside a gap: hold the previous bucket (or silence)
+        size_t prev = out.min.size();
+        for (int c = 0; c < channels; c++) {
+            float lo = prev ? out.min[prev - channels + c] : 0.0f;
+            float hi = prev ? out.max[prev - channels + c] : 0.0f;
+            out.min.push_back(lo);
+            out.max.push_back(hi);
+            out.rms.push_back(prev ? out.rms[prev - channels + c] : 0.0f);
+            acc.min[c] = lo;
+            acc.max[c] = hi;
+        }
+    } else {
+        for (int c = 0; c < channels; c++) {
+            out.min.push_back(acc.min[c]);
+            out.max.push_back(acc.max[c]);
+            out.rms.push_back(static_cast<float>(std::sqrt(acc.sumSq[c] / static_cast<double>(acc.sampled))));
+        }
+    }
+    out.bucketCount++;
+
+    // Merge the finished bucket into the next coarser level
+    if (level + 1 < accumulators.size()) {
+        Accumulator& parent = accumulators[level + 1];
+        for (int c = 0; c < channels; c++) {
+            parent.min[c] = std::min(parent.min[c], acc.min[c]);
+            parent.max[c] = std::max(parent.max[c], acc.max[c]);
+            parent.sumSq[c] += acc.sumSq[c];
+        }
+        parent.frames += acc.frames;
+        parent.sampled += acc.sampled;
+        resetAccumulator(acc);
+
+        if (parent.frames >= peaks.levels[level + 1].samplesPerBucket) {
+            emitBucket(level + 1);
+        }
+        return;
+    }
+
+    resetAccumulator(acc);
+}
+
+void PeakPyramid::process(const float* samples, int frames) {
+    if (accumulators.empty() || !samples || frames <= 0) return;
+
+    const int channels = peaks.channels;
+    const int64_t bucketFrames = peaks.levels[0].samplesPerBucket;
+    Accumulator& acc = accumulators[0];
+
+    int offset = 0;
+    while (offset < frames) {
+        int take = static_cast<int>(std::min<int64_t>(bucketFrames - acc.frames, frames - offset));
+        const float* p = samples + static_cast<size_t>(offset) * channels;
+
+        for (int c = 0; c < channels; c++) {
+            float lo = acc.min[c];
+            float hi = acc.max[c];
+            float sq = 0.0f;
+            for (int i = 0; i < take; i++) {
+                float v = p[static_cast<size_t>(i) * channels + c];
+                lo = std::min(lo, v);
+                hi = std::max(hi, v);
+                sq += v * v;
+            }
+            acc.min[c] = lo;
+            acc.max[c] = hi;
+            acc.sumSq[c] += sq;
+        }
+
+        acc.frames += take;
+        acc.sampled += take;
+        peaks.totalFrames += take;
+        offset += take;
+
+        if (acc.frames >= bucketFrames) {
+            emitBucket(0);
+        }
+    }
+}
+
+void PeakPyramid::processAt(int64_t startFrame, const float* samples, int frames) {
+    if (accumulators.empty() || !samples || frames <= 0) return;
+
+    // Overlap with data already consumed (timestamp jitter): drop it
+    if (startFrame < peaks.totalFrames) {
+        int64_t overlap = peaks.totalFrames - startFrame;
+        if (overlap >= frames) return;
+        samples += overlap * peaks.channels;
+        frames -= static_cast<int>(overlap);
+    }
+
+    // Gap: advance bucket boundaries without contributing samples
+    int64_t gap = startFrame - peaks.totalFrames;
+    const int64_t bucketFrames = peaks.levels[0].samplesPerBucket;
+    Accumulator& acc = accumulators[0];
+    while (gap > 0) {
+        int64_t take = std::min(bucketFrames - acc.frames, gap);
+        acc.frames += take;
+        peaks.totalFrames += take;
+        gap -= take;
+
+        if (acc.frames >= bucketFrames) {
+            emitBucket(0);
+        }
+    }
+
+    process(samples, frames);
+}
+
+void PeakPyramid::finish() {
+    // Flush partial buckets from the finest level up so each one lands in its parent
+    for (size_t level = 0; level < accumulators.size(); level++) {
+        if (accumulators[level].frames > 0) {
+            emitBucket(level);
+        }
+    }
+}
+
+bool PeakPyramid::build(FFmpegDecoder& decoder) {
+    if (!decoder.isOpen() || accumulators.empty()) return false;
+    if (decoder.getChannels() != peaks.channels) return false;
+
+    std::vector<float> chunk(static_cast<size_t>(READ_CHUNK_FRAMES) * peaks.channels);
+
+    if (decoder.getOpenOptions().packetStride > 1) {
+        int64_t startFrame = 0;
+        while (true) {
+            int samplesRead = decoder.readBlock(chunk.data(), static_cast<int>(chunk.size()), &startFrame);
+            if (samplesRead <= 0) break;
+            processAt(startFrame, chunk.data(), samplesRead / peaks.channels);
+        }
+
+        finish();
+        return !decoder.hasError();
+    }
+
+    while (true) {
+        int samplesRead = decoder.read(chunk.data(), static_cast<int>(chunk.size()));
+        if (samplesRead <= 0) break;
+        process(chunk.data(), samplesRead / peaks.channels);
+    }
+
+    // A read error also ends the loop; the pyramid is then truncated
+    finish();
+    return !decoder.hasError();
+}
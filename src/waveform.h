@@ -0,0 +1,85 @@
+#ifndef FFMPEG_WAVEFORM_H
+#define FFMPEG_WAVEFORM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class FFmpegDecoder;
+
+/**
+ * PeakData - Multi-resolution waveform overview (min/max/RMS per bucket)
+ *
+ * Each level stores bucketCount * channels values per array, interleaved by
+ * channel (same layout as the decoder output). Levels are ordered from the
+ * finest to the coarsest resolution.
+ */
+struct PeakData {
+    static const int MAX_CHANNELS = 64;
+
+    struct Level {
+        int samplesPerBucket = 0;   // Frames per bucket
+        int bucketCount = 0;
+        std::vector<float> min;
+        std::vector<float> max;
+        std::vector<float> rms;
+    };
+
+    int channels = 0;
+    int sampleRate = 0;
+    int64_t totalFrames = 0;
+    std::vector<Level> levels;
+
+    // Compact binary peaks file (16-bit quantized min/max/rms)
+    std::vector<uint8_t> serialize() const;
+    bool deserialize(const uint8_t* data, size_t size);
+};
+
+/**
+ * PeakPyramid - Builds PeakData in a single pass over interleaved float samples
+ *
+ * Level 0 is accumulated directly from samples; every coarser level is built by
+ * merging completed buckets of the level below (mipmap), so each level must be a
+ * whole multiple of the previous one.
+ */
+class PeakPyramid {
+public:
+    static const int DEFAULT_LEVELS[];
+    static const int DEFAULT_LEVEL_COUNT;
+
+    // Returns false if levels are empty, non-positive or not ascending multiples
+    static bool validLevels(const std::vector<int>& samplesPerBucket);
+
+    bool init(const std::vector<int>& samplesPerBucket, int channels, int sampleRate);
+    void process(const float* samples, int frames);
+
+    // Positioned input: frames missing before startFrame are treated as a gap
+    // (buckets that receive no samples repeat the previous bucket), overlap is dropped
+    void processAt(int64_t startFrame, const float* samples, int frames);
+    void finish();
+
+    // Reads the decoder until EOF and finishes the pyramid. Decoders opened with
+    // a packet stride are read block-wise so skipped packets stay in place.
+    // False on a decode error.
+    bool build(FFmpegDecoder& decoder);
+
+    const PeakData& data() const { return peaks; }
+    PeakData& data() { return peaks; }
+
+private:
+    struct Accumulator {
+        std::vector<float> min;
+        std::vector<float> max;
+        std::vector<double> sumSq;
+        int64_t frames = 0;         // Frames covered (including gaps)
+        int64_t sampled = 0;        // Frames that actually contributed samples
+    };
+
+    void resetAccumulator(Accumulator& acc);
+    void emitBucket(size_t level);
+
+    PeakData peaks;
+    std::vector<Accumulator> accumulators;
+};
+
+#endif // FFMPEG_WAVEFORM_H